@@ -0,0 +1,137 @@
+// ActionBuffer: TTL-bounded hold queue, outcome history and the /action/queue endpoint.
+// ActionBuffer：带 TTL 的暂存队列、结局记录与 /action/queue 接口。
+#include "ActionBuffer.h"
+#include "InputArbiter.h"
+#include "EventStream.h"
+#include <ArduinoJson.h>
+
+static const char* const kTypeNames[] = {
+    "unknown", "click", "swipe", "type_text", "key", "trace", "long_press", "path", "drag", "fling",
+};
+
+static const char* typeName(ActionType type) {
+    int i = (int)type;
+    return i < (int)(sizeof(kTypeNames) / sizeof(kTypeNames[0])) ? kTypeNames[i] : "unknown";
+}
+
+void ActionBuffer::begin(WebServer* srv, InputArbiter* arbiter, EventStream* events) {
+    _server = srv;
+    _arbiter = arbiter;
+    _events = events;
+    if (_server) _server->on("/action/queue", HTTP_GET, [this]() { handleGet(); });
+}
+
+const char* ActionBuffer::outcomeName(BufferedOutcome outcome) {
+    switch (outcome) {
+    case BufferedOutcome::Ok:      return "ok";
+    case BufferedOutcome::Partial: return "partial";
+    case BufferedOutcome::Expired: return "expired";
+    default:                       return "failed";
+    }
+}
+
+uint32_t ActionBuffer::push(const ParsedAction& act, int64_t arrivedUs) {
+    if (_count >= ACTION_BUFFER_SLOTS) {
+        _rejectedFull++;
+        return 0;
+    }
+    BufferedAction& b = _items[_count++];
+    b.id = _nextId++;
+    if (_nextId == 0) _nextId = 1; // 0 表示“已满” / 0 means "full"
+    b.act = act;
+    b.heldAt = millis();
+    b.ttlMs = act.ttlMs >= 0 ? (uint32_t)min(act.ttlMs, (long)ACTION_BUFFER_MAX_TTL_MS) : ACTION_BUFFER_DEFAULT_TTL_MS;
+    b.arrivedUs = arrivedUs;
+    _lastTtlMs = b.ttlMs;
+    _held++;
+    // EN: Held actions are manual requests already: auto-swipe must not slip in ahead of them.
+    // 中文: 暂存的动作已是手动请求：自动上划不得抢在它们之前。
+    if (_arbiter) _arbiter->enqueueManual();
+    return b.id;
+}
+
+void ActionBuffer::removeAt(int i) {
+    for (int j = i + 1; j < _count; j++) _items[j - 1] = _items[j];
+    _count--;
+}
+
+void ActionBuffer::expire() {
+    unsigned long now = millis();
+    for (int i = 0; i < _count;) {
+        const BufferedAction& b = _items[i];
+        if (now - b.heldAt < b.ttlMs) {
+            i++;
+            continue;
+        }
+        BufferedResult r;
+        r.id = b.id;
+        r.outcome = BufferedOutcome::Expired;
+        r.heldMs = now - b.heldAt;
+        removeAt(i);
+        if (_arbiter) _arbiter->cancelManual();
+        record(r);
+    }
+}
+
+void ActionBuffer::pop(const BufferedResult& result) {
+    if (_count == 0) return;
+    removeAt(0);
+    record(result);
+}
+
+void ActionBuffer::record(const BufferedResult& result) {
+    switch (result.outcome) {
+    case BufferedOutcome::Ok:      _forwarded++; break;
+    case BufferedOutcome::Partial: _partial++; break;
+    case BufferedOutcome::Expired: _expired++; break;
+    default:                       _failed++; break;
+    }
+    _recent[_recentNext] = result;
+    _recentNext = (_recentNext + 1) % kRecent;
+    if (_recentCount < kRecent) _recentCount++;
+    if (_events) {
+        _events->publishf("action_result", "{\"id\":%lu,\"status\":\"%s\",\"failed_step\":%d,\"held_ms\":%lu}",
+                          (unsigned long)result.id, outcomeName(result.outcome), result.failedStep,
+                          (unsigned long)result.heldMs);
+    }
+}
+
+// HTTP GET /action/queue: occupancy, counters, held items (oldest first) and recent outcomes (newest first)
+void ActionBuffer::handleGet() {
+    expire();
+    StaticJsonDocument<2048> doc;
+    doc["capacity"] = ACTION_BUFFER_SLOTS;
+    doc["depth"] = _count;
+    doc["held"] = _held;
+    doc["forwarded"] = _forwarded;
+    doc["partial"] = _partial;
+    doc["expired"] = _expired;
+    doc["failed"] = _failed;
+    doc["rejected_full"] = _rejectedFull;
+
+    unsigned long now = millis();
+    JsonArray items = doc.createNestedArray("items");
+    for (int i = 0; i < _count; i++) {
+        const BufferedAction& b = _items[i];
+        JsonObject o = items.createNestedObject();
+        o["id"] = b.id;
+        o["type"] = typeName(b.act.type);
+        o["age_ms"] = now - b.heldAt;
+        o["ttl_left_ms"] = b.ttlMs - (now - b.heldAt);
+    }
+
+    JsonArray recent = doc.createNestedArray("recent");
+    for (int i = 0; i < _recentCount; i++) {
+        const BufferedResult& r = _recent[(_recentNext - 1 - i + kRecent) % kRecent];
+        JsonObject o = recent.createNestedObject();
+        o["id"] = r.id;
+        o["status"] = outcomeName(r.outcome);
+        o["held_ms"] = r.heldMs;
+        o["reports"] = r.reports;
+        if (r.failedStep >= 0) o["failed_step"] = r.failedStep;
+    }
+
+    String out;
+    serializeJson(doc, out);
+    _server->send(200, "application/json", out);
+}
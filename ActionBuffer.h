@@ -0,0 +1,90 @@
+#ifndef ACTIONBUFFER_H
+#define ACTIONBUFFER_H
+
+// ActionBuffer: opt-in store-and-forward of /action requests while BLE is down, with a per-action TTL.
+// ActionBuffer：蓝牙断开期间按需暂存 /action 请求（每条带 TTL），重连后按序转发。
+#include <Arduino.h>
+#include <WebServer.h>
+#include "Config.h"
+#include "ActionParser.h"
+
+class InputArbiter;
+class EventStream;
+
+// 一条暂存的动作 / One held action
+struct BufferedAction {
+    uint32_t id = 0;
+    ParsedAction act;
+    unsigned long heldAt = 0;  // 入队时刻 millis() / millis() when held
+    uint32_t ttlMs = 0;
+    int64_t arrivedUs = 0;     // 请求到达（仲裁等待从此起算）/ request arrival (arbiter wait starts here)
+};
+
+// 暂存动作的结局 / How a held action ended
+enum class BufferedOutcome : uint8_t { Ok = 0, Partial, Expired, Failed };
+
+struct BufferedResult {
+    uint32_t id = 0;
+    BufferedOutcome outcome = BufferedOutcome::Ok;
+    int16_t failedStep = -1;   // Partial 时第一个未发出的报告序号 / first unsent report when Partial
+    uint16_t reports = 0;
+    uint32_t heldMs = 0;       // 在缓冲中等待的时长 / time spent in the buffer
+};
+
+class ActionBuffer {
+public:
+    static const int kRecent = 8;
+
+    // 注册 GET /action/queue；暂存项计入仲裁的待处理手动请求 / Register GET /action/queue; held items count as pending manual requests
+    void begin(WebServer* srv, InputArbiter* arbiter, EventStream* events);
+
+    /**
+     * @brief Holds `act` at the tail with its ttl_ms (default ACTION_BUFFER_DEFAULT_TTL_MS, capped at ACTION_BUFFER_MAX_TTL_MS).
+     * @brief 以其 ttl_ms（默认 ACTION_BUFFER_DEFAULT_TTL_MS，上限 ACTION_BUFFER_MAX_TTL_MS）放入队尾。
+     * @return Action id, or 0 when the buffer is full. / 动作 id；缓冲已满时返回 0。
+     */
+    uint32_t push(const ParsedAction& act, int64_t arrivedUs);
+
+    // 丢弃所有已过期项（不要求位于队首）/ Drop every expired item (not only at the head)
+    void expire();
+
+    // 最早的暂存项，空时为 nullptr / Oldest held item, nullptr when empty
+    BufferedAction* head() { return _count ? &_items[0] : nullptr; }
+
+    // 移除队首并记录其结局 / Remove the head and record how it ended
+    void pop(const BufferedResult& result);
+
+    bool empty() const { return _count == 0; }
+    int depth() const { return _count; }
+    uint32_t lastTtlMs() const { return _lastTtlMs; }
+
+    static const char* outcomeName(BufferedOutcome outcome);
+
+private:
+    WebServer* _server = nullptr;
+    InputArbiter* _arbiter = nullptr;
+    EventStream* _events = nullptr;
+
+    // 按到达顺序排列；容量很小，删除时直接前移 / In arrival order; capacity is small, so removal just shifts
+    BufferedAction _items[ACTION_BUFFER_SLOTS];
+    int _count = 0;
+    uint32_t _nextId = 1;
+    uint32_t _lastTtlMs = 0;
+
+    BufferedResult _recent[kRecent];
+    int _recentNext = 0;
+    int _recentCount = 0;
+
+    uint32_t _held = 0;
+    uint32_t _forwarded = 0;
+    uint32_t _partial = 0;
+    uint32_t _expired = 0;
+    uint32_t _failed = 0;
+    uint32_t _rejectedFull = 0;
+
+    void removeAt(int i);
+    void record(const BufferedResult& result);
+    void handleGet();
+};
+
+#endif
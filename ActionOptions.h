@@ -0,0 +1,49 @@
+#ifndef ACTIONOPTIONS_H
+#define ACTIONOPTIONS_H
+
+// ActionOptions: plain motion/typing parameters shared by BleDriver and ActionParser (no BLE or Arduino deps).
+// ActionOptions：BleDriver 与 ActionParser 共用的动作/打字参数（不依赖蓝牙与 Arduino）。
+
+// 定义全量参数结构体 (默认值仅作兜底)
+// EN: Full option struct for all motion parameters (defaults are just fallbacks)
+struct ActionOptions {
+    // 屏幕参数
+    // EN: Screen parameters
+    int screenW = 1080;
+    int screenH = 2248;
+    int rotation = 0;       // 应用画面旋转角 0/90/180/270（横屏应用）
+    // EN: App frame rotation 0/90/180/270 (landscape apps)
+    
+    // 时间参数 (单位: ms)
+    // EN: Time parameters (ms)
+    int delayHover = 20;    // 移动到位置后，按下前的悬停时间
+    // EN: Hover time before press after moving to target
+    int delayPress = 20;    // 按下后，开始滑动/抬起前的等待时间
+    // EN: Delay after press before swipe/release
+    int delayInterval = 10; // 滑动过程中每一步的间隔 (控制平滑度)
+    // EN: Interval between swipe steps (controls smoothness)
+    int delayRelease = 20;  // 抬起后的冷却时间
+    // EN: Cooldown after release
+    int delayMultiClickInterval = 30; // 多次点击之间的间隔
+    // EN: Gap between multi-click presses
+    int delayDoubleCheck = 20; // 防止断触的二次抬起延迟
+    // EN: Extra delay before second release to avoid ghost touches
+
+    // 算法参数
+    // EN: Algorithm parameters
+    int curveStrength = 15; // 贝塞尔曲线弯曲程度 (百分比 0-100)
+    // EN: Bézier curve bending strength (0-100%)
+};
+
+// 折线/样条手势的最大途经点数 / Max waypoints of a polyline/spline gesture
+static const int GESTURE_MAX_WAYPOINTS = 16;
+
+// 文本输入参数 / Text entry options
+struct TypeOptions {
+    int keyIntervalMs = 20;  // 批与批之间的间隔 / gap between batches
+    int keyHoldMs = 8;       // 按下到抬起 / key down to key up
+    int jitterPercent = 20;  // 间隔随机波动 / interval jitter (%)
+    int batch = 1;           // 每批连续发送的字符数 / characters sent back to back per batch
+};
+
+#endif
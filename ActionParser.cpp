@@ -0,0 +1,145 @@
+// ActionParser: key dispatch for /action bodies; no String temporaries, no heap.
+// ActionParser：/action 请求体的键分发；不产生 String 临时对象，不使用堆。
+#include "ActionParser.h"
+#include <Arduino.h>
+#include <string.h>
+
+ActionType parseActionType(const char* type) {
+    if (!type) return ActionType::Unknown;
+    if (strcmp(type, "click") == 0) return ActionType::Click;
+    if (strcmp(type, "swipe") == 0) return ActionType::Swipe;
+    if (strcmp(type, "type_text") == 0) return ActionType::TypeText;
+    if (strcmp(type, "key") == 0) return ActionType::Key;
+    if (strcmp(type, "trace") == 0) return ActionType::Trace;
+    if (strcmp(type, "long_press") == 0) return ActionType::LongPress;
+    if (strcmp(type, "path") == 0) return ActionType::Path;
+    if (strcmp(type, "drag") == 0) return ActionType::Drag;
+    if (strcmp(type, "fling") == 0) return ActionType::Fling;
+    return ActionType::Unknown;
+}
+
+// 途经点数组：元素可为 [x, y] 或 {"x": .., "y": ..} / Waypoint array: elements are [x, y] or {"x": .., "y": ..}
+static void parseWaypoints(JsonArrayConst arr, ParsedAction& out) {
+    out.waypoints = 0;
+    for (JsonVariantConst p : arr) {
+        if (out.waypoints == GESTURE_MAX_WAYPOINTS) {
+            out.tooManyWaypoints = true;
+            return;
+        }
+        int x, y;
+        if (p.is<JsonArrayConst>()) {
+            x = p[0].as<int>();
+            y = p[1].as<int>();
+        } else {
+            x = p["x"].as<int>();
+            y = p["y"].as<int>();
+        }
+        out.wpX[out.waypoints] = (int16_t)constrain(x, -32768, 32767);
+        out.wpY[out.waypoints] = (int16_t)constrain(y, -32768, 32767);
+        out.waypoints++;
+    }
+}
+
+bool parseAction(JsonObjectConst obj, ParsedAction& out) {
+    if (obj.isNull()) return false;
+    bool haveMultiInterval = false; // EN: "multi_interval" wins over the long alias. / 中文: "multi_interval" 优先于长名称。
+
+    for (JsonPairConst kv : obj) {
+        const char* k = kv.key().c_str();
+        JsonVariantConst v = kv.value();
+
+        // EN: Switch on the first character so each key costs at most a handful of strcmp calls.
+        // 中文: 先按首字母分支，每个键最多只需少量 strcmp。
+        switch (k[0]) {
+        case 't':
+            if (strcmp(k, "type") == 0) out.type = parseActionType(v.as<const char*>());
+            else if (strcmp(k, "text") == 0) {
+                const char* t = v.as<const char*>();
+                if (t) {
+                    size_t len = strlen(t);
+                    out.textTooLong = len > ACTION_TEXT_MAX;
+                    memcpy(out.text, t, min(len, ACTION_TEXT_MAX));
+                    out.text[min(len, ACTION_TEXT_MAX)] = '\0';
+                }
+            }
+            else if (strcmp(k, "ttl_ms") == 0) out.ttlMs = v.as<long>();
+            break;
+        case 'k':
+            if (strcmp(k, "key") == 0) {
+                const char* name = v.as<const char*>();
+                if (name) strlcpy(out.keyName, name, sizeof(out.keyName));
+            }
+            else if (strcmp(k, "keycode") == 0) out.keycode = v.as<int>();
+            else if (strcmp(k, "key_interval") == 0) out.typeOpts.keyIntervalMs = v.as<int>();
+            else if (strcmp(k, "key_hold") == 0) out.typeOpts.keyHoldMs = v.as<int>();
+            else if (strcmp(k, "key_jitter") == 0) out.typeOpts.jitterPercent = v.as<int>();
+            break;
+        case 'b':
+            if (strcmp(k, "batch") == 0) out.typeOpts.batch = v.as<int>();
+            else if (strcmp(k, "buffer") == 0) out.buffer = v.as<bool>();
+            break;
+        case 'h':
+            if (strcmp(k, "hold_ms") == 0) out.holdMs = v.as<int>();
+            break;
+        case 'n':
+            if (strcmp(k, "name") == 0) {
+                const char* name = v.as<const char*>();
+                if (name) strlcpy(out.traceName, name, sizeof(out.traceName));
+            }
+            break;
+        case 'x':
+            if (strcmp(k, "x") == 0) out.x = v.as<int>();
+            else if (strcmp(k, "x1") == 0) out.x1 = v.as<int>();
+            else if (strcmp(k, "x2") == 0) out.x2 = v.as<int>();
+            break;
+        case 'y':
+            if (strcmp(k, "y") == 0) out.y = v.as<int>();
+            else if (strcmp(k, "y1") == 0) out.y1 = v.as<int>();
+            else if (strcmp(k, "y2") == 0) out.y2 = v.as<int>();
+            break;
+        case 'c':
+            if (strcmp(k, "count") == 0) out.count = max(1, v.as<int>());
+            else if (strcmp(k, "curve_strength") == 0) out.opts.curveStrength = v.as<int>();
+            break;
+        case 'p':
+            if (strcmp(k, "points") == 0) parseWaypoints(v.as<JsonArrayConst>(), out);
+            break;
+        case 'a':
+            if (strcmp(k, "at") == 0) {
+                out.hasAt = true;
+                out.atMs = v.as<long long>();
+            }
+            break;
+        case 's':
+            if (strcmp(k, "screen_w") == 0) out.opts.screenW = v.as<int>();
+            else if (strcmp(k, "screen_h") == 0) out.opts.screenH = v.as<int>();
+            else if (strcmp(k, "spline") == 0) out.spline = v.as<bool>();
+            break;
+        case 'r':
+            if (strcmp(k, "rotation") == 0) out.opts.rotation = v.as<int>();
+            break;
+        case 'm':
+            if (strcmp(k, "multi_interval") == 0) {
+                out.opts.delayMultiClickInterval = v.as<int>();
+                haveMultiInterval = true;
+            }
+            else if (strcmp(k, "modifiers") == 0) out.modifiers = v.as<int>();
+            break;
+        case 'd':
+            if (strcmp(k, "duration") == 0) out.duration = v.as<int>();
+            else if (strcmp(k, "delay_hover") == 0) out.opts.delayHover = v.as<int>();
+            else if (strcmp(k, "delay_press") == 0) out.opts.delayPress = v.as<int>();
+            else if (strcmp(k, "delay_interval") == 0) out.opts.delayInterval = v.as<int>();
+            else if (strcmp(k, "delay_release") == 0) out.opts.delayRelease = v.as<int>();
+            else if (strcmp(k, "delay_multi_click_interval") == 0) {
+                if (!haveMultiInterval) out.opts.delayMultiClickInterval = v.as<int>();
+            }
+            else if (strcmp(k, "double_check") == 0) out.opts.delayDoubleCheck = v.as<int>();
+            else if (strcmp(k, "drop_hold_ms") == 0) out.dropHoldMs = v.as<int>();
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,93 @@
+#ifndef ACTIONPARSER_H
+#define ACTIONPARSER_H
+
+// ActionParser: single-pass, allocation-free decoding of /action JSON into a typed struct.
+// ActionParser：单次遍历、无堆分配地把 /action JSON 解码为强类型结构体。
+#include <ArduinoJson.h>
+#include "ActionOptions.h"
+
+// 动作类型（用枚举分发，避免字符串比较）/ Action type (dispatch on enum instead of strings)
+enum class ActionType : uint8_t {
+    Unknown = 0,
+    Click,
+    Swipe,
+    TypeText,
+    Key,
+    Trace,
+    LongPress,
+    Path,
+    Drag,
+    Fling,
+};
+
+// type_text 文本上限（UTF-8 字节）/ type_text limit (UTF-8 bytes)
+static const size_t ACTION_TEXT_MAX = 256;
+
+// 解析后的动作 / Decoded action
+struct ParsedAction {
+    ActionType type = ActionType::Unknown;
+    ActionOptions opts;
+
+    // click
+    int x = 0;
+    int y = 0;
+    int count = 1;
+
+    // swipe
+    int x1 = 0;
+    int y1 = 0;
+    int x2 = 0;
+    int y2 = 0;
+    int duration = 0;
+
+    // type_text：文本拷贝到这里，不依赖 JSON 文档的生命周期 / text is copied here, independent of the JSON document
+    char text[ACTION_TEXT_MAX + 1] = {0};
+    bool textTooLong = false;
+    TypeOptions typeOpts;
+
+    // key：按名称或键码 / by name or keycode
+    char keyName[16] = {0};
+    int keycode = -1;
+    int modifiers = 0;
+    // 按住时长：key 默认 40，long_press 默认 800，path/drag 为抬手前的拾取停留；-1 = 按类型默认
+    // EN: Hold: key defaults to 40, long_press to 800, path/drag uses it as the pickup hold; -1 = per-type default
+    int holdMs = -1;
+
+    // trace：轨迹名（空 = 随机），起止点复用 x1..y2，duration 为 0 时保持录制时长
+    // EN: trace: trace name (empty = random); reuses x1..y2, duration 0 keeps the recorded timing
+    char traceName[12] = {0};
+
+    // path/drag：途经点（[[x,y],...] 或 [{"x","y"},...]），spline 为 Catmull-Rom，drop_hold_ms 为终点按住时长
+    // EN: path/drag: waypoints ([[x,y],...] or [{"x","y"},...]); spline selects Catmull-Rom; drop_hold_ms holds at the end
+    int16_t wpX[GESTURE_MAX_WAYPOINTS];
+    int16_t wpY[GESTURE_MAX_WAYPOINTS];
+    uint8_t waypoints = 0;
+    bool tooManyWaypoints = false;
+    bool spline = false;
+    int dropHoldMs = -1;
+
+    // 定时执行（同步后的 Unix 毫秒）/ scheduled start (synced Unix ms)
+    bool hasAt = false;
+    long long atMs = 0;
+
+    // 蓝牙断开时暂存，重连后按序执行；ttl_ms 内未执行则丢弃，-1 = 默认 TTL
+    // EN: Hold while BLE is down and run in order on reconnect; dropped if not run within ttl_ms, -1 = default TTL
+    bool buffer = false;
+    long ttlMs = -1;
+};
+
+/**
+ * @brief Maps the "type" string to ActionType.
+ * @brief 将 "type" 字符串映射为 ActionType。
+ */
+ActionType parseActionType(const char* type);
+
+/**
+ * @brief Fills `out` (including ActionOptions) in one pass over the object's members.
+ * @brief 对对象成员单次遍历，填充 `out`（包括 ActionOptions）。
+ * @return False if the root is not an object.
+ * @return 根节点不是对象时返回 false。
+ */
+bool parseAction(JsonObjectConst obj, ParsedAction& out);
+
+#endif
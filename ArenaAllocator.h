@@ -0,0 +1,78 @@
+#ifndef ARENAALLOCATOR_H
+#define ARENAALLOCATOR_H
+
+// ArenaAllocator: fixed-buffer bump allocator for ArduinoJson, reused between requests.
+// ArenaAllocator：供 ArduinoJson 使用的定长缓冲递增分配器，在请求之间复用。
+#include <ArduinoJson.h>
+#include <string.h>
+
+/**
+ * @class ArenaAllocator
+ * @brief Serves every JsonDocument allocation from one preallocated buffer; reset() frees all at once.
+ * @brief 所有 JsonDocument 分配均来自同一块预分配缓冲；reset() 一次性全部释放。
+ *
+ * EN: deallocate() is a no-op; reallocate() grows/shrinks in place when the block is the most recent
+ * EN: one, which is the pattern ArduinoJson uses for strings and slot pools during deserialization.
+ * 中文: deallocate() 不做任何事；若块是最近一次分配，reallocate() 原地扩展/收缩，
+ * 中文: 这正是 ArduinoJson 反序列化时字符串与槽池的使用方式。
+ */
+template <size_t N>
+class ArenaAllocator : public ArduinoJson::Allocator {
+public:
+    void* allocate(size_t size) override {
+        size_t start = align(_used);
+        if (start + size > N) {
+            _failed = true;
+            return nullptr;
+        }
+        _last = start;
+        _used = start + size;
+        if (_used > _peak) _peak = _used;
+        return _buf + start;
+    }
+
+    void deallocate(void*) override {}
+
+    void* reallocate(void* ptr, size_t newSize) override {
+        if (ptr == nullptr) return allocate(newSize);
+        size_t offset = (uint8_t*)ptr - _buf;
+        if (offset == _last) {
+            if (_last + newSize > N) {
+                _failed = true;
+                return nullptr;
+            }
+            _used = _last + newSize;
+            if (_used > _peak) _peak = _used;
+            return ptr;
+        }
+        // EN: Not the latest block: copy into a fresh one (old bytes are reclaimed on reset()).
+        // 中文: 非最近一次分配：拷贝到新块（旧空间在 reset() 时回收）。
+        size_t oldSize = _used - offset;
+        void* fresh = allocate(newSize);
+        if (fresh) memcpy(fresh, ptr, oldSize < newSize ? oldSize : newSize);
+        return fresh;
+    }
+
+    // 清空整个 arena（文档销毁之后调用）/ Drop everything (call once the document is gone)
+    void reset() {
+        _used = 0;
+        _last = 0;
+        _failed = false;
+    }
+
+    size_t used() const { return _used; }
+    size_t peak() const { return _peak; }
+    bool failed() const { return _failed; }
+    static constexpr size_t capacity() { return N; }
+
+private:
+    alignas(8) uint8_t _buf[N];
+    size_t _used = 0;
+    size_t _last = 0;
+    size_t _peak = 0;
+    bool _failed = false;
+
+    static size_t align(size_t n) { return (n + 7) & ~(size_t)7; }
+};
+
+#endif
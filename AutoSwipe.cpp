@@ -1,6 +1,7 @@
 // AutoSwipe: implementation of auto swipe configuration, endpoints, and scheduler.
 // Provides: config load/save, HTML/JSON handlers, and randomized swipe execution.
 #include "AutoSwipe.h"
+#include "EventLog.h"
 
 // Clamp integer to [minVal, maxVal]
 int AutoSwipeManager::clampInt(int val, int minVal, int maxVal) {
@@ -29,6 +30,14 @@ void AutoSwipeManager::normalizeConfig() {
     cfg.doubleTapIntervalJitterPercent = clampInt(cfg.doubleTapIntervalJitterPercent, 0, 200);
     if (cfg.doubleTapEdgeMinMs < 100) cfg.doubleTapEdgeMinMs = 100;
     if (cfg.doubleTapEdgeMaxMs < cfg.doubleTapEdgeMinMs + 50) cfg.doubleTapEdgeMaxMs = cfg.doubleTapEdgeMinMs + 50;
+    cfg.linkBurstLeadMs = clampInt(cfg.linkBurstLeadMs, 100, 5000);
+    cfg.mixSwipeUp = clampInt(cfg.mixSwipeUp, 0, 1000);
+    cfg.mixSwipeBack = clampInt(cfg.mixSwipeBack, 0, 1000);
+    cfg.mixLike = clampInt(cfg.mixLike, 0, 1000);
+    cfg.mixLongDwell = clampInt(cfg.mixLongDwell, 0, 1000);
+    cfg.mixShortSkip = clampInt(cfg.mixShortSkip, 0, 1000);
+    // 全部为 0 时退回纯上划 / All zero: fall back to plain swipe-up
+    if (cfg.mixSwipeUp + cfg.mixSwipeBack + cfg.mixLike + cfg.mixLongDwell + cfg.mixShortSkip == 0) cfg.mixSwipeUp = 100;
 }
 
 // Apply JSON fields (only English keys) into config
@@ -63,6 +72,14 @@ void AutoSwipeManager::applyJsonToConfig(JsonDocument& doc, AutoSwipeConfig& c)
     if (doc.containsKey("double_tap_interval_jitter_percent")) c.doubleTapIntervalJitterPercent = doc["double_tap_interval_jitter_percent"];
     if (doc.containsKey("double_tap_edge_min_ms")) c.doubleTapEdgeMinMs = doc["double_tap_edge_min_ms"];
     if (doc.containsKey("double_tap_edge_max_ms")) c.doubleTapEdgeMaxMs = doc["double_tap_edge_max_ms"];
+    if (doc.containsKey("run_offline")) c.runOffline = doc["run_offline"];
+    if (doc.containsKey("link_burst")) c.linkBurst = doc["link_burst"];
+    if (doc.containsKey("link_burst_lead_ms")) c.linkBurstLeadMs = doc["link_burst_lead_ms"];
+    if (doc.containsKey("mix_swipe_up")) c.mixSwipeUp = doc["mix_swipe_up"];
+    if (doc.containsKey("mix_swipe_back")) c.mixSwipeBack = doc["mix_swipe_back"];
+    if (doc.containsKey("mix_like")) c.mixLike = doc["mix_like"];
+    if (doc.containsKey("mix_long_dwell")) c.mixLongDwell = doc["mix_long_dwell"];
+    if (doc.containsKey("mix_short_skip")) c.mixShortSkip = doc["mix_short_skip"];
 }
 
 // Load config from NVS (with defaults if missing/invalid)
@@ -109,6 +126,14 @@ void AutoSwipeManager::saveConfig(const AutoSwipeConfig& c) {
     doc["double_tap_interval_jitter_percent"] = c.doubleTapIntervalJitterPercent;
     doc["double_tap_edge_min_ms"] = c.doubleTapEdgeMinMs;
     doc["double_tap_edge_max_ms"] = c.doubleTapEdgeMaxMs;
+    doc["run_offline"] = c.runOffline;
+    doc["link_burst"] = c.linkBurst;
+    doc["link_burst_lead_ms"] = c.linkBurstLeadMs;
+    doc["mix_swipe_up"] = c.mixSwipeUp;
+    doc["mix_swipe_back"] = c.mixSwipeBack;
+    doc["mix_like"] = c.mixLike;
+    doc["mix_long_dwell"] = c.mixLongDwell;
+    doc["mix_short_skip"] = c.mixShortSkip;
 
     String out;
     serializeJson(doc, out);
@@ -144,6 +169,10 @@ String AutoSwipeManager::renderPage(const AutoSwipeConfig& c, const String& mess
             "<label>开机自动运行 / Auto start when WiFi+BLE OK"
             "<input type='checkbox' name='enabled' value='1' ";
     if (c.enabled) html += "checked";
+    html += "></label>"
+            "<label>断网时继续运行（只需蓝牙）/ Keep running while Wi-Fi is down"
+            "<input type='checkbox' name='run_offline' value='1' ";
+    if (c.runOffline) html += "checked";
     html += "></label></fieldset>";
 
     html += "<fieldset><legend>区域与屏幕 / Area & Screen</legend>"
@@ -161,6 +190,11 @@ String AutoSwipeManager::renderPage(const AutoSwipeConfig& c, const String& mess
             "<div class='col'><label>上划间隔最大(秒) / Max interval(s)<input type='number' name='interval_max_sec' value='" + String(c.intervalMaxSec) + "'></label></div></div>"
             "<label>时长波动百分比(%) / Duration jitter<input type='number' name='duration_jitter_percent' value='" + String(c.durationJitterPercent) + "'></label>"
             "<label>轨迹步进(ms) / Step interval<input type='number' name='delay_interval' value='" + String(c.delayInterval) + "'></label>"
+            "<label>动作前切换 7.5ms 低延迟链路 / Low-latency link burst"
+            "<input type='checkbox' name='link_burst' value='1' ";
+    if (c.linkBurst) html += "checked";
+    html += "></label>"
+            "<label>低延迟提前量(ms) / Burst lead time<input type='number' name='link_burst_lead_ms' value='" + String(c.linkBurstLeadMs) + "'></label>"
             "</fieldset>";
 
     html += "<fieldset><legend>长度与随机 / Length & Randomness</legend>"
@@ -192,6 +226,15 @@ String AutoSwipeManager::renderPage(const AutoSwipeConfig& c, const String& mess
             "</label>"
             "</fieldset>";
 
+    html += "<fieldset><legend>行为组合 / Behavior Mix</legend>"
+            "<div class='row'><div class='col'><label>上划 / Swipe up<input type='number' name='mix_swipe_up' value='" + String(c.mixSwipeUp) + "'></label></div>"
+            "<div class='col'><label>下划返回 / Swipe back<input type='number' name='mix_swipe_back' value='" + String(c.mixSwipeBack) + "'></label></div></div>"
+            "<div class='row'><div class='col'><label>额外点赞 / Like<input type='number' name='mix_like' value='" + String(c.mixLike) + "'></label></div>"
+            "<div class='col'><label>长停留 / Long dwell<input type='number' name='mix_long_dwell' value='" + String(c.mixLongDwell) + "'></label></div></div>"
+            "<label>快速跳过 / Short skip<input type='number' name='mix_short_skip' value='" + String(c.mixShortSkip) + "'></label>"
+            "<small>相对权重，0 表示关闭；提前计划接下来 8 个动作。</small>"
+            "</fieldset>";
+
     html += "<button type='submit'>保存 / Save</button>"
             "</form>"
             "<form method='POST' action='/auto_swipe/reset_ble'>"
@@ -205,12 +248,20 @@ String AutoSwipeManager::renderPage(const AutoSwipeConfig& c, const String& mess
 // HTTP GET handler for the HTML form
 void AutoSwipeManager::handleGet() {
     if (ble) ble->pulseRx(80);
+    if (sysMon && !sysMon->admit()) {
+        sysMon->rejectLowMemory();
+        return;
+    }
     server->send(200, "text/html", renderPage(cfg));
 }
 
 // HTTP POST handler for form/JSON save
 void AutoSwipeManager::handlePost() {
     if (ble) ble->pulseRx(80);
+    if (sysMon && !sysMon->admit()) {
+        sysMon->rejectLowMemory();
+        return;
+    }
     AutoSwipeConfig newCfg = cfg;
     bool isJson = server->hasArg("plain") && server->header("Content-Type").indexOf("application/json") >= 0;
     bool parsed = false;
@@ -240,6 +291,14 @@ void AutoSwipeManager::handlePost() {
         if (server->hasArg("curve_strength")) newCfg.curveStrength = server->arg("curve_strength").toInt();
         if (server->hasArg("double_check")) newCfg.doubleCheck = server->arg("double_check").toInt();
         newCfg.doubleTapEnabled = server->hasArg("double_tap_enabled");
+        newCfg.runOffline = server->hasArg("run_offline");
+        newCfg.linkBurst = server->hasArg("link_burst");
+        if (server->hasArg("link_burst_lead_ms")) newCfg.linkBurstLeadMs = server->arg("link_burst_lead_ms").toInt();
+        if (server->hasArg("mix_swipe_up")) newCfg.mixSwipeUp = server->arg("mix_swipe_up").toInt();
+        if (server->hasArg("mix_swipe_back")) newCfg.mixSwipeBack = server->arg("mix_swipe_back").toInt();
+        if (server->hasArg("mix_like")) newCfg.mixLike = server->arg("mix_like").toInt();
+        if (server->hasArg("mix_long_dwell")) newCfg.mixLongDwell = server->arg("mix_long_dwell").toInt();
+        if (server->hasArg("mix_short_skip")) newCfg.mixShortSkip = server->arg("mix_short_skip").toInt();
         if (server->hasArg("double_tap_prob_percent")) newCfg.doubleTapProbPercent = server->arg("double_tap_prob_percent").toInt();
         if (server->hasArg("double_tap_prob_jitter_percent")) newCfg.doubleTapProbJitterPercent = server->arg("double_tap_prob_jitter_percent").toInt();
         if (server->hasArg("double_tap_interval_ms")) newCfg.doubleTapIntervalMs = server->arg("double_tap_interval_ms").toInt();
@@ -263,7 +322,8 @@ void AutoSwipeManager::handlePost() {
     cfg = newCfg;
     normalizeConfig();
     saveConfig(cfg);
-    nextSwipeAt = 0; // 重置计时
+    clearPlan(); // 丢弃按旧配置生成的计划 / drop actions planned with the old config
+    if (events) events->publishf("config", "{\"enabled\":%s}", cfg.enabled ? "true" : "false");
 
     if (isJson) {
         server->send(200, "application/json", "{\"status\":\"ok\",\"note\":\"配置已保存\"}");
@@ -299,10 +359,53 @@ void AutoSwipeManager::handleStatus() {
     doc["double_tap_interval_jitter_percent"] = cfg.doubleTapIntervalJitterPercent;
     doc["double_tap_edge_min_ms"] = cfg.doubleTapEdgeMinMs;
     doc["double_tap_edge_max_ms"] = cfg.doubleTapEdgeMaxMs;
+    doc["run_offline"] = cfg.runOffline;
+    doc["link_burst"] = cfg.linkBurst;
+    doc["link_burst_lead_ms"] = cfg.linkBurstLeadMs;
+    doc["link_fast"] = linkFast;
+    doc["mix_swipe_up"] = cfg.mixSwipeUp;
+    doc["mix_swipe_back"] = cfg.mixSwipeBack;
+    doc["mix_like"] = cfg.mixLike;
+    doc["mix_long_dwell"] = cfg.mixLongDwell;
+    doc["mix_short_skip"] = cfg.mixShortSkip;
+    if (ble) {
+        const BleReconnectStats& rc = ble->reconnectStats();
+        doc["ble_adv_phase"] = BleDriver::advPhaseName(rc.phase);
+        doc["ble_reconnects"] = rc.reconnects;
+        doc["ble_reconnect_ms"] = rc.lastMs;
+        doc["ble_reconnect_via"] = BleDriver::advPhaseName(rc.lastVia);
+    }
     doc["wifi"] = (WiFi.status() == WL_CONNECTED);
     doc["ble"] = ble && ble->isConnected();
-    doc["next_ms"] = nextSwipeAt == 0 ? 0 : (long)(nextSwipeAt - millis());
-    doc["next_like_ms"] = nextLikeAt == 0 ? 0 : (long)(nextLikeAt - millis());
+    if (arbiter) {
+        doc["owner"] = InputArbiter::ownerName(arbiter->owner());
+        doc["quiet_left_ms"] = arbiter->quietLeftMs();
+    }
+
+    // 即将执行的计划：in_ms 为预计开始时刻（未锚定时按现在起算）
+    // EN: Upcoming plan; in_ms is the expected start (counted from now while not anchored)
+    unsigned long now = millis();
+    long at = anchorAt != 0 ? (long)(anchorAt - now) : 0;
+    long nextMs = 0, nextLikeMs = 0;
+    JsonArray arr = doc.createNestedArray("plan");
+    for (int i = 0; i < planCount; i++) {
+        const PlannedAction& a = plan[(planHead + i) % kPlanDepth];
+        at += (long)a.waitMs;
+        long inMs = max(0L, at);
+        if (i == 0) nextMs = inMs;
+        if (a.kind == PlanKind::Like && nextLikeMs == 0) nextLikeMs = inMs;
+        JsonObject o = arr.createNestedObject();
+        o["kind"] = planKindName(a.kind);
+        o["in_ms"] = inMs;
+        o["wait_ms"] = a.waitMs;
+        o["duration_ms"] = a.gesture.durationMs();
+        o["x1"] = a.x1; o["y1"] = a.y1;
+        o["x2"] = a.x2; o["y2"] = a.y2;
+        o["points"] = a.gesture.count;
+        at += (long)a.gesture.durationMs();
+    }
+    doc["next_ms"] = nextMs;
+    doc["next_like_ms"] = nextLikeMs;
 
     String out;
     serializeJson(doc, out);
@@ -335,66 +438,79 @@ unsigned long AutoSwipeManager::randomIntervalMs() {
     return (unsigned long)random(minS, maxS + 1) * 1000UL;
 }
 
-// Schedule next swipe timestamp
-void AutoSwipeManager::scheduleNext() {
-    nextSwipeAt = millis() + randomIntervalMs();
-    scheduleLike();
+const char* AutoSwipeManager::planKindName(PlanKind kind) {
+    switch (kind) {
+    case PlanKind::SwipeUp: return "swipe_up";
+    case PlanKind::SwipeBack: return "swipe_back";
+    case PlanKind::Like: return "like";
+    case PlanKind::LongDwell: return "long_dwell";
+    case PlanKind::ShortSkip: return "short_skip";
+    }
+    return "unknown";
 }
 
-// 计划下一次点赞时刻（在两次滑动之间）
-void AutoSwipeManager::scheduleLike() {
-    nextLikeAt = 0;
-    if (!cfg.doubleTapEnabled || !ble) return;
-    unsigned long now = millis();
-    if (nextSwipeAt <= now) return;
-
-    unsigned long interval = nextSwipeAt - now;
-    int edgeMin = cfg.doubleTapEdgeMinMs;
-    int edgeMax = cfg.doubleTapEdgeMaxMs;
-    // 需要至少前后各留一段缓冲
-    if (interval <= (unsigned long)(edgeMin + edgeMax + 120)) return;
-
-    int prob = cfg.doubleTapProbPercent;
-    int jitter = cfg.doubleTapProbJitterPercent;
-    int delta = (prob * jitter + 50) / 100;
-    prob = clampInt(prob + random(-delta, delta + 1), 0, 100);
-    if (random(0, 100) >= prob) return;
-
-    // 选择靠近上次滑动结束或靠近下一次滑动开始的窗口
-    struct Window { unsigned long a; unsigned long b; };
-    Window win[2];
-    int winCount = 0;
-
-    if (lastSwipeEndedAt > 0) {
-        unsigned long a = lastSwipeEndedAt + edgeMin;
-        unsigned long b = lastSwipeEndedAt + edgeMax;
-        if (b > now + 20) {
-            a = max(a, now + 20);
-            if (a + 20 < b && a < nextSwipeAt - edgeMin) {
-                b = min(b, nextSwipeAt - edgeMin);
-                if (b > a + 20) win[winCount++] = {a, b};
-            }
-        }
+// 按权重抽取下一个行为 / Draw the next behavior from the weighted mix
+PlanKind AutoSwipeManager::pickKind() {
+    const int weights[5] = {cfg.mixSwipeUp, cfg.mixSwipeBack, cfg.mixLike, cfg.mixLongDwell, cfg.mixShortSkip};
+    const PlanKind kinds[5] = {PlanKind::SwipeUp, PlanKind::SwipeBack, PlanKind::Like, PlanKind::LongDwell, PlanKind::ShortSkip};
+    int total = 0;
+    for (int w : weights) total += w;
+    if (total <= 0) return PlanKind::SwipeUp;
+    int r = random(0, total);
+    for (int i = 0; i < 5; i++) {
+        if (r < weights[i]) return kinds[i];
+        r -= weights[i];
     }
+    return PlanKind::SwipeUp;
+}
 
-    {
-        unsigned long a = nextSwipeAt > (unsigned long)edgeMax ? nextSwipeAt - edgeMax : now + 20;
-        unsigned long b = nextSwipeAt - edgeMin;
-        if (b > now + 40 && b > a + 20) {
-            a = max(a, now + 20);
-            if (b > a + 20) win[winCount++] = {a, b};
-        }
+// 行为前的停留时长 / Dwell before the behavior
+unsigned long AutoSwipeManager::waitForKind(PlanKind kind) {
+    int minS = cfg.intervalMinSec;
+    int maxS = max(cfg.intervalMaxSec, minS);
+    switch (kind) {
+    case PlanKind::Like:
+        return (unsigned long)random(cfg.doubleTapEdgeMinMs, cfg.doubleTapEdgeMaxMs + 1);
+    case PlanKind::LongDwell:
+        return (unsigned long)random(maxS, maxS * 2 + 1) * 1000UL;
+    case PlanKind::ShortSkip:
+        return (unsigned long)random(1, minS + 1) * 1000UL;
+    default:
+        return randomIntervalMs();
     }
+}
 
-    if (winCount == 0) return;
-    Window chosen = win[random(0, winCount)];
-    nextLikeAt = random(chosen.a, chosen.b + 1);
+// 取环形缓冲尾部的空位 / Claim the next free slot at the tail of the ring
+PlannedAction& AutoSwipeManager::planSlot() {
+    PlannedAction& a = plan[(planHead + planCount) % kPlanDepth];
+    planCount++;
+    return a;
 }
 
-// 执行一次双击点赞
-void AutoSwipeManager::performLike() {
-    if (!ble || nextLikeAt == 0) return;
+void AutoSwipeManager::clearPlan() {
+    planHead = 0;
+    planCount = 0;
+    anchorAt = 0;
+    headSerial++;
+}
+
+long AutoSwipeManager::nextActionInMs() const {
+    if (planCount == 0 || anchorAt == 0) return -1;
+    long in = (long)(anchorAt + plan[planHead].waitMs - millis());
+    return in < 0 ? 0 : in;
+}
 
+// 队首变化（执行、重排、恢复计时）时推送一次 / Announce the head once whenever it changes (executed, replanned, re-anchored)
+void AutoSwipeManager::announceNext() {
+    if (!events || planCount == 0 || anchorAt == 0 || announcedSerial == headSerial) return;
+    announcedSerial = headSerial;
+    const PlannedAction& a = plan[planHead];
+    events->publishf("next", "{\"kind\":\"%s\",\"in_ms\":%ld,\"duration_ms\":%lu}",
+                     planKindName(a.kind), nextActionInMs(), (unsigned long)a.gesture.durationMs());
+}
+
+// 生成一次双击点赞 / Build one double-tap like
+void AutoSwipeManager::planLike(PlannedAction& a, unsigned long waitMs) {
     auto jitterVal = [this](int base, int pct, int minV, int maxV) {
         int delta = (base * pct + 50) / 100;
         return clampInt(base + random(-delta, delta + 1), minV, maxV);
@@ -420,15 +536,16 @@ void AutoSwipeManager::performLike() {
     opts.delayMultiClickInterval = jitterVal(cfg.doubleTapIntervalMs, cfg.doubleTapIntervalJitterPercent, 20, 1200);
     opts.delayDoubleCheck = jitterVal(cfg.doubleCheck, cfg.delayJitterPercent, 0, 2000);
 
-    ble->click(px, py, 2, opts);
-    nextLikeAt = 0;
+    a.kind = PlanKind::Like;
+    a.waitMs = waitMs;
+    a.x1 = a.x2 = px;
+    a.y1 = a.y2 = py;
+    ble->buildClick(px, py, 2, opts, a.gesture);
 }
 
-// Execute one randomized swipe based on config
-void AutoSwipeManager::performSwipe() {
-    if (!ble) return;
-    swipeInFlight = true;
-
+// 生成一次随机滑动：上划（含长停留/快速跳过）或下划返回
+// EN: Build one randomized swipe: up (also long dwell / short skip) or back down
+void AutoSwipeManager::planSwipe(PlannedAction& a, PlanKind kind, unsigned long waitMs) {
     auto jitterVal = [this](int base, int pct, int minV, int maxV) {
         int delta = (base * pct + 50) / 100;
         return clampInt(base + random(-delta, delta + 1), minV, maxV);
@@ -461,17 +578,24 @@ void AutoSwipeManager::performSwipe() {
     factor = constrain(factor, 0.2f, 1.2f);
     int targetLen = max(8, (int)(boxH * factor));
 
-    // 起点随机落在下半部分，确保方向向上；终点 = 起点向上 targetLen，再抖动
-    int startYMin = minY + targetLen;
-    if (startYMin > maxY) startYMin = maxY;
+    // 上划：起点落在下半部分，终点向上 targetLen；下划返回则反过来
+    // EN: Swipe up starts low and moves up by targetLen; swipe back mirrors it
+    bool back = (kind == PlanKind::SwipeBack);
     int sx = random(minX, maxX + 1);
-    int sy = random(startYMin, maxY + 1);
+    int sy;
+    if (back) {
+        int startYMax = max(minY, maxY - targetLen);
+        sy = random(minY, startYMax + 1);
+    } else {
+        int startYMin = min(maxY, minY + targetLen);
+        sy = random(startYMin, maxY + 1);
+    }
     sx = clampInt(randomAround(sx, jitterX), minX, maxX);
     sy = clampInt(randomAround(sy, jitterY), minY, maxY);
 
     int driftX = clampInt(boxW / 3, 6, 60);
     int ex = clampInt(sx + random(-driftX, driftX + 1), minX, maxX);
-    int ey = clampInt(sy - targetLen, minY, maxY);
+    int ey = clampInt(back ? sy + targetLen : sy - targetLen, minY, maxY);
     ex = clampInt(randomAround(ex, jitterX), minX, maxX);
     ey = clampInt(randomAround(ey, jitterY), minY, maxY);
 
@@ -481,10 +605,67 @@ void AutoSwipeManager::performSwipe() {
     int swing = max(10, (int)(baseDur * cfg.durationJitterPercent / 100.0f));
     int duration = clampInt(baseDur + random(-swing, swing + 1), 80, 2000);
 
-    ble->swipe(sx, sy, ex, ey, duration, opts);
+    a.kind = kind;
+    a.waitMs = waitMs;
+    a.x1 = sx; a.y1 = sy;
+    a.x2 = ex; a.y2 = ey;
+    ble->buildSwipe(sx, sy, ex, ey, duration, opts, a.gesture);
+}
+
+// 向计划尾部追加一个行为（可能连带一次随机点赞）
+// EN: Append one behavior to the plan (possibly preceded by a random like)
+void AutoSwipeManager::planNext() {
+    if (!ble || planCount >= kPlanDepth) return;
 
+    PlanKind kind = pickKind();
+    unsigned long wait = waitForKind(kind);
+    if (kind == PlanKind::Like) {
+        planLike(planSlot(), wait);
+        return;
+    }
+
+    // 原有的随机点赞：在停留窗口内靠近开头或结尾插入一次双击
+    // EN: Legacy random like: insert a double tap near the start or the end of the dwell window
+    int edgeMin = cfg.doubleTapEdgeMinMs;
+    int edgeMax = cfg.doubleTapEdgeMaxMs;
+    if (cfg.doubleTapEnabled && planCount <= kPlanDepth - 2 &&
+        wait > (unsigned long)(edgeMin + edgeMax + 120)) {
+        int prob = cfg.doubleTapProbPercent;
+        int jitter = cfg.doubleTapProbJitterPercent;
+        int delta = (prob * jitter + 50) / 100;
+        prob = clampInt(prob + random(-delta, delta + 1), 0, 100);
+        if (random(0, 100) < prob) {
+            unsigned long edge = (unsigned long)random(edgeMin, edgeMax + 1);
+            unsigned long likeAt = random(0, 2) == 0 ? edge : wait - edge;
+            PlannedAction& like = planSlot();
+            planLike(like, likeAt);
+            unsigned long used = likeAt + like.gesture.durationMs();
+            wait = wait > used + edgeMin ? wait - used : (unsigned long)edgeMin;
+        }
+    }
+
+    planSwipe(planSlot(), kind, wait);
+}
+
+// 回放队首动作：只发送已生成的报告 / Play the head action: only sends prebuilt reports
+void AutoSwipeManager::executeHead() {
+    PlannedAction& a = plan[planHead];
+    LOG_EV(AutoAction, (int32_t)a.kind, (int32_t)(millis() - anchorAt));
+    if (events) events->publishf("action_start", "{\"kind\":\"%s\"}", planKindName(a.kind));
+    swipeInFlight = true;
+    ble->play(a.gesture);
     swipeInFlight = false;
-    lastSwipeEndedAt = millis();
+    if (events) {
+        const GestureTiming& t = ble->lastTiming();
+        events->publishf("action_done", "{\"kind\":\"%s\",\"actual_us\":%lu,\"overrun_us\":%ld}",
+                         planKindName(a.kind), (unsigned long)t.actualUs, (long)t.overrunUs);
+    }
+
+    planHead = (planHead + 1) % kPlanDepth;
+    planCount--;
+    headSerial++;
+    anchorAt = millis();
+    if (anchorAt == 0) anchorAt = 1;
 }
 
 // Init manager: load config and register routes
@@ -502,31 +683,76 @@ void AutoSwipeManager::begin(WebServer* srv, BleDriver* bleDriver) {
 }
 
 // Periodic scheduler tick, also checks WiFi/BLE readiness
+// Request the low-latency preset, or go back to the power preset
+void AutoSwipeManager::setLinkFast(bool fast) {
+    if (!ble || linkFast == fast) return;
+    BleLinkParams p;
+    BleDriver::linkPreset(fast ? "low_latency" : "power", p);
+    if (ble->requestLink(p)) linkFast = fast;
+}
+
 void AutoSwipeManager::tick() {
     if (!cfg.enabled) {
-        nextSwipeAt = 0;
-        nextLikeAt = 0;
+        clearPlan();
+        setLinkFast(false);
         return;
     }
 
-    if (WiFi.status() != WL_CONNECTED || !ble || !ble->isConnected()) {
-        nextSwipeAt = 0;
-        nextLikeAt = 0;
+    bool wifiOk = cfg.runOffline || WiFi.status() == WL_CONNECTED;
+    if (!wifiOk || !ble || !ble->isConnected()) {
+        if (anchorAt != 0) headSerial++; // 恢复后的时刻会变，需要重新推送 / timing changes on resume, re-announce
+        anchorAt = 0; // 保留计划，恢复后重新计时 / keep the plan, restart timing on resume
+        linkFast = false; // 新连接会使用连接默认参数 / a new link starts from the on-connect params
         return;
     }
 
-    if (nextSwipeAt == 0) {
-        scheduleNext();
-        return;
+    // 手动动作抢占：丢弃旧计划，静默期结束后从头重新排程
+    // EN: A manual action preempted us: drop the old plan and start a fresh schedule once the quiet period ends
+    if (arbiter && arbiter->manualGeneration() != seenManualGen) {
+        seenManualGen = arbiter->manualGeneration();
+        clearPlan();
+        arbiter->noteAutoReplan();
+        setLinkFast(false);
+        if (events) events->publishf("auto_paused", "{\"quiet_ms\":%lu}", arbiter->quietLeftMs());
+    }
+
+    // 校准变化后，计划中已映射的数位板坐标作废：丢弃并重新排程
+    // EN: A calibration change makes the plan's mapped digitizer points stale: drop it and plan afresh
+    if (ble->mappingGeneration() != planMappingGen) {
+        planMappingGen = ble->mappingGeneration();
+        clearPlan();
     }
 
+    // 每次 tick 最多补充一个动作，把计算分摊到空闲循环 / Top up at most one action per tick to spread the math over idle loops
+    if (planCount < kPlanDepth) planNext();
+
+    // 静默期内不计时，结束后的第一个 tick 才锚定 / No timing during the quiet period; the first tick after it anchors
+    if (arbiter && !arbiter->autoMayRun() && anchorAt == 0) return;
+
     unsigned long now = millis();
-    if (!swipeInFlight && nextLikeAt != 0 && now >= nextLikeAt && now + 40 < nextSwipeAt) {
-        performLike();
+    if (anchorAt == 0) {
+        anchorAt = now == 0 ? 1 : now;
+        return;
     }
+    if (planCount == 0) return;
+    announceNext();
+
+    unsigned long dueAt = anchorAt + plan[planHead].waitMs;
 
-    if (!swipeInFlight && now >= nextSwipeAt) {
-        performSwipe();
-        scheduleNext();
+    // 在点赞/上划之前提前切到低延迟链路 / Switch to the low-latency link shortly before a like/swipe
+    if (cfg.linkBurst && !linkFast) {
+        if ((long)(dueAt - now) <= cfg.linkBurstLeadMs) setLinkFast(true);
+    } else if (!cfg.linkBurst && linkFast) {
+        setLinkFast(false);
+    }
+
+    if (!swipeInFlight && (long)(now - dueAt) >= 0) {
+        if (arbiter && !arbiter->tryAcquireAuto(dueAt)) return;
+        executeHead();
+        if (arbiter) arbiter->releaseAuto();
+        // 下一个动作还远：切回省电链路 / Next action is far away: back to the power-friendly link
+        if (linkFast && (planCount == 0 || plan[planHead].waitMs > (unsigned long)cfg.linkBurstLeadMs * 2)) {
+            setLinkFast(false);
+        }
     }
 }
@@ -10,6 +10,9 @@
 #include <math.h>
 
 #include "BleDriver.h"
+#include "SysMonitor.h"
+#include "EventStream.h"
+#include "InputArbiter.h"
 
 // 自动上划配置 / Auto-swipe configuration (defaults act as fallbacks)
 struct AutoSwipeConfig {
@@ -40,22 +43,64 @@ struct AutoSwipeConfig {
     int doubleTapIntervalJitterPercent = 15; // 双击间隔波动 (%)
     int doubleTapEdgeMinMs = 250;         // 距离当前/下次上划的最小安全间隔
     int doubleTapEdgeMaxMs = 800;         // 距离当前/下次上划的最大安全间隔（实际随机取值）
+    bool runOffline = false;              // 断网时继续运行（只需蓝牙）/ keep running while Wi-Fi is down (BLE is enough)
+    // 链路突发：动作前切到 7.5ms 低延迟，上划结束后切回省电参数
+    // Link burst: switch to the 7.5 ms low-latency link before gestures, back to the power preset after the swipe
+    bool linkBurst = false;
+    int linkBurstLeadMs = 400;            // 提前多久请求低延迟 / how early to request low latency
+    // 行为组合权重（相对值，0 关闭）/ Behavior mix weights (relative, 0 disables)
+    int mixSwipeUp = 100;                 // 正常观看后上划 / swipe up after a normal watch
+    int mixSwipeBack = 0;                 // 下划回到上一个 / swipe down back to the previous item
+    int mixLike = 0;                      // 额外的双击点赞 / extra double-tap like
+    int mixLongDwell = 0;                 // 长时间停留后上划 / swipe up after a long watch
+    int mixShortSkip = 0;                 // 快速跳过 / quick skip
+};
+
+// 计划中的行为类型 / Kind of a planned action
+enum class PlanKind : uint8_t { SwipeUp, SwipeBack, Like, LongDwell, ShortSkip };
+
+// 预先计划好的一个动作：等待时长 + 已生成的手势 / One planned action: wait time + prebuilt gesture
+struct PlannedAction {
+    PlanKind kind = PlanKind::SwipeUp;
+    unsigned long waitMs = 0;   // 上一个动作结束后等待多久 / wait after the previous action ends
+    int x1 = 0, y1 = 0, x2 = 0, y2 = 0; // 屏幕像素，仅用于状态展示 / screen pixels, for status only
+    GesturePlan gesture;        // 时长见 gesture.durationMs() / duration is gesture.durationMs()
 };
 
 class AutoSwipeManager {
 public:
     void begin(WebServer* srv, BleDriver* bleDriver);
     void tick();
+    // 页面渲染/保存前的内存准入 / memory admission before page render or save
+    void setSysMonitor(SysMonitor* mon) { sysMon = mon; }
+    // 动作/计划/配置变化推送到 SSE / Push action, plan and config changes to SSE
+    void setEventStream(EventStream* es) { events = es; }
+    // 与手动 /action 协调：手动优先，静默期后重新排程 / Coordinate with manual /action: manual wins, replan after the quiet period
+    void setArbiter(InputArbiter* arb) { arbiter = arb; seenManualGen = arb ? arb->manualGeneration() : 0; }
+    bool isEnabled() const { return cfg.enabled; }
+    // 距下一个动作的毫秒数，未计划时为 -1 / ms until the next action, -1 when nothing is planned
+    long nextActionInMs() const;
 
 private:
     Preferences pref;
     WebServer* server = nullptr;
     BleDriver* ble = nullptr;
+    SysMonitor* sysMon = nullptr;
+    EventStream* events = nullptr;
+    InputArbiter* arbiter = nullptr;
+    uint32_t seenManualGen = 0;           // 已处理过的手动抢占 / manual grants already handled
     AutoSwipeConfig cfg;
-    unsigned long nextSwipeAt = 0;
-    unsigned long nextLikeAt = 0;
-    unsigned long lastSwipeEndedAt = 0;
+    // 前瞻计划环形缓冲 / Lookahead plan ring buffer
+    static const int kPlanDepth = 8;
+    PlannedAction plan[kPlanDepth];
+    int planHead = 0;
+    int planCount = 0;
+    unsigned long anchorAt = 0;           // 上一个动作结束时刻（0 = 未锚定）/ end of the previous action (0 = not anchored)
     bool swipeInFlight = false;
+    uint32_t headSerial = 0;              // 队首每变化一次加一 / bumped whenever the head changes
+    uint32_t announcedSerial = UINT32_MAX; // 已推送过的队首 / head already announced over SSE
+    bool linkFast = false;                // 当前是否处于低延迟链路 / low-latency link currently requested
+    uint32_t planMappingGen = 0;          // 计划生成时的坐标映射版本 / BleDriver mapping generation the plan was built with
 
     // 工具
     int clampInt(int val, int minVal, int maxVal);
@@ -74,10 +119,17 @@ private:
 
     // 业务
     unsigned long randomIntervalMs();
-    void scheduleNext();
-    void scheduleLike();
-    void performLike();
-    void performSwipe();
+    PlanKind pickKind();
+    unsigned long waitForKind(PlanKind kind);
+    PlannedAction& planSlot();
+    void planLike(PlannedAction& a, unsigned long waitMs);
+    void planSwipe(PlannedAction& a, PlanKind kind, unsigned long waitMs);
+    void planNext();
+    void clearPlan();
+    void executeHead();
+    void announceNext();
+    static const char* planKindName(PlanKind kind);
+    void setLinkFast(bool fast);
 };
 
 #endif
@@ -1,5 +1,8 @@
 #include "Config.h"
 #include "BleDriver.h"
+#include "BootTimeline.h"
+#include "EventLog.h"
+#include <Preferences.h>
 
 // LED 引脚：TX=43, RX=44
 static const int PIN_LED_TX = 43;
@@ -7,13 +10,61 @@ static const int PIN_LED_RX = 44;
 static const int LED_ON_LEVEL = LOW;   // 主板上的灯为低电平点亮 / EN: active-low LED on this board
 static const int LED_OFF_LEVEL = HIGH; // 高电平熄灭 / EN: drive HIGH to turn the LED off
 
+// 快速重连窗口：定向 1.5s，之后高占空比广播到 10s，再回到默认间隔
+// EN: Fast reconnect window: 1.5 s directed, high-duty undirected until 10 s, then default intervals
+static const unsigned long RECONNECT_DIRECTED_MS = 1500;
+static const unsigned long RECONNECT_FAST_WINDOW_MS = 10000;
+static const uint16_t FAST_ADV_MIN_ITVL = 0x20; // 20ms (0.625ms 单位 / units)
+static const uint16_t FAST_ADV_MAX_ITVL = 0x30; // 30ms
+
 // Wacom 描述符 (保持不变)
 static const uint8_t hidReportDescriptor[] = {
   0x05, 0x0D, 0x09, 0x02, 0xA1, 0x01, 0x85, 0x01, 0x09, 0x20, 0xA1, 0x00,
   0x09, 0x42, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x01, 0x81, 0x02,
   0x09, 0x44, 0x81, 0x02, 0x09, 0x32, 0x81, 0x02, 0x95, 0x05, 0x81, 0x03,
   0x05, 0x01, 0x09, 0x30, 0x16, 0x00, 0x00, 0x26, 0xFF, 0x7F, 0x75, 0x10, 0x95, 0x01, 0x81, 0x02,
-  0x09, 0x31, 0x81, 0x02, 0xC0, 0xC0
+  0x09, 0x31, 0x81, 0x02, 0xC0, 0xC0,
+
+  // 键盘（报告 ID 2）：修饰键 8 位 + 保留 1 字节 + 6 个键码 / Keyboard (report id 2): 8 modifier bits + reserved byte + 6 keycodes
+  0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x85, 0x02,
+  0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02,
+  0x95, 0x01, 0x75, 0x08, 0x81, 0x01,
+  0x95, 0x06, 0x75, 0x08, 0x15, 0x00, 0x25, 0x65, 0x05, 0x07, 0x19, 0x00, 0x29, 0x65, 0x81, 0x00,
+  0xC0,
+
+  // 消费者控制（报告 ID 3）：一个 16 位用法码 / Consumer control (report id 3): one 16-bit usage
+  0x05, 0x0C, 0x09, 0x01, 0xA1, 0x01, 0x85, 0x03,
+  0x15, 0x00, 0x26, 0xFF, 0x03, 0x19, 0x00, 0x2A, 0xFF, 0x03, 0x75, 0x10, 0x95, 0x01, 0x81, 0x00,
+  0xC0
+};
+
+// 美式键盘 ASCII 0x20-0x7E → 键码，最高位表示需要 Shift / US layout ASCII 0x20-0x7E → keycode, high bit = Shift
+static const uint8_t kAsciiKeys[95] = {
+    0x2C, 0x9E, 0xB4, 0xA0, 0xA1, 0xA2, 0xA4, 0x34, 0xA6, 0xA7, 0xA5, 0xAE,
+    0x36, 0x2D, 0x37, 0x38, 0x27, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24,
+    0x25, 0x26, 0xB3, 0x33, 0xB6, 0x2E, 0xB7, 0xB8, 0x9F, 0x84, 0x85, 0x86,
+    0x87, 0x88, 0x89, 0x8A, 0x8B, 0x8C, 0x8D, 0x8E, 0x8F, 0x90, 0x91, 0x92,
+    0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0x9B, 0x9C, 0x9D, 0x2F,
+    0x31, 0x30, 0xA3, 0xAD, 0x35, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A,
+    0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16,
+    0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D, 0xAF, 0xB1, 0xB0, 0xB5,
+};
+static const uint8_t KEY_MOD_LSHIFT = 0x02;
+
+// 命名按键 / Named keys
+struct NamedKey {
+    const char* name;
+    uint8_t keycode;   // 键盘键码 / keyboard usage
+    uint16_t usage;    // 消费者控制用法码 / consumer usage
+};
+static const NamedKey kNamedKeys[] = {
+    {"enter", 0x28, 0}, {"escape", 0x29, 0}, {"backspace", 0x2A, 0}, {"tab", 0x2B, 0},
+    {"space", 0x2C, 0}, {"delete", 0x4C, 0}, {"right", 0x4F, 0}, {"left", 0x50, 0},
+    {"down", 0x51, 0}, {"up", 0x52, 0}, {"page_up", 0x4B, 0}, {"page_down", 0x4E, 0},
+    {"move_home", 0x4A, 0}, {"move_end", 0x4D, 0},
+    {"back", 0, 0x224}, {"home", 0, 0x223}, {"search", 0, 0x221},
+    {"volume_up", 0, 0xE9}, {"volume_down", 0, 0xEA}, {"mute", 0, 0xE2},
+    {"play_pause", 0, 0xCD}, {"next", 0, 0xB5}, {"previous", 0, 0xB6}, {"stop", 0, 0xB7},
 };
 
 class ConnectionCallbacks : public NimBLEServerCallbacks {
@@ -21,20 +72,32 @@ public:
     explicit ConnectionCallbacks(BleDriver* driver) : _driver(driver) {}
     
     void onConnect(NimBLEServer* pServer) {
-        DEBUG_PRINTLN(">>> [BLE] Connected! <<<");
         digitalWrite(PIN_LED_RX, LED_OFF_LEVEL);
         digitalWrite(PIN_LED_TX, LED_OFF_LEVEL);
-        // 请求极速模式 (降低延迟)
-        // EN: Relax connection parameters to improve compatibility (interval 30ms, timeout 4s).
-        // 中文: 放宽连接参数以提高兼容性 (连接间隔 30ms, 超时 4s)。
-        pServer->updateConnParams(pServer->getPeerInfo(0).getConnHandle(), 24, 24, 0, 400);
+        // EN: Request the per-connection link params (default: interval 30ms, timeout 4s for compatibility).
+        // 中文: 请求每个连接的链路参数（默认：连接间隔 30ms，超时 4s，兼顾兼容性）。
+        _driver->onPeerConnected();
     }
     void onDisconnect(NimBLEServer* pServer) {
-        DEBUG_PRINTLN(">>> [BLE] Disconnected! <<<");
         digitalWrite(PIN_LED_RX, LED_OFF_LEVEL);
         digitalWrite(PIN_LED_TX, LED_OFF_LEVEL);
-        // 断开后立刻重新广播，允许别人连接
-        NimBLEDevice::startAdvertising();
+        // 断开后立刻重新广播：先定向/高占空比，便于已绑定手机快速重连
+        // EN: Re-advertise right away, directed/high-duty first so the bonded phone comes back quickly
+        _driver->onPeerDisconnected();
+    }
+
+private:
+    BleDriver* _driver;
+};
+
+// 输入报告的 notify 结果：1.x 在 notify() 内同步回调 / notify outcome for the input report (synchronous in 1.x)
+class InputReportCallbacks : public NimBLECharacteristicCallbacks {
+public:
+    explicit InputReportCallbacks(BleDriver* driver) : _driver(driver) {}
+
+    void onStatus(NimBLECharacteristic* pCharacteristic, Status s, int code) {
+        if (s == SUCCESS_NOTIFY || s == SUCCESS_INDICATE) _driver->recordNotifyStatus(true, code);
+        else _driver->recordNotifyStatus(false, code);
     }
 
 private:
@@ -43,8 +106,12 @@ private:
 
 void BleDriver::begin(String deviceName) {
     _deviceName = deviceName;
+    if (!_connectParamsLoaded) {
+        loadConnectParams();
+        _connectParamsLoaded = true;
+    }
     _paused = false;
-    DEBUG_PRINTLN("[BLE] Init: " + deviceName);
+    DEBUG_PRINTF("[BLE] Init: %s\n", deviceName.c_str());
     NimBLEDevice::init(deviceName.c_str());
     // 配置通讯指示灯
     pinMode(PIN_LED_TX, OUTPUT);
@@ -72,9 +139,15 @@ void BleDriver::begin(String deviceName) {
     
         NimBLEServer* pServer = NimBLEDevice::createServer();
     pServer->setCallbacks(new ConnectionCallbacks(this));
+    pServer->advertiseOnDisconnect(false); // 由 onPeerDisconnected 接管 / handled by onPeerDisconnected
 
     _hid = new NimBLEHIDDevice(pServer);
     _input = _hid->getInputReport(1);
+    _input->setCallbacks(new InputReportCallbacks(this));
+    _keyboard = _hid->getInputReport(2);
+    _keyboard->setCallbacks(new InputReportCallbacks(this));
+    _consumer = _hid->getInputReport(3);
+    _consumer->setCallbacks(new InputReportCallbacks(this));
     
     _hid->setManufacturer("Espressif");
     _hid->setPnp(0x02, 0xe502, 0xa111, 0x0210);
@@ -100,8 +173,11 @@ void BleDriver::begin(String deviceName) {
     NimBLEAdvertisementData scanData;
     scanData.setName(deviceName.c_str());
     pAdvertising->setScanResponseData(scanData);
+    BootTimeline::mark(BootStage::BleAdvertising);
 
-    pAdvertising->start();
+    // 已有绑定（重启/OTA 后恢复）时同样走快速重连 / With existing bonds (reboot/resume) use the fast path too
+    if (NimBLEDevice::getNumBonds() > 0) startReconnectAdvertising();
+    else pAdvertising->start();
     _hid->setBatteryLevel(100);
 }
 
@@ -113,10 +189,15 @@ bool BleDriver::isConnected() {
 void BleDriver::pause() {
     if (_paused) return;
     DEBUG_PRINTLN("[BLE] Pause for OTA");
+    _paused = true; // 先置位，deinit 触发的断开回调不再重新广播 / set first so the deinit disconnect does not re-advertise
+    _disconnectAt = 0;
+    _reconnect.phase = BleAdvPhase::Idle;
     NimBLEDevice::stopAdvertising();
     NimBLEDevice::deinit(true);
     clearLeds();
     _input = nullptr;
+    _keyboard = nullptr;
+    _consumer = nullptr;
     _hid = nullptr;
     _paused = true;
 }
@@ -136,15 +217,37 @@ void BleDriver::resetPairing() {
     DEBUG_PRINTLN("[BLE] Reset pairing + restart advertising");
     NimBLEDevice::deleteAllBonds();
     clearLeds();
-    NimBLEDevice::startAdvertising();
+    _hasLastPeer = false;
+    _disconnectAt = 0;
+    startAdvertisingPhase(BleAdvPhase::Normal);
 }
 
-long BleDriver::mapVal(int val, int maxPixel) {
-    return map(val, 0, maxPixel, 0, 32767);
+void BleDriver::mapPoint(int x, int y, const ActionOptions& opts, long& tx, long& ty) {
+    uint32_t gen = _calib ? _calib->generation() : 1;
+    if (opts.screenW != _xfW || opts.screenH != _xfH || opts.rotation != _xfRot || gen != _xfGen) {
+        if (_calib) _calib->buildTransform(opts.screenW, opts.screenH, opts.rotation, _xf);
+        else ScreenCalibration::buildLinearTransform(opts.screenW, opts.screenH, opts.rotation, _xf);
+        _xfW = opts.screenW;
+        _xfH = opts.screenH;
+        _xfRot = opts.rotation;
+        _xfGen = gen;
+    }
+    _xf.apply(x, y, tx, ty);
 }
 
 void BleDriver::tick() {
     unsigned long now = millis();
+
+    // 重连广播按时间降级 / Step the reconnect advertising down over time
+    if (!_paused && _disconnectAt != 0 && !isConnected()) {
+        unsigned long elapsed = now - _disconnectAt;
+        if (_reconnect.phase == BleAdvPhase::Directed && elapsed >= RECONNECT_DIRECTED_MS) {
+            startAdvertisingPhase(BleAdvPhase::Fast);
+        } else if (_reconnect.phase == BleAdvPhase::Fast && elapsed >= RECONNECT_FAST_WINDOW_MS) {
+            startAdvertisingPhase(BleAdvPhase::Normal);
+        }
+    }
+
     bool txActive = (_txLedOffAt != 0) && ((long)(_txLedOffAt - now) > 0);
     bool rxActive = (_rxLedOffAt != 0) && ((long)(_rxLedOffAt - now) > 0);
 
@@ -189,8 +292,8 @@ void BleDriver::clearLeds() {
     _txLedOffAt = _rxLedOffAt = 0;
 }
 
-void BleDriver::sendRaw(int x, int y, uint8_t state) {
-    if (_paused || !isConnected() || _input == nullptr) return;
+bool BleDriver::sendRaw(int x, int y, uint8_t state) {
+    if (_paused || !isConnected() || _input == nullptr) return false;
 
     uint8_t buffer[6];
     buffer[0] = state;
@@ -199,8 +302,316 @@ void BleDriver::sendRaw(int x, int y, uint8_t state) {
     
     _input->setValue(buffer, 5);
     _input->notify();
+    BootTimeline::mark(BootStage::FirstHidReport);
     // BLE 发送时脉冲 TX 指示灯 / EN: pulse TX LED on BLE activity
     pulseLed(_txLedOn, _txLedOffAt, PIN_LED_TX, 60);
+    return true;
+}
+
+void BleDriver::setDeviceName(const String& deviceName) {
+    if (deviceName.length() == 0 || deviceName == _deviceName) return;
+    _deviceName = deviceName;
+    if (_paused) return; // resume() 会使用新名字 / resume() picks up the new name
+    DEBUG_PRINTF("[BLE] Rename: %s\n", deviceName.c_str());
+    NimBLEDevice::setDeviceName(deviceName.c_str());
+    NimBLEAdvertisementData scanData;
+    scanData.setName(deviceName.c_str());
+    NimBLEDevice::getAdvertising()->setScanResponseData(scanData);
+}
+
+void BleDriver::onPeerConnected() {
+    _connections++;
+    BootTimeline::mark(BootStage::BleConnected);
+    NimBLEConnInfo info = NimBLEDevice::getServer()->getPeerInfo(0);
+    _lastPeer = info.getIdAddress();
+    _hasLastPeer = true;
+    LOG_EV(BleConnected, info.getConnHandle(), info.getConnInterval());
+    if (_disconnectAt != 0) {
+        _reconnect.reconnects++;
+        _reconnect.lastMs = millis() - _disconnectAt;
+        _reconnect.lastVia = _reconnect.phase;
+        LOG_EV(BleReconnected, (int32_t)_reconnect.lastMs, (int32_t)_reconnect.lastVia);
+        _disconnectAt = 0;
+    }
+    _reconnect.phase = BleAdvPhase::Idle;
+    requestLink(_connectParams);
+}
+
+void BleDriver::onPeerDisconnected() {
+    LOG_EV(BleDisconnected, (int32_t)_connections);
+    if (_paused) return;
+    startReconnectAdvertising();
+}
+
+const char* BleDriver::advPhaseName(BleAdvPhase phase) {
+    switch (phase) {
+    case BleAdvPhase::Directed: return "directed";
+    case BleAdvPhase::Fast: return "fast";
+    case BleAdvPhase::Normal: return "normal";
+    default: return "idle";
+    }
+}
+
+void BleDriver::startReconnectAdvertising() {
+    unsigned long now = millis();
+    _disconnectAt = now ? now : 1;
+
+    // 只对公共地址做定向广播：随机私有地址的手机需要控制器解析列表才能匹配
+    // EN: Directed only towards public identity addresses; phones on private addresses need a resolving list to match
+    NimBLEAddress peer;
+    bool havePeer = false;
+    if (_hasLastPeer && NimBLEDevice::isBonded(_lastPeer)) {
+        peer = _lastPeer;
+        havePeer = true;
+    } else if (NimBLEDevice::getNumBonds() > 0) {
+        peer = NimBLEDevice::getBondedAddress(NimBLEDevice::getNumBonds() - 1);
+        havePeer = true;
+    }
+
+    if (havePeer && peer.getType() == BLE_ADDR_PUBLIC) {
+        NimBLEAdvertising* adv = NimBLEDevice::getAdvertising();
+        adv->stop();
+        adv->setAdvertisementType(BLE_GAP_CONN_MODE_DIR);
+        adv->setMinInterval(FAST_ADV_MIN_ITVL);
+        adv->setMaxInterval(FAST_ADV_MIN_ITVL);
+        if (adv->start(0, nullptr, &peer)) {
+            _reconnect.phase = BleAdvPhase::Directed;
+            // EN: Type + low three address bytes (printed order) are enough to tell bonded phones apart.
+            // 中文: 地址类型 + 地址低 3 字节（按打印顺序）足以区分已绑定的手机。
+            const uint8_t* addr = peer.getNative();
+            LOG_EV(AdvDirected, (int32_t)peer.getType(), (int32_t)(addr[2] << 16 | addr[1] << 8 | addr[0]));
+            return;
+        }
+    }
+    startAdvertisingPhase(havePeer ? BleAdvPhase::Fast : BleAdvPhase::Normal);
+}
+
+void BleDriver::startAdvertisingPhase(BleAdvPhase phase) {
+    NimBLEAdvertising* adv = NimBLEDevice::getAdvertising();
+    adv->stop();
+    adv->setAdvertisementType(BLE_GAP_CONN_MODE_UND);
+    if (phase == BleAdvPhase::Fast) {
+        adv->setMinInterval(FAST_ADV_MIN_ITVL);
+        adv->setMaxInterval(FAST_ADV_MAX_ITVL);
+    } else {
+        // 0/0 = 协议栈默认间隔 / 0/0 = stack default intervals
+        adv->setMinInterval(0);
+        adv->setMaxInterval(0);
+    }
+    adv->start();
+    _reconnect.phase = phase;
+}
+
+bool BleDriver::linkPreset(const char* name, BleLinkParams& out) {
+    if (!name) return false;
+    out = BleLinkParams();
+    if (strcmp(name, "low_latency") == 0) {
+        out.minInterval = 6; out.maxInterval = 6; out.latency = 0; out.timeout = 300;
+        out.phy = 2; out.dle = true;
+    } else if (strcmp(name, "balanced") == 0) {
+        out.minInterval = 24; out.maxInterval = 24; out.latency = 0; out.timeout = 400;
+    } else if (strcmp(name, "power") == 0) {
+        out.minInterval = 48; out.maxInterval = 80; out.latency = 4; out.timeout = 600;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// EN: One key per field, so adding or reordering BleLinkParams members never misreads what is stored.
+// 中文: 每个字段一个键，BleLinkParams 增删或调整成员时不会误读已保存的值。
+void BleDriver::loadConnectParams() {
+    Preferences pref;
+    pref.begin("ble_link", false);
+    if (pref.isKey("min")) {
+        _connectParams.minInterval = pref.getUShort("min", _connectParams.minInterval);
+        _connectParams.maxInterval = pref.getUShort("max", _connectParams.maxInterval);
+        _connectParams.latency = pref.getUShort("lat", _connectParams.latency);
+        _connectParams.timeout = pref.getUShort("tmo", _connectParams.timeout);
+        _connectParams.phy = pref.getUChar("phy", _connectParams.phy);
+        _connectParams.dle = pref.getBool("dle", _connectParams.dle);
+    } else if (pref.getBytesLength("conn") == sizeof(BleLinkParams)) {
+        // EN: One-time migration of the raw struct written by earlier firmware (same layout as this build).
+        // 中文: 一次性迁移旧固件写入的原始结构体（与本版本布局相同）。
+        pref.getBytes("conn", &_connectParams, sizeof(BleLinkParams));
+        pref.end();
+        saveConnectParams();
+        return;
+    }
+    pref.end();
+}
+
+void BleDriver::saveConnectParams() {
+    Preferences pref;
+    pref.begin("ble_link", false);
+    pref.putUShort("min", _connectParams.minInterval);
+    pref.putUShort("max", _connectParams.maxInterval);
+    pref.putUShort("lat", _connectParams.latency);
+    pref.putUShort("tmo", _connectParams.timeout);
+    pref.putUChar("phy", _connectParams.phy);
+    pref.putBool("dle", _connectParams.dle);
+    if (pref.isKey("conn")) pref.remove("conn");
+    pref.end();
+}
+
+void BleDriver::setConnectParams(const BleLinkParams& p, bool persist) {
+    _connectParams = p;
+    if (persist) saveConnectParams();
+}
+
+bool BleDriver::requestLink(const BleLinkParams& p) {
+    if (_paused || !isConnected()) return false;
+    NimBLEServer* server = NimBLEDevice::getServer();
+    uint16_t handle = server->getPeerInfo(0).getConnHandle();
+
+    // EN: Same call updateConnParams() makes, but its result is checked: a request the host refuses
+    // EN: (e.g. an update already in flight) must not look as if it went out.
+    // 中文: 与 updateConnParams() 内部调用相同，但检查返回值：被协议栈拒绝的请求（如已有更新在进行）不能当作已发出。
+    // 中心设备之后仍可拒绝或改写（iOS 最小 15ms）/ The central may still refuse or adjust later (iOS floors at 15 ms)
+    ble_gap_upd_params params = {};
+    params.itvl_min = p.minInterval;
+    params.itvl_max = p.maxInterval;
+    params.latency = p.latency;
+    params.supervision_timeout = p.timeout;
+    params.min_ce_len = BLE_GAP_INITIAL_CONN_MIN_CE_LEN;
+    params.max_ce_len = BLE_GAP_INITIAL_CONN_MAX_CE_LEN;
+    int updRc = ble_gap_update_params(handle, &params);
+    if (updRc != 0) {
+        LOG_EV(BleLinkReqFail, 0, updRc);
+        return false;
+    }
+#if !defined(CONFIG_IDF_TARGET_ESP32)
+    if (p.phy == 1 || p.phy == 2) {
+        uint8_t mask = p.phy == 2 ? BLE_GAP_LE_PHY_2M_MASK : BLE_GAP_LE_PHY_1M_MASK;
+        int rc = ble_gap_set_prefered_le_phy(handle, mask, mask, BLE_GAP_LE_PHY_CODED_ANY);
+        if (rc != 0) LOG_EV(BleLinkReqFail, 1, rc);
+    }
+#endif
+    if (p.dle) {
+        // 251 字节 @1M 需 2120us / 251 octets at 1M take 2120 us
+        int rc = ble_gap_set_data_len(handle, 251, 2120);
+        if (rc != 0) LOG_EV(BleLinkReqFail, 2, rc);
+    }
+    return true;
+}
+
+bool BleDriver::readLink(BleLinkState& s) {
+    s = BleLinkState();
+    if (_paused || !isConnected()) return false;
+    NimBLEConnInfo info = NimBLEDevice::getServer()->getPeerInfo(0);
+    uint16_t handle = info.getConnHandle();
+    s.interval = info.getConnInterval();
+    s.latency = info.getConnLatency();
+    s.timeout = info.getConnTimeout();
+    s.mtu = info.getMTU();
+#if !defined(CONFIG_IDF_TARGET_ESP32)
+    uint8_t tx = 0, rx = 0;
+    if (ble_gap_read_le_phy(handle, &tx, &rx) == 0) {
+        s.txPhy = tx;
+        s.rxPhy = rx;
+    }
+#else
+    s.txPhy = s.rxPhy = 1; // 经典 ESP32 仅 1M / classic ESP32 is 1M only
+#endif
+    int8_t rssi = 0;
+    if (ble_gap_conn_rssi(handle, &rssi) == 0) s.rssi = rssi;
+    return true;
+}
+
+void BleDriver::recordNotifyStatus(bool ok, int code) {
+    if (ok) {
+        _notifyOk++;
+    } else {
+        _notifyFail++;
+        _lastNotifyError = code;
+        LOG_EV(NotifyFail, code, (int32_t)_notifyFail);
+    }
+}
+
+// 间隔直方图：25us 一格，最后一格为溢出 / Interval histogram: 25 us buckets, the last one collects overflow
+static const int kBenchBucketUs = 25;
+static const int kBenchBuckets = 512;
+
+static uint32_t benchPercentile(const uint32_t* hist, uint32_t total, float q) {
+    if (total == 0) return 0;
+    uint32_t target = (uint32_t)(total * q);
+    uint32_t seen = 0;
+    for (int i = 0; i < kBenchBuckets; i++) {
+        seen += hist[i];
+        if (seen > target) return (uint32_t)(i + 1) * kBenchBucketUs;
+    }
+    return (uint32_t)kBenchBuckets * kBenchBucketUs;
+}
+
+bool BleDriver::benchHid(int seconds, int rate, HidBenchResult& out) {
+    out = HidBenchResult();
+    if (_paused || !isConnected() || _input == nullptr) return false;
+
+    uint32_t* hist = (uint32_t*)calloc(kBenchBuckets, sizeof(uint32_t));
+    if (!hist) return false;
+
+    NimBLEConnInfo info = NimBLEDevice::getServer()->getPeerInfo(0);
+    out.connInterval = info.getConnInterval();
+    out.connLatency = info.getConnLatency();
+    out.supervisionTimeout = info.getConnTimeout();
+    out.mtu = info.getMTU();
+
+    uint32_t okStart = _notifyOk;
+    uint32_t failStart = _notifyFail;
+    uint32_t periodUs = rate > 0 ? 1000000UL / (uint32_t)rate : 0;
+    uint32_t durationUs = (uint32_t)seconds * 1000000UL;
+    uint32_t intervals = 0;
+
+    // 数位板中心悬停，x 每帧 ±1 抖动，保证每个报告内容不同
+    // EN: Hover at the digitizer centre; x wobbles by 1 so every report carries new data
+    uint8_t buffer[5];
+    buffer[0] = 0x04;
+    buffer[3] = 16384 & 0xFF; buffer[4] = (16384 >> 8) & 0xFF;
+
+    uint32_t start = micros();
+    uint32_t next = start;
+    uint32_t prev = 0;
+    while ((uint32_t)(micros() - start) < durationUs) {
+        if (periodUs > 0) {
+            // 按绝对时刻排程，避免误差累积 / Schedule on absolute deadlines so error does not accumulate
+            int32_t wait = (int32_t)(next - micros());
+            if (wait > 2000) delay(wait / 1000 - 1);
+            while ((int32_t)(next - micros()) > 0) { }
+            next += periodUs;
+        }
+        int x = 16384 + (out.attempted & 1);
+        buffer[1] = x & 0xFF; buffer[2] = (x >> 8) & 0xFF;
+
+        uint32_t now = micros();
+        _input->setValue(buffer, 5);
+        _input->notify();
+        out.attempted++;
+        if (out.attempted > 1) {
+            uint32_t gap = now - prev;
+            int bucket = gap / kBenchBucketUs;
+            if (bucket >= kBenchBuckets) bucket = kBenchBuckets - 1;
+            hist[bucket]++;
+            intervals++;
+            if (gap > out.maxUs) out.maxUs = gap;
+        }
+        prev = now;
+        if (periodUs == 0 && (out.attempted & 0x3F) == 0) yield();
+        if (!isConnected()) break;
+    }
+    out.elapsedUs = micros() - start;
+
+    out.notifyOk = _notifyOk - okStart;
+    out.notifyFail = _notifyFail - failStart;
+    out.lastError = _lastNotifyError;
+    out.reportsPerSec = out.elapsedUs ? out.notifyOk * 1000000.0f / out.elapsedUs : 0;
+    out.p50Us = benchPercentile(hist, intervals, 0.50f);
+    out.p90Us = benchPercentile(hist, intervals, 0.90f);
+    out.p99Us = benchPercentile(hist, intervals, 0.99f);
+    free(hist);
+
+    // 结束时发一次悬停，保持与正常动作一致的收尾 / Finish with a normal hover report
+    sendRaw(16384, 16384, 0x04);
+    return true;
 }
 
 void BleDriver::click(int x, int y, ActionOptions opts) {
@@ -208,37 +619,88 @@ void BleDriver::click(int x, int y, ActionOptions opts) {
 }
 
 void BleDriver::click(int x, int y, int count, ActionOptions opts) {
-    long tx = mapVal(x, opts.screenW);
-    long ty = mapVal(y, opts.screenH);
-    
-    if (count < 1) count = 1;
+    buildClick(x, y, count, opts, _scratch);
+    play(_scratch);
+}
 
-    sendRaw(tx, ty, 0x04); 
-    if(opts.delayHover > 0) delay(opts.delayHover);      
-    
-    for (int i = 0; i < count; i++) {
-        sendRaw(tx, ty, 0x05); 
-        if(opts.delayPress > 0) delay(opts.delayPress); 
-        
-        sendRaw(tx, ty, 0x04); 
-        if (i < count - 1) {
-            if(opts.delayMultiClickInterval > 0) delay(opts.delayMultiClickInterval);
-        }
+void BleDriver::swipe(int x1, int y1, int x2, int y2, int duration, ActionOptions opts) {
+    buildSwipe(x1, y1, x2, y2, duration, opts, _scratch);
+    play(_scratch);
+}
+
+static uint16_t clampMs(int v) {
+    return (uint16_t)constrain(v, 0, 0xFFFF);
+}
+
+static uint16_t clampDigitizer(long v) {
+    return (uint16_t)constrain(v, 0L, (long)DIGITIZER_MAX);
+}
+
+uint32_t GesturePlan::durationMs() const {
+    if (kind == Tap) {
+        return hoverMs + (uint32_t)taps * pressMs + (uint32_t)(taps > 0 ? taps - 1 : 0) * multiIntervalMs
+             + releaseMs + doubleCheckMs;
     }
-    
-    if(opts.delayRelease > 0) delay(opts.delayRelease);
-    
-    if(opts.delayDoubleCheck > 0) {
-        delay(opts.delayDoubleCheck);
-        sendRaw(tx, ty, 0x04); 
+    if (kind == Swipe) {
+        return hoverMs + pressMs + (uint32_t)(((uint64_t)count * stepUs) / 1000) + endHoldMs + doubleCheckMs;
     }
+    return 0;
 }
 
-void BleDriver::swipe(int x1, int y1, int x2, int y2, int duration, ActionOptions opts) {
-    long tx1 = mapVal(x1, opts.screenW);
-    long ty1 = mapVal(y1, opts.screenH);
-    long tx2 = mapVal(x2, opts.screenW);
-    long ty2 = mapVal(y2, opts.screenH);
+void BleDriver::buildClick(int x, int y, int count, const ActionOptions& opts, GesturePlan& out) {
+    long tx, ty;
+    mapPoint(x, y, opts, tx, ty);
+
+    out.kind = GesturePlan::Tap;
+    out.taps = (uint8_t)constrain(count, 1, 255);
+    out.count = 0;
+    out.startX = out.endX = clampDigitizer(tx);
+    out.startY = out.endY = clampDigitizer(ty);
+    out.stepUs = 0;
+    out.hoverMs = clampMs(opts.delayHover);
+    out.pressMs = clampMs(opts.delayPress);
+    out.releaseMs = clampMs(opts.delayRelease);
+    out.multiIntervalMs = clampMs(opts.delayMultiClickInterval);
+    out.doubleCheckMs = clampMs(opts.delayDoubleCheck);
+    out.endHoldMs = 0;
+}
+
+// 按 delayInterval 计算步数；点数超出缓冲时拉长步距，保持总时长不变
+// EN: Steps from delayInterval; too many points widen the step and keep the total time
+static int planSteps(int duration, const ActionOptions& opts, uint32_t& stepUs) {
+    int stepTime = opts.delayInterval;
+    if (stepTime <= 0) stepTime = 10;
+
+    int steps = duration / stepTime;
+    if (steps < 2) steps = 2;
+    stepUs = (uint32_t)stepTime * 1000;
+    if (steps > GesturePlan::kMaxPoints) {
+        stepUs = (uint32_t)((uint64_t)steps * stepUs / GesturePlan::kMaxPoints);
+        steps = GesturePlan::kMaxPoints;
+    }
+    return steps;
+}
+
+// 甩动的速度曲线：s(t) = (1-k)·t + k·t²，起步 (1-k) 倍、抬起时 (1+k) 倍平均速度
+// EN: Fling profile: s(t) = (1-k)·t + k·t², starting at (1-k)× and lifting off at (1+k)× the mean speed
+static const float FLING_EASE = 0.85f;
+
+void BleDriver::buildSwipe(int x1, int y1, int x2, int y2, int duration, const ActionOptions& opts, GesturePlan& out) {
+    buildBezier(x1, y1, x2, y2, duration, false, opts, out);
+}
+
+void BleDriver::buildFling(int x1, int y1, int x2, int y2, int duration, const ActionOptions& opts, GesturePlan& out) {
+    buildBezier(x1, y1, x2, y2, duration, true, opts, out);
+    // 手指在运动中抬起，不做二次抬起 / The finger lifts mid-motion, no second release
+    out.doubleCheckMs = 0;
+}
+
+void BleDriver::buildBezier(int x1, int y1, int x2, int y2, int duration, bool fling, const ActionOptions& opts, GesturePlan& out) {
+    // 仿射变换保持贝塞尔曲线：映射端点后在数位板空间插值，等价于逐点变换
+    // EN: Affine maps preserve Bézier curves, so interpolating mapped endpoints equals mapping every step
+    long tx1, ty1, tx2, ty2;
+    mapPoint(x1, y1, opts, tx1, ty1);
+    mapPoint(x2, y2, opts, tx2, ty2);
 
     long midX = (tx1 + tx2) / 2;
     long midY = (ty1 + ty2) / 2; 
@@ -251,34 +713,370 @@ void BleDriver::swipe(int x1, int y1, int x2, int y2, int duration, ActionOption
     if (abs(tx2 - tx1) < abs(ty2 - ty1)) cx += offset;
     else cy += offset;
 
-    sendRaw(tx1, ty1, 0x04); 
-    if(opts.delayHover > 0) delay(opts.delayHover);
-
-    sendRaw(tx1, ty1, 0x05); 
-    if(opts.delayPress > 0) delay(opts.delayPress);
-
-    int stepTime = opts.delayInterval;
-    if (stepTime <= 0) stepTime = 10;
-    
-    int steps = duration / stepTime;
-    if (steps < 2) steps = 2;
+    uint32_t stepUs;
+    int steps = planSteps(duration, opts, stepUs);
 
     for (int i = 1; i <= steps; i++) {
         float t = (float)i / steps;
+        if (fling) t = (1 - FLING_EASE) * t + FLING_EASE * t * t;
         float u = 1 - t;
         float tt = t * t;
         float uu = u * u;
 
         long curveX = (uu * tx1) + (2 * u * t * cx) + (tt * tx2);
         long curveY = (uu * ty1) + (2 * u * t * cy) + (tt * ty2);
+        // 控制点可能越界，曲线点需夹紧 / The control point may sit off-panel, so clamp each point
+        out.x[i - 1] = clampDigitizer(curveX);
+        out.y[i - 1] = clampDigitizer(curveY);
+    }
 
-        sendRaw(curveX, curveY, 0x05); 
-        delay(stepTime);
+    out.startX = clampDigitizer(tx1);
+    out.startY = clampDigitizer(ty1);
+    fillSwipeTiming(out, steps, stepUs, opts);
+    out.endX = clampDigitizer(tx2);
+    out.endY = clampDigitizer(ty2);
+}
+
+// 均匀 Catmull-Rom：对仿射变换不变，因此可在像素空间求值后再逐点映射
+// EN: Uniform Catmull-Rom; affine-invariant, so it is evaluated in pixels and mapped point by point
+static float catmullRom(float p0, float p1, float p2, float p3, float u) {
+    float u2 = u * u;
+    float u3 = u2 * u;
+    return 0.5f * ((2 * p1) + (-p0 + p2) * u + (2 * p0 - 5 * p1 + 4 * p2 - p3) * u2 + (-p0 + 3 * p1 - 3 * p2 + p3) * u3);
+}
+
+void BleDriver::buildPolyline(const int16_t* xs, const int16_t* ys, int n, int duration, bool spline, int endHoldMs,
+                              const ActionOptions& opts, GesturePlan& out) {
+    n = constrain(n, 2, GESTURE_MAX_WAYPOINTS);
+
+    // 按像素弦长分配时间，各段速度一致 / Time is split by chord length in pixels, so every segment moves at the same speed
+    float segLen[GESTURE_MAX_WAYPOINTS];
+    float total = 0;
+    for (int k = 0; k < n - 1; k++) {
+        float dx = xs[k + 1] - xs[k], dy = ys[k + 1] - ys[k];
+        segLen[k] = sqrtf(dx * dx + dy * dy);
+        total += segLen[k];
     }
-    
-    sendRaw(tx2, ty2, 0x04);
-    if(opts.delayDoubleCheck > 0) {
-        delay(opts.delayDoubleCheck);
-        sendRaw(tx2, ty2, 0x04); 
+
+    uint32_t stepUs;
+    int steps = planSteps(duration, opts, stepUs);
+
+    int seg = 0;
+    float segStart = 0;
+    long tx, ty;
+    for (int i = 1; i <= steps; i++) {
+        float d = total * i / steps;
+        while (seg < n - 2 && segStart + segLen[seg] < d) {
+            segStart += segLen[seg];
+            seg++;
+        }
+        float u = segLen[seg] > 0 ? (d - segStart) / segLen[seg] : 1.0f;
+        u = constrain(u, 0.0f, 1.0f);
+
+        float px, py;
+        if (spline) {
+            // 端点复制作为虚拟控制点 / Endpoints are duplicated as phantom control points
+            int a = max(seg - 1, 0), b = seg, c = seg + 1, e = min(seg + 2, n - 1);
+            px = catmullRom(xs[a], xs[b], xs[c], xs[e], u);
+            py = catmullRom(ys[a], ys[b], ys[c], ys[e], u);
+        } else {
+            px = xs[seg] + u * (xs[seg + 1] - xs[seg]);
+            py = ys[seg] + u * (ys[seg + 1] - ys[seg]);
+        }
+        mapPoint((int)lroundf(px), (int)lroundf(py), opts, tx, ty);
+        out.x[i - 1] = clampDigitizer(tx);
+        out.y[i - 1] = clampDigitizer(ty);
+    }
+
+    mapPoint(xs[0], ys[0], opts, tx, ty);
+    out.startX = clampDigitizer(tx);
+    out.startY = clampDigitizer(ty);
+    fillSwipeTiming(out, steps, stepUs, opts);
+    out.endHoldMs = clampMs(endHoldMs);
+}
+
+void BleDriver::buildPath(int startX, int startY, const int* xs, const int* ys, int count, uint32_t stepUs,
+                          const ActionOptions& opts, GesturePlan& out) {
+    count = constrain(count, 1, GesturePlan::kMaxPoints);
+    long tx, ty;
+    mapPoint(startX, startY, opts, tx, ty);
+    out.startX = clampDigitizer(tx);
+    out.startY = clampDigitizer(ty);
+    for (int i = 0; i < count; i++) {
+        mapPoint(xs[i], ys[i], opts, tx, ty);
+        out.x[i] = clampDigitizer(tx);
+        out.y[i] = clampDigitizer(ty);
+    }
+    fillSwipeTiming(out, count, stepUs, opts);
+}
+
+// 滑动类计划的公共字段；终点默认取最后一个路径点 / Common fields of swipe-type plans; the end defaults to the last path point
+void BleDriver::fillSwipeTiming(GesturePlan& out, int count, uint32_t stepUs, const ActionOptions& opts) {
+    out.kind = GesturePlan::Swipe;
+    out.taps = 0;
+    out.count = (uint16_t)count;
+    out.endX = out.x[count - 1];
+    out.endY = out.y[count - 1];
+    out.stepUs = stepUs;
+    out.hoverMs = clampMs(opts.delayHover);
+    out.pressMs = clampMs(opts.delayPress);
+    out.releaseMs = 0;
+    out.multiIntervalMs = 0;
+    out.doubleCheckMs = clampMs(opts.delayDoubleCheck);
+    out.endHoldMs = 0;
+}
+
+// 截止前这么多微秒由定时器唤醒，剩余部分自旋 / Timer wakes us this early; the rest is spun
+static const int64_t STEP_SPIN_US = 150;
+
+void BleDriver::onStepTimer(void* arg) {
+    BleDriver* self = static_cast<BleDriver*>(arg);
+    TaskHandle_t waiter = self->_stepWaiter;
+    if (waiter) xTaskNotifyGive(waiter);
+}
+
+// 睡到绝对截止时间：单次 esp_timer + 任务通知，最后 150µs 自旋
+// EN: Sleep until an absolute deadline: one-shot esp_timer + task notification, spin the last 150 µs
+void BleDriver::waitUntilUs(int64_t deadlineUs) {
+    if (_stepTimer == nullptr) {
+        esp_timer_create_args_t args = {};
+        args.callback = &BleDriver::onStepTimer;
+        args.arg = this;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "hid_step";
+        if (esp_timer_create(&args, &_stepTimer) != ESP_OK) _stepTimer = nullptr;
+    }
+
+    int64_t remain;
+    while ((remain = deadlineUs - esp_timer_get_time()) > STEP_SPIN_US) {
+        if (_stepTimer == nullptr) {
+            delay((uint32_t)((remain - STEP_SPIN_US) / 1000));
+            break;
+        }
+        _stepWaiter = xTaskGetCurrentTaskHandle();
+        ulTaskNotifyTake(pdTRUE, 0); // 清除残留通知 / drop a stale notification
+        if (esp_timer_start_once(_stepTimer, (uint64_t)(remain - STEP_SPIN_US)) != ESP_OK) {
+            _stepWaiter = nullptr;
+            delay((uint32_t)((remain - STEP_SPIN_US) / 1000));
+            break;
+        }
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(remain / 1000 + 20));
+        esp_timer_stop(_stepTimer);
+        _stepWaiter = nullptr;
+    }
+    while (esp_timer_get_time() < deadlineUs) {
+    }
+}
+
+// 在截止时间发出一个报告并记录偏差 / Emit one report at its deadline and record the lateness
+// 断开后不再等待剩余报告的截止时间，手势尽快以“部分完成”结束
+// EN: After a failed send the remaining deadlines are skipped, so the gesture ends early as partial
+void BleDriver::emitAt(int64_t deadlineUs, uint16_t x, uint16_t y, uint8_t state) {
+    if (_timing.failedStep >= 0) return;
+    waitUntilUs(deadlineUs);
+    trackLateness(deadlineUs);
+    noteSend(sendRaw(x, y, state));
+}
+
+void BleDriver::emitKeyAt(int64_t deadlineUs, uint8_t modifiers, uint8_t keycode) {
+    if (_timing.failedStep >= 0) return;
+    waitUntilUs(deadlineUs);
+    trackLateness(deadlineUs);
+    noteSend(sendKeyboard(modifiers, keycode));
+}
+
+void BleDriver::noteSend(bool sent) {
+    if (!sent && _timing.failedStep < 0) _timing.failedStep = (int16_t)(_timing.reports - 1);
+}
+
+void BleDriver::trackLateness(int64_t deadlineUs) {
+    uint32_t late = (uint32_t)(esp_timer_get_time() - deadlineUs);
+    _latenessSumUs += late;
+    if (late > _timing.jitterMaxUs) _timing.jitterMaxUs = late;
+    _timing.reports++;
+}
+
+void BleDriver::beginTiming() {
+    _timing = GestureTiming();
+    _latenessSumUs = 0;
+}
+
+void BleDriver::endTiming(int64_t startUs, int64_t plannedEndUs) {
+    int64_t end = esp_timer_get_time();
+    _timing.plannedUs = (uint32_t)(plannedEndUs - startUs);
+    _timing.actualUs = (uint32_t)(end - startUs);
+    _timing.overrunUs = (int32_t)(end - plannedEndUs);
+    if (_timing.reports > 0) _timing.jitterAvgUs = (uint32_t)(_latenessSumUs / _timing.reports);
+    LOG_EV(GestureDone, _timing.overrunUs, (int32_t)_timing.jitterMaxUs);
+    if (_timing.failedStep >= 0) LOG_EV(GesturePartial, _timing.failedStep, (int32_t)_timing.reports);
+}
+
+// 所有报告时刻在开始时按计划累加得出，不受单步开销影响，总时长不漂移
+// EN: Every report time is derived from the start time plus the plan, so per-step overhead never accumulates
+void BleDriver::play(const GesturePlan& g) {
+    beginTiming();
+    const int64_t t0 = esp_timer_get_time();
+    int64_t due = t0;
+
+    if (g.kind == GesturePlan::Tap) {
+        emitAt(due, g.startX, g.startY, 0x04);
+        due += (int64_t)g.hoverMs * 1000;
+
+        for (int i = 0; i < g.taps; i++) {
+            emitAt(due, g.startX, g.startY, 0x05);
+            due += (int64_t)g.pressMs * 1000;
+
+            emitAt(due, g.startX, g.startY, 0x04);
+            if (i < g.taps - 1) due += (int64_t)g.multiIntervalMs * 1000;
+        }
+
+        due += (int64_t)g.releaseMs * 1000;
+        if (g.doubleCheckMs > 0) {
+            due += (int64_t)g.doubleCheckMs * 1000;
+            emitAt(due, g.startX, g.startY, 0x04);
+        } else if (_timing.failedStep < 0) {
+            waitUntilUs(due);
+        }
+    } else if (g.kind == GesturePlan::Swipe) {
+        emitAt(due, g.startX, g.startY, 0x04);
+        due += (int64_t)g.hoverMs * 1000;
+
+        emitAt(due, g.startX, g.startY, 0x05);
+        due += (int64_t)g.pressMs * 1000;
+
+        for (int i = 0; i < g.count; i++) {
+            emitAt(due, g.x[i], g.y[i], 0x05);
+            due += g.stepUs;
+        }
+
+        // 拖放：终点保持按下，接触不中断 / Drop: stay down at the end, the contact is never broken
+        due += (int64_t)g.endHoldMs * 1000;
+        emitAt(due, g.endX, g.endY, 0x04);
+        if (g.doubleCheckMs > 0) {
+            due += (int64_t)g.doubleCheckMs * 1000;
+            emitAt(due, g.endX, g.endY, 0x04);
+        }
+    } else {
+        return;
+    }
+
+    endTiming(t0, due);
+}
+
+bool BleDriver::sendKeyboard(uint8_t modifiers, uint8_t keycode) {
+    if (_paused || !isConnected() || _keyboard == nullptr) return false;
+    uint8_t buffer[8] = {modifiers, 0, keycode, 0, 0, 0, 0, 0};
+    _keyboard->setValue(buffer, sizeof(buffer));
+    _keyboard->notify();
+    pulseLed(_txLedOn, _txLedOffAt, PIN_LED_TX, 60);
+    return true;
+}
+
+bool BleDriver::sendConsumer(uint16_t usage) {
+    if (_paused || !isConnected() || _consumer == nullptr) return false;
+    uint8_t buffer[2] = {(uint8_t)(usage & 0xFF), (uint8_t)(usage >> 8)};
+    _consumer->setValue(buffer, sizeof(buffer));
+    _consumer->notify();
+    pulseLed(_txLedOn, _txLedOffAt, PIN_LED_TX, 60);
+    return true;
+}
+
+bool BleDriver::keyByName(const char* name, uint8_t& keycode, uint16_t& usage) {
+    if (!name) return false;
+    for (const NamedKey& k : kNamedKeys) {
+        if (strcmp(k.name, name) == 0) {
+            keycode = k.keycode;
+            usage = k.usage;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BleDriver::pressKey(uint8_t keycode, uint8_t modifiers, int holdMs) {
+    if (_paused || !isConnected() || _keyboard == nullptr) return false;
+    beginTiming();
+    const int64_t t0 = esp_timer_get_time();
+    int64_t due = t0;
+    emitKeyAt(due, modifiers, keycode);
+    due += (int64_t)max(0, holdMs) * 1000;
+    emitKeyAt(due, 0, 0);
+    endTiming(t0, due);
+    return true;
+}
+
+bool BleDriver::pressConsumer(uint16_t usage, int holdMs) {
+    if (_paused || !isConnected() || _consumer == nullptr) return false;
+    beginTiming();
+    const int64_t t0 = esp_timer_get_time();
+    int64_t due = t0;
+    waitUntilUs(due);
+    trackLateness(due);
+    noteSend(sendConsumer(usage));
+    due += (int64_t)max(0, holdMs) * 1000;
+    if (_timing.failedStep < 0) {
+        waitUntilUs(due);
+        trackLateness(due);
+        noteSend(sendConsumer(0));
+    }
+    endTiming(t0, due);
+    return true;
+}
+
+// 逐字符发送按下/抬起；同一批内背靠背发送，批与批之间按带波动的间隔，时刻取绝对截止时间
+// EN: Key down/up per character; back to back within a batch, jittered gaps between batches, on absolute deadlines
+bool BleDriver::typeText(const char* utf8, const TypeOptions& opts, TypeResult& out) {
+    out = TypeResult();
+    if (!utf8 || _paused || !isConnected() || _keyboard == nullptr) return false;
+
+    int batch = constrain(opts.batch, 1, 16);
+    int holdUs = constrain(opts.keyHoldMs, 0, 500) * 1000;
+    int intervalUs = constrain(opts.keyIntervalMs, 0, 2000) * 1000;
+    int swingUs = intervalUs * constrain(opts.jitterPercent, 0, 100) / 100;
+
+    beginTiming();
+    const int64_t t0 = esp_timer_get_time();
+    int64_t due = t0;
+    int64_t lastDue = t0; // 最后一次抬起的截止时间；末尾的批间隔不计入 / last key-up deadline; the trailing gap is not waited
+    int inBatch = 0;
+    const uint8_t* p = (const uint8_t*)utf8;
+    while (*p) {
+        uint8_t c = *p;
+        if (c >= 0x80) {
+            // 跳过整个多字节序列：HID 键码无法直接输入非 ASCII / Skip the whole multi-byte sequence: keycodes can't enter non-ASCII
+            int len = (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 1;
+            for (int i = 0; i < len && *p; i++) p++;
+            out.skipped++;
+            continue;
+        }
+        p++;
+
+        uint8_t keycode = 0, mods = 0;
+        if (c == '\n') keycode = 0x28;
+        else if (c == '\t') keycode = 0x2B;
+        else if (c == '\b') keycode = 0x2A;
+        else if (c >= 0x20 && c < 0x7F) {
+            uint8_t k = kAsciiKeys[c - 0x20];
+            keycode = k & 0x7F;
+            if (k & 0x80) mods = KEY_MOD_LSHIFT;
+        }
+        if (keycode == 0) {
+            out.skipped++;
+            continue;
+        }
+
+        emitKeyAt(due, mods, keycode);
+        due += holdUs;
+        emitKeyAt(due, 0, 0);
+        if (_timing.failedStep >= 0) break;
+        lastDue = due;
+        out.typed++;
+
+        if (++inBatch >= batch) {
+            inBatch = 0;
+            due += intervalUs + (swingUs > 0 ? random(-swingUs, swingUs + 1) : 0);
+        }
     }
+    endTiming(t0, lastDue);
+    return true;
 }
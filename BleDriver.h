@@ -4,34 +4,99 @@
 #include <NimBLEDevice.h>
 #include <NimBLEHIDDevice.h>
 #include <Arduino.h>
+#include <esp_timer.h>
+#include "ScreenCalib.h"
+#include "ActionOptions.h"
 
-// 定义全量参数结构体 (默认值仅作兜底)
-// EN: Full option struct for all motion parameters (defaults are just fallbacks)
-struct ActionOptions {
-    // 屏幕参数
-    // EN: Screen parameters
-    int screenW = 1080;
-    int screenH = 2248;
-    
-    // 时间参数 (单位: ms)
-    // EN: Time parameters (ms)
-    int delayHover = 20;    // 移动到位置后，按下前的悬停时间
-    // EN: Hover time before press after moving to target
-    int delayPress = 20;    // 按下后，开始滑动/抬起前的等待时间
-    // EN: Delay after press before swipe/release
-    int delayInterval = 10; // 滑动过程中每一步的间隔 (控制平滑度)
-    // EN: Interval between swipe steps (controls smoothness)
-    int delayRelease = 20;  // 抬起后的冷却时间
-    // EN: Cooldown after release
-    int delayMultiClickInterval = 30; // 多次点击之间的间隔
-    // EN: Gap between multi-click presses
-    int delayDoubleCheck = 20; // 防止断触的二次抬起延迟
-    // EN: Extra delay before second release to avoid ghost touches
-
-    // 算法参数
-    // EN: Algorithm parameters
-    int curveStrength = 15; // 贝塞尔曲线弯曲程度 (百分比 0-100)
-    // EN: Bézier curve bending strength (0-100%)
+// HID 吞吐基准结果 / HID throughput benchmark result
+struct HidBenchResult {
+    uint32_t attempted = 0;     // 调用 notify() 次数 / notify() calls made
+    uint32_t notifyOk = 0;      // 协议栈接受的通知 / notifications accepted by the stack
+    uint32_t notifyFail = 0;    // 被拒绝的通知（多为 mbuf 不足）/ rejected notifications (mostly out of mbufs)
+    int lastError = 0;          // 最近一次失败的 NimBLE 返回码 / last NimBLE error code
+    uint32_t elapsedUs = 0;
+    float reportsPerSec = 0;    // 按成功通知计算 / computed from accepted notifications
+    uint32_t p50Us = 0, p90Us = 0, p99Us = 0, maxUs = 0; // 报告间隔分位数 / inter-report interval percentiles
+    // 协商后的连接参数 / negotiated connection parameters
+    uint16_t connInterval = 0;  // 1.25ms 单位 / units of 1.25 ms
+    uint16_t connLatency = 0;
+    uint16_t supervisionTimeout = 0; // 10ms 单位 / units of 10 ms
+    uint16_t mtu = 0;
+};
+
+// 连接参数请求 / Link parameter request
+struct BleLinkParams {
+    uint16_t minInterval = 24; // 1.25ms 单位 / units of 1.25 ms
+    uint16_t maxInterval = 24;
+    uint16_t latency = 0;      // 可跳过的连接事件数 / connection events the peripheral may skip
+    uint16_t timeout = 400;    // 10ms 单位 / units of 10 ms
+    uint8_t phy = 0;           // 0 不变，1 = 1M，2 = 2M / 0 keep, 1 = 1M, 2 = 2M
+    bool dle = false;          // 数据长度扩展（251 字节）/ data length extension (251 bytes)
+};
+
+// 当前链路状态（中心设备实际接受的值）/ Live link state (what the central actually accepted)
+struct BleLinkState {
+    uint16_t interval = 0;     // 1.25ms 单位 / units of 1.25 ms
+    uint16_t latency = 0;
+    uint16_t timeout = 0;      // 10ms 单位 / units of 10 ms
+    uint16_t mtu = 0;
+    uint8_t txPhy = 0;         // 1 = 1M，2 = 2M，3 = Coded；0 未知 / 0 unknown
+    uint8_t rxPhy = 0;
+    int8_t rssi = 0;
+};
+
+// 断线重连广播阶段 / Reconnect advertising phase
+enum class BleAdvPhase : uint8_t {
+    Idle = 0,   // 已连接或未广播 / connected or not advertising
+    Directed,   // 定向广播给上次绑定的手机 / directed at the last bonded phone
+    Fast,       // 高占空比（20-30ms）无定向广播 / high-duty (20-30 ms) undirected
+    Normal,     // 默认间隔广播 / default-interval advertising
+};
+
+// 重连统计 / Reconnect statistics
+struct BleReconnectStats {
+    uint32_t reconnects = 0;     // 断线/重启后成功重连的次数 / successful reconnects after a drop or restart
+    uint32_t lastMs = 0;         // 最近一次从断开到重连的耗时 / last disconnect-to-connect time
+    BleAdvPhase lastVia = BleAdvPhase::Idle; // 最近一次在哪个阶段连上 / phase the last reconnect happened in
+    BleAdvPhase phase = BleAdvPhase::Idle;   // 当前阶段 / current phase
+};
+
+// 预先生成的手势：数位板坐标 + 时序，回放时只发报告 / Prebuilt gesture: digitizer points + timing; playback only sends reports
+struct GesturePlan {
+    static const int kMaxPoints = 256;
+    enum Kind : uint8_t { None = 0, Tap, Swipe };
+    uint8_t kind = None;
+    uint8_t taps = 0;           // Tap：按下次数 / Tap: number of presses
+    uint16_t count = 0;         // Swipe：路径点数（不含起点）/ Swipe: path points (start excluded)
+    uint16_t startX = 0, startY = 0, endX = 0, endY = 0;
+    uint32_t stepUs = 0;        // 路径点间隔 / interval between path points
+    uint16_t hoverMs = 0, pressMs = 0, releaseMs = 0, multiIntervalMs = 0, doubleCheckMs = 0;
+    uint16_t endHoldMs = 0;     // Swipe：抬起前在终点按住（拖放）/ Swipe: stay down at the end before lifting (drop)
+    uint16_t x[kMaxPoints];
+    uint16_t y[kMaxPoints];
+
+    // 预计回放时长 / Expected playback time
+    uint32_t durationMs() const;
+};
+
+// 文本输入结果 / Text entry result
+struct TypeResult {
+    uint16_t typed = 0;      // 已发送的字符 / characters sent
+    uint16_t skipped = 0;    // 无法用美式键盘表示的字符（非 ASCII 等）/ characters a US layout cannot produce (non-ASCII etc.)
+};
+
+// 手势时序统计：报告按手势开始时算好的绝对截止时间发出
+// EN: Gesture timing: reports are emitted on absolute deadlines computed at gesture start
+struct GestureTiming {
+    uint32_t plannedUs = 0;    // 计划总时长 / planned duration
+    uint32_t actualUs = 0;     // 实际总时长 / measured duration
+    int32_t overrunUs = 0;     // 实际 - 计划 / actual minus planned
+    uint16_t reports = 0;      // 发出的报告数 / reports emitted
+    uint32_t jitterAvgUs = 0;  // 发出时刻相对截止时间的平均偏差 / mean emit lateness vs deadline
+    uint32_t jitterMaxUs = 0;  // 最大偏差 / worst emit lateness
+    // 第一个因断开/暂停未能发出的报告序号（从 0 起），-1 = 完整；之后的报告不再等待 / index (from 0) of the
+    // first report that could not be sent (disconnect/pause), -1 = complete; later reports are not paced
+    int16_t failedStep = -1;
 };
 
 class BleDriver {
@@ -40,6 +105,8 @@ public:
     bool isConnected();
     void pause();
     void resume();
+    // 运行中更新广播名（扫描响应 + GAP 名称）/ Update the advertised name at runtime (scan response + GAP name)
+    void setDeviceName(const String& deviceName);
 
     
     // 动作接口现在接收 options 结构体
@@ -47,6 +114,31 @@ public:
     void click(int x, int y, ActionOptions opts);
     void click(int x, int y, int count, ActionOptions opts);
     void swipe(int x1, int y1, int x2, int y2, int duration, ActionOptions opts);
+
+    // 先生成、后回放：生成阶段完成映射/曲线计算，回放阶段只按时序发报告
+    // EN: Build then play: building does mapping/curve math, playback only sends reports on schedule
+    void buildClick(int x, int y, int count, const ActionOptions& opts, GesturePlan& out);
+    void buildSwipe(int x1, int y1, int x2, int y2, int duration, const ActionOptions& opts, GesturePlan& out);
+    // 甩动：末端速度最大，抬起时手指仍在运动 / Fling: speed peaks at the end, the finger lifts while moving
+    void buildFling(int x1, int y1, int x2, int y2, int duration, const ActionOptions& opts, GesturePlan& out);
+    // 经过 N 个途经点的折线或 Catmull-Rom 样条，全程不抬起；按住时长取 opts.delayPress，终点按住 endHoldMs
+    // EN: Polyline or Catmull-Rom spline through N waypoints without lifting; pickup hold is opts.delayPress,
+    // EN: endHoldMs keeps the contact down at the last waypoint (drag-and-drop)
+    void buildPolyline(const int16_t* xs, const int16_t* ys, int n, int duration, bool spline, int endHoldMs,
+                       const ActionOptions& opts, GesturePlan& out);
+    // 任意像素路径（等时间间隔采样，不含起点）/ Arbitrary pixel path (evenly timed samples, start excluded)
+    void buildPath(int startX, int startY, const int* xs, const int* ys, int count, uint32_t stepUs,
+                   const ActionOptions& opts, GesturePlan& out);
+    void play(const GesturePlan& plan);
+    // 键盘（报告 ID 2）与消费者控制（报告 ID 3）/ Keyboard (report id 2) and consumer control (report id 3)
+    bool typeText(const char* utf8, const TypeOptions& opts, TypeResult& out);
+    bool pressKey(uint8_t keycode, uint8_t modifiers, int holdMs);
+    bool pressConsumer(uint16_t usage, int holdMs);
+    // 按名称查找按键：keycode 非 0 为键盘键，否则 usage 为消费者控制 / Look up a named key: keyboard if keycode != 0, else consumer usage
+    static bool keyByName(const char* name, uint8_t& keycode, uint16_t& usage);
+
+    // 最近一次手势的时序统计 / Timing of the last gesture
+    const GestureTiming& lastTiming() const { return _timing; }
     
     // 重置配对信息并重新广播
     void resetPairing();
@@ -54,23 +146,103 @@ public:
     void tick();
     // WiFi 数据包闪 RX 灯
     void pulseRx(unsigned long durationMs);
+    /**
+     * @brief Streams hover-only (0x04) reports through the real notify path for a while.
+     * @brief 通过真实的 notify 路径持续发送仅悬停（0x04）的报告一段时间。
+     * @param seconds Duration of the run. / 运行时长（秒）。
+     * @param rate Target reports per second, 0 = as fast as possible. / 目标报告频率，0 表示不限速。
+     * @return False if BLE is not connected or no buffer could be allocated.
+     * @return BLE 未连接或无法分配缓冲时返回 false。
+     */
+    bool benchHid(int seconds, int rate, HidBenchResult& out);
+    // notify 结果回调（由特征回调调用）/ notify outcome (called from the characteristic callback)
+    void recordNotifyStatus(bool ok, int code);
+
+    // 链路调节：请求连接参数/PHY/DLE，读取实际值与 RSSI
+    // EN: Link tuning: request interval/PHY/DLE, read back accepted values and RSSI
+    // 协议栈拒绝连接参数请求时返回 false（PHY/DLE 失败只记录日志）/ False when the host refuses the conn-param request (PHY/DLE failures are only logged)
+    bool requestLink(const BleLinkParams& p);
+    bool readLink(BleLinkState& s);
+    // 预设：low_latency(7.5ms)、balanced(30ms，默认)、power(60-100ms，latency 4)
+    // EN: Presets: low_latency (7.5 ms), balanced (30 ms, default), power (60-100 ms, latency 4)
+    static bool linkPreset(const char* name, BleLinkParams& out);
+    // 每次新连接时请求的参数，可写入闪存 / Params requested on every new connection; optionally persisted
+    void setConnectParams(const BleLinkParams& p, bool persist);
+    const BleLinkParams& connectParams() const { return _connectParams; }
+    // 连接计数，用于判断是否为新连接 / Connection counter, tells callers when a new link came up
+    uint32_t connectionCount() const { return _connections; }
+    void onPeerConnected();
+    void onPeerDisconnected();
+
+    // 快速重连：定向 → 高占空比 → 普通广播 / Fast reconnect: directed → high-duty → normal advertising
+    const BleReconnectStats& reconnectStats() const { return _reconnect; }
+    static const char* advPhaseName(BleAdvPhase phase);
+
+    // 关联屏幕校准表（可为 nullptr）/ Attach the screen calibration table (may be nullptr)
+    void setCalibration(const ScreenCalibration* calib) { _calib = calib; _xfGen = 0; _calibSwaps++; }
+    // 校准表被替换或内容变化时改变；此前映射好的数位板坐标随之过期
+    // EN: Changes when the calibration table is swapped or edited; digitizer points mapped before that are stale
+    uint32_t mappingGeneration() const { return (_calib ? _calib->generation() : 0) + _calibSwaps; }
 
 private:
     NimBLEHIDDevice* _hid;
     NimBLECharacteristic* _input;
+    NimBLECharacteristic* _keyboard = nullptr;
+    NimBLECharacteristic* _consumer = nullptr;
     bool _txLedOn = false;
     bool _rxLedOn = false;
     unsigned long _txLedOffAt = 0;
     unsigned long _rxLedOffAt = 0;
     String _deviceName;
     bool _paused = false;
+    BleReconnectStats _reconnect;
+    volatile unsigned long _disconnectAt = 0; // 0 = 未在重连 / not reconnecting
+    NimBLEAddress _lastPeer;
+    bool _hasLastPeer = false;
+    void startReconnectAdvertising();
+    void startAdvertisingPhase(BleAdvPhase phase);
+
+    BleLinkParams _connectParams;
+    bool _connectParamsLoaded = false;
+    void loadConnectParams();
+    void saveConnectParams();
+    volatile uint32_t _connections = 0;
+    volatile uint32_t _notifyOk = 0;
+    volatile uint32_t _notifyFail = 0;
+    volatile int _lastNotifyError = 0;
     
     void pulseLed(bool& ledFlag, unsigned long& offAt, int pin, unsigned long durationMs);
     void clearLeds();
-    void sendRaw(int x, int y, uint8_t state);
-    // mapVal 现在需要传入宽高
-    // EN: mapVal now maps using provided screen size
-    long mapVal(int val, int maxPixel); 
+    bool sendRaw(int x, int y, uint8_t state);
+    // 屏幕像素 → 数位板坐标；定点变换只在屏幕/旋转/校准变化时重算
+    // EN: Screen pixel → digitizer; the fixed-point transform is rebuilt only when screen/rotation/calibration changes
+    void mapPoint(int x, int y, const ActionOptions& opts, long& tx, long& ty);
+    const ScreenCalibration* _calib = nullptr;
+    AffineQ16 _xf;
+    int _xfW = -1;
+    int _xfH = -1;
+    int _xfRot = -1;
+    uint32_t _xfGen = 0;
+    uint32_t _calibSwaps = 0;
+    GesturePlan _scratch;  // click()/swipe() 的临时手势 / scratch plan for click()/swipe()
+    void buildBezier(int x1, int y1, int x2, int y2, int duration, bool fling, const ActionOptions& opts, GesturePlan& out);
+    void fillSwipeTiming(GesturePlan& out, int count, uint32_t stepUs, const ActionOptions& opts);
+
+    // 高精度单次定时器唤醒等待中的任务 / High-resolution one-shot timer that wakes the waiting task
+    esp_timer_handle_t _stepTimer = nullptr;
+    volatile TaskHandle_t _stepWaiter = nullptr;
+    GestureTiming _timing;
+    uint64_t _latenessSumUs = 0;
+    static void onStepTimer(void* arg);
+    void waitUntilUs(int64_t deadlineUs);
+    void emitAt(int64_t deadlineUs, uint16_t x, uint16_t y, uint8_t state);
+    void emitKeyAt(int64_t deadlineUs, uint8_t modifiers, uint8_t keycode);
+    void trackLateness(int64_t deadlineUs);
+    void beginTiming();
+    void endTiming(int64_t startUs, int64_t plannedEndUs);
+    bool sendKeyboard(uint8_t modifiers, uint8_t keycode);
+    bool sendConsumer(uint16_t usage);
+    void noteSend(bool sent);
 };
 
 #endif
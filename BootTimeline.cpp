@@ -0,0 +1,36 @@
+// BootTimeline: stage timestamps from esp_timer (starts counting at power-on/reset).
+// BootTimeline：阶段时间戳取自 esp_timer（上电/复位即开始计时）。
+#include "Config.h"
+#include "BootTimeline.h"
+#include <esp_timer.h>
+
+static const char* const kStageNames[] = {
+    "setup_start", "ble_advertising", "wifi_connected", "http_ready",
+    "ble_connected", "first_hid_report", "ota_check_done",
+};
+static volatile int64_t s_stageUs[(int)BootStage::Count] = {-1, -1, -1, -1, -1, -1, -1};
+
+void BootTimeline::mark(BootStage stage) {
+    int i = (int)stage;
+    if (i < 0 || i >= (int)BootStage::Count || s_stageUs[i] >= 0) return;
+    s_stageUs[i] = esp_timer_get_time();
+    DEBUG_PRINTF("[Boot] %s at %lld ms\n", kStageNames[i], (long long)(s_stageUs[i] / 1000));
+}
+
+int64_t BootTimeline::at(BootStage stage) {
+    int i = (int)stage;
+    if (i < 0 || i >= (int)BootStage::Count) return -1;
+    return s_stageUs[i];
+}
+
+const char* BootTimeline::name(BootStage stage) {
+    int i = (int)stage;
+    if (i < 0 || i >= (int)BootStage::Count) return "unknown";
+    return kStageNames[i];
+}
+
+void BootTimeline::toJson(JsonObject obj) {
+    for (int i = 0; i < (int)BootStage::Count; i++) {
+        if (s_stageUs[i] >= 0) obj[kStageNames[i]] = (float)(s_stageUs[i] / 1000.0);
+    }
+}
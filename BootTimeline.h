@@ -0,0 +1,32 @@
+#ifndef BOOTTIMELINE_H
+#define BOOTTIMELINE_H
+
+// BootTimeline: first-occurrence timestamps of boot stages, measured from power-on.
+// BootTimeline：启动各阶段首次到达的时间戳，从上电开始计时。
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// 启动阶段 / Boot stages
+enum class BootStage : uint8_t {
+    SetupStart = 0,   // 进入 setup() / entered setup()
+    BleAdvertising,   // 蓝牙开始广播 / BLE advertising
+    WifiConnected,    // Wi-Fi 已连接并拿到 IP / Wi-Fi associated with an IP
+    HttpReady,        // HTTP 服务已启动 / HTTP server listening
+    BleConnected,     // 第一次蓝牙连接 / first BLE connection
+    FirstHidReport,   // 第一个 HID 报告发出 / first HID report sent
+    OtaCheckDone,     // 上电 OTA 检查结束 / boot OTA check finished
+    Count
+};
+
+class BootTimeline {
+public:
+    // 记录阶段（只保留第一次）/ Record a stage (first occurrence only)
+    static void mark(BootStage stage);
+    // 阶段时间（微秒，自上电起），未到达为 -1 / Stage time (us since power-on), -1 if not reached
+    static int64_t at(BootStage stage);
+    static const char* name(BootStage stage);
+    // 以毫秒写入 JSON 对象 / Write all reached stages into a JSON object (ms)
+    static void toJson(JsonObject obj);
+};
+
+#endif
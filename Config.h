@@ -20,4 +20,53 @@
 #define DEBUG_PRINTF(...) ((void)0)
 #endif
 
+// EN: Records kept in the binary event ring (power of two, 16 bytes each; lives in .noinit RAM).
+// 中文: 二进制事件环保留的记录数（2 的幂，每条 16 字节，位于 .noinit 内存）。
+#ifndef EVENT_LOG_CAPACITY
+#define EVENT_LOG_CAPACITY 512
+#endif
+
+// EN: TCP port of the SSE listener; GET /events on port 80 redirects here so WebServer never holds the stream.
+// 中文: SSE 监听端口；80 端口的 GET /events 重定向到此处，WebServer 不再持有事件流连接。
+#ifndef SSE_PORT
+#define SSE_PORT 81
+#endif
+
+// EN: Set to 1 to keep NimBLE alive during OTA when PSRAM is present (TLS + download buffers go to PSRAM).
+// 中文: 设为 1 时，若检测到 PSRAM，OTA 期间保持 NimBLE 运行（TLS 与下载缓冲放到 PSRAM）。
+#ifndef OTA_KEEP_BLE_ALIVE
+#define OTA_KEEP_BLE_ALIVE 1
+#endif
+
+// EN: Random extra delay (ms) added to every 12 h OTA manifest check, so a fleet powered on together
+// EN: spreads its requests instead of hitting the server in the same minute.
+// 中文: 每次 12 小时 OTA 清单检查额外加上的随机延迟（毫秒），同时上电的设备群因此错开请求，不会在同一分钟访问服务器。
+#ifndef OTA_CHECK_SPREAD_MS
+#define OTA_CHECK_SPREAD_MS (60UL * 60 * 1000)
+#endif
+
+// EN: Random delay (ms) before the boot-time manifest check; 0 checks right away. It also delays ota_check_done in /sys/boot.
+// 中文: 上电清单检查前的随机延迟（毫秒）；0 表示立即检查。/sys/boot 中的 ota_check_done 也会相应推后。
+#ifndef OTA_BOOT_CHECK_SPREAD_MS
+#define OTA_BOOT_CHECK_SPREAD_MS 0
+#endif
+
+// EN: Store-and-forward for /action with "buffer": true while BLE is down: slots, default and max TTL (ms).
+// 中文: 蓝牙断开时对带 "buffer": true 的 /action 暂存转发：槽位数、默认与最大 TTL（毫秒）。
+#ifndef ACTION_BUFFER_SLOTS
+#define ACTION_BUFFER_SLOTS 8
+#endif
+#ifndef ACTION_BUFFER_DEFAULT_TTL_MS
+#define ACTION_BUFFER_DEFAULT_TTL_MS 5000
+#endif
+#ifndef ACTION_BUFFER_MAX_TTL_MS
+#define ACTION_BUFFER_MAX_TTL_MS 60000
+#endif
+
+// EN: Optional shared token for LAN-pushed OTA (POST /ota?token=...). Empty string disables the check.
+// 中文: 局域网推送 OTA 的可选共享口令（POST /ota?token=...）。为空字符串时不校验。
+#ifndef LAN_OTA_TOKEN
+#define LAN_OTA_TOKEN ""
+#endif
+
 #endif
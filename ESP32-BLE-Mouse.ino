@@ -2,12 +2,26 @@
 #include <ArduinoJson.h>
 #include <WiFi.h>
 #include <esp_heap_caps.h>
+#include <esp_timer.h>
 
 #include "Config.h"
 #include "NetHelper.h"
 #include "BleDriver.h"
 #include "AutoSwipe.h"
 #include "ota.h"
+#include "TimeSync.h"
+#include "SysMonitor.h"
+#include "ScreenCalib.h"
+#include "ActionParser.h"
+#include "ArenaAllocator.h"
+#include "StatusLed.h"
+#include "BootTimeline.h"
+#include "EventLog.h"
+#include "EventStream.h"
+#include "TraceLibrary.h"
+#include "InputArbiter.h"
+#include "LoopProfiler.h"
+#include "ActionBuffer.h"
 
 #define CURRENT_FIRMWARE_VERSION 20251210001LL // YYYYMMDD + 3位序列号, LL表示 long long
 static const uint16_t DISCOVERY_PORT = 48321;
@@ -18,6 +32,66 @@ NetHelper net;
 BleDriver ble;
 WebServer server(80);
 AutoSwipeManager autoSwipe;
+TimeSync timeSync;
+SysMonitor sysMon;
+ScreenCalibration screenCalib;
+EventStream events;
+TraceLibrary traces;
+InputArbiter arbiter;
+LoopProfiler loopProf;
+ActionBuffer actionBuffer;
+
+// EN: Plan for trace/long_press/path/drag/fling of immediate actions; a scheduled (`at`) action builds into
+// EN: `scheduledPlan` instead, so immediate actions can run while it waits and only playback is timed.
+// 中文: 立即执行动作的 trace/long_press/path/drag/fling 手势计划；定时（`at`）动作改为生成到 `scheduledPlan`，
+// 中文: 使其等待期间仍可执行立即动作，且到点后只做回放。
+static GesturePlan prebuilt;
+static GesturePlan scheduledPlan;
+
+// EN: Per-action values resolved by prepareAction() and consumed by runAction() (declared up here so the
+// EN: generated .ino prototypes can see it).
+// 中文: prepareAction() 解析出的逐动作参数，供 runAction() 使用（放在此处，使 .ino 自动生成的函数原型可见）。
+struct ActionPrep {
+    uint8_t keycode = 0;
+    uint16_t usage = 0;
+    TraceInfo traceInfo;
+    GesturePlan* plan = &prebuilt; // EN: Where composite/trace plans are built. / 中文: 组合/轨迹手势计划的生成位置。
+};
+
+// EN: The one pending `at` action: armed by handleAction(), fired from loop() when due, so HTTP, BLE reconnects,
+// EN: discovery and the rest of loop() keep running while it waits.
+// 中文: 唯一待执行的 `at` 动作：由 handleAction() 登记，到点时由 loop() 触发，等待期间 HTTP、蓝牙重连、
+// 中文: 发现等 loop() 其余部分照常运行。
+struct ScheduledAction {
+    bool armed = false;
+    uint32_t id = 0;
+    ParsedAction act;
+    ActionPrep prep;
+    int64_t targetUs = 0; // 第一个报告的本地 esp_timer 时刻 / local esp_timer time of the first report
+};
+static ScheduledAction scheduled;
+static uint32_t scheduledNextId = 1;
+
+// EN: Per-type defaults for the composite gestures (ms).
+// 中文: 组合手势的按类型默认值（毫秒）。
+static const int LONG_PRESS_DEFAULT_MS = 800;
+static const int DRAG_PICKUP_DEFAULT_MS = 500;
+static const int DRAG_DROP_DEFAULT_MS = 150;
+static const int PATH_DEFAULT_DURATION_MS = 400;
+static const int FLING_DEFAULT_DURATION_MS = 120;
+
+// EN: Furthest an `at`-scheduled action may lie in the future; auto-swipe stays deferred while it is pending.
+// 中文: 带 `at` 的定时动作最多可提前多久下发；待执行期间自动上划保持推迟。
+static const int64_t MAX_SCHEDULE_AHEAD_US = 10LL * 1000 * 1000;
+// EN: loop() takes over the final wait this long before `at` (longer than a typical pass, so it is not late).
+// 中文: loop() 在 `at` 之前这么久接管最后的等待（长于一般的单轮耗时，避免迟到）。
+static const int64_t SCHEDULE_FIRE_LEAD_US = 20LL * 1000;
+// EN: An `at` this far in the past still runs at once (request transit time); anything older is refused.
+// 中文: `at` 已过去不超过这么久时仍立即执行（请求在途耗时）；更早的予以拒绝。
+static const int64_t SCHEDULE_PAST_TOLERANCE_US = 5LL * 1000;
+// EN: /bench/hid runs inside the HTTP handler, so loop() (HTTP, SSE, auto-swipe, button) stalls for the whole run.
+// 中文: /bench/hid 在 HTTP 处理函数内运行，整个过程中 loop()（HTTP、SSE、自动上划、按键）都会停顿。
+static const int BENCH_MAX_SECONDS = 5;
 
 // 引脚定义
 const int PIN_BOOT = 0; // BOOT 按键 (IO0, 低电平为按下)
@@ -27,76 +101,623 @@ const int PIN_LED  = 2; // 板载蓝色 LED
 bool bootPressed = false;
 unsigned long bootPressAt = 0;
 bool resettingNow = false;
+StatusLed bootLed; // GPIO2 灯效（恢复出厂快闪）/ GPIO2 pattern engine (factory-reset blink)
+
+// EN: /action body is received chunk-wise into this fixed buffer and parsed into a fixed arena,
+// EN: both reused between requests, so the hot path does no heap allocation of its own.
+// 中文: /action 请求体按块接收到此定长缓冲，并解析到定长 arena，二者在请求间复用，
+// 中文: 因此热路径本身不做任何堆分配。
+static const size_t ACTION_BODY_MAX = 2048;
+static char actionBody[ACTION_BODY_MAX];
+static size_t actionBodyLen = 0;
+static bool actionBodyOverflow = false;
+static int64_t actionArrivedUs = 0; // EN: When the body started arriving (arbiter wait). / 中文: 请求体开始到达的时刻（仲裁等待）。
+static ArenaAllocator<4096> actionArena;
+
+// Raw body callback for POST /action (HTTPRaw chunks)
+void handleActionBody() {
+    HTTPRaw& raw = server.raw();
+    if (raw.status == RAW_START) {
+        actionBodyLen = 0;
+        actionBodyOverflow = false;
+        actionArrivedUs = esp_timer_get_time();
+    } else if (raw.status == RAW_WRITE) {
+        if (actionBodyLen + raw.currentSize > ACTION_BODY_MAX) {
+            actionBodyOverflow = true;
+            return;
+        }
+        memcpy(actionBody + actionBodyLen, raw.buf, raw.currentSize);
+        actionBodyLen += raw.currentSize;
+    } else if (raw.status == RAW_ABORTED) {
+        actionBodyLen = 0;
+    }
+}
+
+// EN: Validates the action and builds `*prep.plan` for trace/composite types. Returns nullptr on success,
+// EN: otherwise the JSON error body with `code` set. Runs again for a held action right before it is forwarded.
+// 中文: 校验动作，并为 trace/组合类型生成 `*prep.plan`。成功返回 nullptr，否则返回 JSON 错误体并设置 `code`。
+// 中文: 暂存的动作在转发前会再次执行。
+static const char* prepareAction(ParsedAction& act, ActionPrep& prep, int& code) {
+    code = 400;
+    if (act.type == ActionType::Unknown) return "{\"error\":\"Unknown type\"}";
 
-// 辅助函数：解析参数
-// Helper: parse JSON options into ActionOptions
-ActionOptions parseOptions(JsonDocument& doc) {
-    ActionOptions opts;
-    if (doc.containsKey("screen_w")) opts.screenW = doc["screen_w"];
-    if (doc.containsKey("screen_h")) opts.screenH = doc["screen_h"];
-    if (doc.containsKey("delay_hover"))    opts.delayHover = doc["delay_hover"];
-    if (doc.containsKey("delay_press"))    opts.delayPress = doc["delay_press"];
-    if (doc.containsKey("delay_interval")) opts.delayInterval = doc["delay_interval"];
-    if (doc.containsKey("delay_release"))  opts.delayRelease = doc["delay_release"];
-    if (doc.containsKey("delay_multi_click_interval")) opts.delayMultiClickInterval = doc["delay_multi_click_interval"];
-    if (doc.containsKey("multi_interval")) opts.delayMultiClickInterval = doc["multi_interval"];
-    if (doc.containsKey("double_check"))   opts.delayDoubleCheck = doc["double_check"];
-    if (doc.containsKey("curve_strength")) opts.curveStrength = doc["curve_strength"];
-    return opts;
+    if (act.type == ActionType::TypeText && (act.text[0] == '\0' || act.textTooLong)) {
+        return "{\"error\":\"text required (max 256 bytes)\"}";
+    }
+    if (act.type == ActionType::Key) {
+        if (act.keyName[0] != '\0') {
+            if (!BleDriver::keyByName(act.keyName, prep.keycode, prep.usage)) return "{\"error\":\"Unknown key\"}";
+        } else if (act.keycode > 0 && act.keycode <= 0xFF) {
+            prep.keycode = (uint8_t)act.keycode;
+        } else {
+            return "{\"error\":\"key or keycode required\"}";
+        }
+    }
+    if (act.type == ActionType::Trace &&
+        !traces.build(act.traceName, act.x1, act.y1, act.x2, act.y2, act.duration, act.opts, ble, *prep.plan, &prep.traceInfo)) {
+        code = 404;
+        return "{\"error\":\"No matching trace\"}";
+    }
+
+    // EN: Composite gestures keep the contact down across segments and run as one report stream.
+    // 中文: 组合手势在各段之间保持按下，作为一个连续的报告流执行。
+    if (act.type == ActionType::Path || act.type == ActionType::Drag) {
+        if (act.tooManyWaypoints || act.waypoints < 2) return "{\"error\":\"points needs 2-16 waypoints\"}";
+        bool drag = act.type == ActionType::Drag;
+        ActionOptions opts = act.opts;
+        if (act.holdMs >= 0) opts.delayPress = act.holdMs;
+        else if (drag) opts.delayPress = DRAG_PICKUP_DEFAULT_MS;
+        int dropMs = act.dropHoldMs >= 0 ? act.dropHoldMs : (drag ? DRAG_DROP_DEFAULT_MS : 0);
+        int duration = act.duration > 0 ? act.duration : PATH_DEFAULT_DURATION_MS;
+        ble.buildPolyline(act.wpX, act.wpY, act.waypoints, duration, act.spline, dropMs, opts, *prep.plan);
+    } else if (act.type == ActionType::LongPress) {
+        ActionOptions opts = act.opts;
+        opts.delayPress = act.holdMs >= 0 ? act.holdMs : LONG_PRESS_DEFAULT_MS;
+        ble.buildClick(act.x, act.y, 1, opts, *prep.plan);
+    } else if (act.type == ActionType::Fling) {
+        int duration = act.duration > 0 ? act.duration : FLING_DEFAULT_DURATION_MS;
+        ble.buildFling(act.x1, act.y1, act.x2, act.y2, duration, act.opts, *prep.plan);
+    }
+    return nullptr;
+}
+
+// EN: Emits the HID reports; the caller holds the digitizer (arbiter) around it.
+// 中文: 发出 HID 报告；调用方负责在前后持有数位板（仲裁）。
+static void runAction(const ParsedAction& act, const ActionPrep& prep, TypeResult& typed) {
+    switch (act.type) {
+    case ActionType::Click:
+        ble.click(act.x, act.y, act.count, act.opts);
+        break;
+    case ActionType::Swipe:
+        ble.swipe(act.x1, act.y1, act.x2, act.y2, act.duration, act.opts);
+        break;
+    case ActionType::TypeText:
+        ble.typeText(act.text, act.typeOpts, typed);
+        break;
+    case ActionType::Key: {
+        int holdMs = act.holdMs >= 0 ? act.holdMs : 40;
+        if (prep.keycode != 0) ble.pressKey(prep.keycode, (uint8_t)act.modifiers, holdMs);
+        else ble.pressConsumer(prep.usage, holdMs);
+        break;
+    }
+    case ActionType::Trace:
+    case ActionType::LongPress:
+    case ActionType::Path:
+    case ActionType::Drag:
+    case ActionType::Fling:
+        ble.play(*prep.plan);
+        break;
+    default:
+        break;
+    }
+}
+
+// EN: Forwards the oldest held action once BLE is back (expired ones are dropped first).
+// EN: Returns false when nothing was forwarded. A mid-gesture disconnect ends it as partial; it is not replayed.
+// 中文: 蓝牙恢复后转发最早的暂存动作（先丢弃过期项）。没有可转发的动作时返回 false。
+// 中文: 手势中途断开记为 partial，不会重放。
+static bool forwardBufferedAction() {
+    actionBuffer.expire();
+    BufferedAction* b = actionBuffer.head();
+    if (!b || !ble.isConnected()) return false;
+
+    BufferedResult r;
+    r.id = b->id;
+    r.heldMs = millis() - b->heldAt;
+    ActionPrep prep;
+    int code;
+    if (prepareAction(b->act, prep, code) != nullptr) {
+        // EN: E.g. the trace library changed while the action was held.
+        // 中文: 例如暂存期间轨迹库发生了变化。
+        r.outcome = BufferedOutcome::Failed;
+        arbiter.cancelManual();
+    } else {
+        TypeResult typed;
+        arbiter.acquireManual(b->arrivedUs);
+        runAction(b->act, prep, typed);
+        arbiter.releaseManual();
+        const GestureTiming& t = ble.lastTiming();
+        r.reports = t.reports;
+        r.failedStep = t.failedStep;
+        r.outcome = t.failedStep >= 0 ? BufferedOutcome::Partial : BufferedOutcome::Ok;
+    }
+    actionBuffer.pop(r);
+    return true;
 }
 
 void handleAction() {
-    if (server.method() != HTTP_POST || server.args() == 0 || server.arg("plain") == "") {
-        server.send(400, "application/json", "{\"error\":\"Body missing\"}");
+    // EN: Admission control: refuse work before allocating anything when the heap is fragmented.
+    // 中文: 准入控制：堆碎片化时在分配任何内存前拒绝请求。
+    if (!sysMon.admit()) {
+        sysMon.rejectLowMemory();
         return;
     }
 
-    String body = server.arg("plain");
-    JsonDocument doc; 
-    DeserializationError error = deserializeJson(doc, body);
+    if (actionBodyOverflow) {
+        server.send_P(413, "application/json", "{\"error\":\"Body too large\"}");
+        return;
+    }
+    if (actionBodyLen == 0) {
+        server.send_P(400, "application/json", "{\"error\":\"Body missing\"}");
+        return;
+    }
+
+    ParsedAction act;
+    {
+        actionArena.reset();
+        JsonDocument doc(&actionArena);
+        DeserializationError error = deserializeJson(doc, (const char*)actionBody, actionBodyLen);
+        actionBodyLen = 0;
+
+        ble.pulseRx(80); // 有 HTTP 数据包时闪烁 RX
+
+        if (error || !parseAction(doc.as<JsonObjectConst>(), act)) {
+            server.send_P(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+            return;
+        }
+    }
 
-    ble.pulseRx(80); // 有 HTTP 数据包时闪烁 RX
+    // EN: Held actions go first so actions keep their arrival order across a reconnect. loop() forwards them one
+    // EN: per pass; a new action joins the back of the buffer instead of draining it here.
+    // 中文: 已暂存的动作先执行，使重连前后的动作保持到达顺序。loop() 每轮转发一个；新动作排到缓冲末尾，
+    // 中文: 而不是在此同步清空缓冲。
+    actionBuffer.expire();
+    bool behindHeld = actionBuffer.depth() > 0;
 
-    if (error) {
+    // EN: "buffer": true opts in to store-and-forward; `at` actions are time-bound and never held.
+    // 中文: "buffer": true 表示允许暂存转发；带 `at` 的动作有时间约束，不暂存。
+    bool holdable = act.buffer && !act.hasAt;
+    if (!ble.isConnected() && !holdable) {
+        server.send_P(503, "application/json", "{\"error\":\"Bluetooth not connected\"}");
+        return;
+    }
+
+    // EN: Optional `at` (synced Unix ms): the first HID report goes out at that instant. One action can be scheduled at a time.
+    // 中文: 可选 `at`（同步后的 Unix 毫秒）：第一个 HID 报告在该时刻发出。同一时间只能有一个定时动作。
+    int64_t target = 0;
+    if (act.hasAt) {
+        if (!timeSync.isFresh()) {
+            server.send_P(409, "application/json",
+                          timeSync.isSynced() ? "{\"error\":\"Clock sync stale\"}" : "{\"error\":\"Clock not synced\"}");
+            return;
+        }
+        target = timeSync.toLocalUs(act.atMs * 1000LL);
+        int64_t ahead = target - (int64_t)esp_timer_get_time();
+        if (ahead > MAX_SCHEDULE_AHEAD_US) {
+            server.send_P(400, "application/json", "{\"error\":\"at too far in the future\"}");
+            return;
+        }
+        if (ahead < -SCHEDULE_PAST_TOLERANCE_US) {
+            server.send_P(409, "application/json", "{\"error\":\"at is in the past\"}");
+            return;
+        }
+        if (scheduled.armed) {
+            server.send_P(409, "application/json", "{\"error\":\"Another action is already scheduled\"}");
+            return;
+        }
+    }
+
+    // EN: Validate before scheduling (or holding) so errors come back immediately.
+    // 中文: 在定时登记（或暂存）之前校验，错误立即返回。
+    ActionPrep prep;
+    if (act.hasAt) prep.plan = &scheduledPlan;
+    int errCode;
+    const char* err = prepareAction(act, prep, errCode);
+    if (err) {
+        server.send_P(errCode, "application/json", err);
+        return;
+    }
+
+    if (!act.hasAt && (!ble.isConnected() || behindHeld)) {
+        uint32_t id = actionBuffer.push(act, actionArrivedUs);
+        if (id == 0) {
+            server.send_P(503, "application/json", "{\"error\":\"Action buffer full\"}");
+            return;
+        }
+        static char held[128];
+        snprintf(held, sizeof(held), "{\"status\":\"buffered\",\"id\":%lu,\"buffer_pos\":%d,\"ttl_ms\":%lu}",
+                 (unsigned long)id, actionBuffer.depth() - 1, (unsigned long)actionBuffer.lastTtlMs());
+        server.send_P(202, "application/json", held);
+        return;
+    }
+
+    // EN: Scheduled: park it and answer now; the pending manual request keeps auto-swipe from starting meanwhile.
+    // 中文: 定时动作：登记后立即回复；待处理的手动请求使自动上划在此期间不会开始。
+    if (act.hasAt) {
+        scheduled.act = act;
+        scheduled.prep = prep;
+        scheduled.targetUs = target;
+        scheduled.id = scheduledNextId++;
+        if (scheduledNextId == 0) scheduledNextId = 1;
+        scheduled.armed = true;
+        uint16_t queuePos = arbiter.enqueueManual();
+        static char armedReply[128];
+        int64_t inUs = target - (int64_t)esp_timer_get_time();
+        snprintf(armedReply, sizeof(armedReply), "{\"status\":\"scheduled\",\"id\":%lu,\"in_ms\":%ld,\"queue_pos\":%u}",
+                 (unsigned long)scheduled.id, (long)(inUs > 0 ? inUs / 1000 : 0), (unsigned)queuePos);
+        server.send_P(202, "application/json", armedReply);
+        return;
+    }
+
+    // EN: Manual actions outrank auto-swipe: take the digitizer now (auto replans after the quiet period).
+    // 中文: 手动动作优先于自动上划：此刻接管数位板（自动上划在静默期后重新排程）。
+    uint16_t queuePos = arbiter.enqueueManual();
+    uint32_t waitUs = arbiter.acquireManual(actionArrivedUs);
+
+    TypeResult typed;
+    runAction(act, prep, typed);
+    arbiter.releaseManual();
+
+    // EN: Gesture timing: overrun vs the planned duration and per-report lateness vs its deadline.
+    // EN: A disconnect mid-gesture answers 503 with "status":"partial" and the index of the first unsent report.
+    // 中文: 手势时序：相对计划时长的超时，以及每个报告相对其截止时间的偏差。
+    // 中文: 手势中途断开时返回 503，"status":"partial"，并给出第一个未发出的报告序号。
+    const GestureTiming& t = ble.lastTiming();
+    bool partial = t.failedStep >= 0;
+    static char reply[320];
+    int n = snprintf(reply, sizeof(reply),
+                     "{\"status\":\"%s\",\"planned_us\":%lu,\"actual_us\":%lu,\"overrun_us\":%ld,"
+                     "\"reports\":%u,\"jitter_avg_us\":%lu,\"jitter_max_us\":%lu,\"queue_pos\":%u,\"wait_us\":%lu",
+                     partial ? "partial" : "ok", (unsigned long)t.plannedUs, (unsigned long)t.actualUs, (long)t.overrunUs,
+                     (unsigned)t.reports, (unsigned long)t.jitterAvgUs, (unsigned long)t.jitterMaxUs,
+                     (unsigned)queuePos, (unsigned long)waitUs);
+    if (partial) {
+        n += snprintf(reply + n, sizeof(reply) - n, ",\"failed_step\":%d", t.failedStep);
+    }
+    if (act.type == ActionType::TypeText) {
+        n += snprintf(reply + n, sizeof(reply) - n, ",\"typed\":%u,\"skipped\":%u", typed.typed, typed.skipped);
+    }
+    if (act.type == ActionType::Trace) {
+        n += snprintf(reply + n, sizeof(reply) - n, ",\"trace\":%d,\"trace_points\":%u",
+                      prep.traceInfo.index, (unsigned)prep.traceInfo.points);
+    }
+    snprintf(reply + n, sizeof(reply) - n, "}");
+    server.send_P(partial ? 503 : 200, "application/json", reply);
+}
+
+// EN: Fires the scheduled action once `at` is within SCHEDULE_FIRE_LEAD_US: waits out the rest, plays it and
+// EN: publishes the outcome as an SSE "scheduled_result" event (late_us = first report vs `at`).
+// 中文: `at` 进入 SCHEDULE_FIRE_LEAD_US 之内时触发定时动作：等完剩余时间后执行，并以 SSE "scheduled_result"
+// 中文: 事件发布结果（late_us = 第一个报告相对 `at` 的偏差）。
+static void fireScheduledAction() {
+    if (!scheduled.armed || scheduled.targetUs - (int64_t)esp_timer_get_time() > SCHEDULE_FIRE_LEAD_US) return;
+    scheduled.armed = false;
+    if (!ble.isConnected()) {
+        arbiter.cancelManual();
+        events.publishf("scheduled_result", "{\"id\":%lu,\"status\":\"failed\",\"error\":\"Bluetooth not connected\"}",
+                        (unsigned long)scheduled.id);
+        return;
+    }
+
+    // EN: Waiting is measured from `at`, so the arbiter's manual wait only shows lateness.
+    // 中文: 等待从 `at` 起算，仲裁的手动等待只反映迟到部分。
+    arbiter.acquireManual(scheduled.targetUs);
+    int64_t lateUs = TimeSync::sleepUntilLocalUs(scheduled.targetUs);
+    TypeResult typed;
+    runAction(scheduled.act, scheduled.prep, typed);
+    arbiter.releaseManual();
+
+    const GestureTiming& t = ble.lastTiming();
+    events.publishf("scheduled_result",
+                    "{\"id\":%lu,\"status\":\"%s\",\"late_us\":%ld,\"overrun_us\":%ld,\"reports\":%u,\"failed_step\":%d}",
+                    (unsigned long)scheduled.id, t.failedStep >= 0 ? "partial" : "ok", (long)lateUs, (long)t.overrunUs,
+                    (unsigned)t.reports, t.failedStep);
+}
+
+// EN: GET /time_sync: offset, error bound and server; POST /time_sync {host, port, interval_ms} to configure.
+// 中文: GET /time_sync 返回偏移、误差界与服务器；POST /time_sync {host, port, interval_ms} 进行配置。
+void handleTimeSyncGet() {
+    ble.pulseRx(80);
+    StaticJsonDocument<256> doc;
+    doc["synced"] = timeSync.isSynced();
+    doc["fresh"] = timeSync.isFresh();
+    doc["offset_us"] = timeSync.offsetUs();
+    doc["error_us"] = timeSync.errorUs();
+    doc["rtt_us"] = timeSync.rttUs();
+    doc["age_ms"] = timeSync.lastSyncAgeMs();
+    doc["samples"] = timeSync.samples();
+    doc["now_ms"] = timeSync.isSynced() ? timeSync.nowUs() / 1000 : 0;
+    doc["host"] = timeSync.host();
+    doc["port"] = timeSync.port();
+    doc["interval_ms"] = timeSync.intervalMs();
+    String out;
+    serializeJson(doc, out);
+    server.send(200, "application/json", out);
+}
+
+void handleTimeSyncPost() {
+    ble.pulseRx(80);
+    StaticJsonDocument<192> doc;
+    if (deserializeJson(doc, server.arg("plain"))) {
         server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
         return;
     }
+    timeSync.configure(doc["host"] | "", doc["port"] | 48330, doc["interval_ms"] | 10000);
+    server.send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+// EN: POST /bench/hid {seconds, rate}: streams hover-only reports and returns rate, failures, jitter and link params.
+// EN: Blocks for up to BENCH_MAX_SECONDS; a timed loop() section would skew the very jitter it measures.
+// 中文: POST /bench/hid {seconds, rate}：持续发送仅悬停报告，返回速率、失败数、抖动与连接参数。
+// 中文: 最多阻塞 BENCH_MAX_SECONDS 秒；拆到 loop() 中分段执行会让被测的抖动本身失真。
+void handleBenchHid() {
+    ble.pulseRx(80);
+    StaticJsonDocument<128> req;
+    if (server.hasArg("plain") && server.arg("plain").length() > 0 && deserializeJson(req, server.arg("plain"))) {
+        server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+        return;
+    }
+    int seconds = constrain((int)(req["seconds"] | 3), 1, BENCH_MAX_SECONDS);
+    int rate = constrain((int)(req["rate"] | 0), 0, 2000);
 
     if (!ble.isConnected()) {
-        server.send(503, "application/json", "{\"error\":\"Bluetooth not connected\"}");
+        server.send(503, "application/json", "{\"error\":\"BLE not connected\"}");
         return;
     }
 
-    String type = doc["type"].as<String>();
-    ActionOptions opts = parseOptions(doc);
-    
-    if (type == "click") {
-        int x = doc["x"];
-        int y = doc["y"];
-        int count = doc.containsKey("count") ? max(1, doc["count"].as<int>()) : 1;
-        ble.click(x, y, count, opts);
-    } else if (type == "swipe") {
-        int x1 = doc["x1"];
-        int y1 = doc["y1"];
-        int x2 = doc["x2"];
-        int y2 = doc["y2"];
-        int duration = doc["duration"]; 
-        ble.swipe(x1, y1, x2, y2, duration, opts);
-    } else {
-        server.send(400, "application/json", "{\"error\":\"Unknown type\"}");
+    HidBenchResult r;
+    arbiter.enqueueManual();
+    arbiter.acquireManual(0);
+    bool started = ble.benchHid(seconds, rate, r);
+    arbiter.releaseManual();
+    if (!started) {
+        server.send(503, "application/json", "{\"error\":\"Bench failed to start\"}");
         return;
     }
 
-    server.send(200, "application/json", "{\"status\":\"ok\"}");
+    StaticJsonDocument<512> doc;
+    doc["seconds"] = seconds;
+    doc["target_rate"] = rate;
+    doc["attempted"] = r.attempted;
+    doc["notify_ok"] = r.notifyOk;
+    doc["notify_fail"] = r.notifyFail;
+    doc["last_error"] = r.lastError;
+    doc["elapsed_ms"] = r.elapsedUs / 1000;
+    doc["reports_per_sec"] = r.reportsPerSec;
+    JsonObject jitter = doc.createNestedObject("interval_us");
+    jitter["p50"] = r.p50Us;
+    jitter["p90"] = r.p90Us;
+    jitter["p99"] = r.p99Us;
+    jitter["max"] = r.maxUs;
+    JsonObject conn = doc.createNestedObject("conn");
+    conn["interval_ms"] = r.connInterval * 1.25f;
+    conn["latency"] = r.connLatency;
+    conn["timeout_ms"] = r.supervisionTimeout * 10;
+    conn["mtu"] = r.mtu;
+    String out;
+    serializeJson(doc, out);
+    server.send(200, "application/json", out);
+}
+
+// EN: Outstanding POST /ble/link request: loop() watches for the central's answer (publishLinkEvents) and
+// EN: publishes it as an SSE "link" event, so the handler itself never waits.
+// 中文: 尚未应答的 POST /ble/link 请求：由 loop()（publishLinkEvents）观察中心设备的应答并以 SSE "link" 事件发布，
+// 中文: 处理函数本身从不等待。
+static bool linkWatchActive = false;
+static unsigned long linkWatchStart = 0;
+static unsigned long linkWatchMs = 0;
+static unsigned long linkWatchPolledAt = 0;
+static uint16_t linkWatchMin = 0;
+static uint16_t linkWatchMax = 0;
+
+// EN: Fills the live link state (what the central accepted) plus the per-connection defaults.
+// 中文: 填充当前链路状态（中心设备实际接受的值）以及每个连接的默认参数。
+static void fillLinkJson(JsonDocument& doc) {
+    BleLinkState st;
+    doc["connected"] = ble.readLink(st);
+    doc["request_pending"] = linkWatchActive;
+    doc["interval_ms"] = st.interval * 1.25f;
+    doc["latency"] = st.latency;
+    doc["timeout_ms"] = st.timeout * 10;
+    doc["mtu"] = st.mtu;
+    doc["tx_phy"] = st.txPhy;
+    doc["rx_phy"] = st.rxPhy;
+    doc["rssi"] = st.rssi;
+    const BleReconnectStats& rc = ble.reconnectStats();
+    doc["adv_phase"] = BleDriver::advPhaseName(rc.phase);
+    doc["reconnects"] = rc.reconnects;
+    doc["reconnect_ms"] = rc.lastMs;
+    doc["reconnect_via"] = BleDriver::advPhaseName(rc.lastVia);
+    const BleLinkParams& d = ble.connectParams();
+    JsonObject def = doc.createNestedObject("on_connect");
+    def["min_interval_ms"] = d.minInterval * 1.25f;
+    def["max_interval_ms"] = d.maxInterval * 1.25f;
+    def["latency"] = d.latency;
+    def["timeout_ms"] = d.timeout * 10;
+    def["phy"] = d.phy;
+    def["dle"] = d.dle;
+}
+
+// EN: GET /ble/link: live interval/latency/timeout/PHY/RSSI. POST /ble/link: request new params for this connection.
+// 中文: GET /ble/link 返回当前间隔/延迟/超时/PHY/RSSI；POST /ble/link 为当前连接请求新参数。
+void handleBleLinkGet() {
+    ble.pulseRx(80);
+    StaticJsonDocument<384> doc;
+    fillLinkJson(doc);
+    String out;
+    serializeJson(doc, out);
+    server.send(200, "application/json", out);
+}
+
+void handleBleLinkPost() {
+    ble.pulseRx(80);
+    StaticJsonDocument<256> req;
+    if (deserializeJson(req, server.arg("plain"))) {
+        server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+        return;
+    }
+
+    BleLinkParams p = ble.connectParams();
+    if (req.containsKey("preset") && !BleDriver::linkPreset(req["preset"].as<const char*>(), p)) {
+        server.send(400, "application/json", "{\"error\":\"Unknown preset\"}");
+        return;
+    }
+    // EN: Explicit fields override the preset; intervals in ms (7.5-4000), timeout in ms (100-32000).
+    // 中文: 显式字段覆盖预设；间隔单位 ms（7.5-4000），超时单位 ms（100-32000）。
+    if (req.containsKey("min_interval_ms")) p.minInterval = constrain((int)(req["min_interval_ms"].as<float>() / 1.25f + 0.5f), 6, 3200);
+    if (req.containsKey("max_interval_ms")) p.maxInterval = constrain((int)(req["max_interval_ms"].as<float>() / 1.25f + 0.5f), 6, 3200);
+    if (req.containsKey("latency")) p.latency = constrain(req["latency"].as<int>(), 0, 499);
+    if (req.containsKey("timeout_ms")) p.timeout = constrain(req["timeout_ms"].as<int>() / 10, 10, 3200);
+    if (req.containsKey("phy")) {
+        const char* phy = req["phy"] | "";
+        p.phy = strcmp(phy, "2m") == 0 ? 2 : (strcmp(phy, "1m") == 0 ? 1 : 0);
+    }
+    if (req.containsKey("dle")) p.dle = req["dle"];
+    if (p.maxInterval < p.minInterval) p.maxInterval = p.minInterval;
+
+    // EN: "on_connect": true also makes these the defaults for future connections (persisted).
+    // 中文: "on_connect": true 时同时作为之后每次连接的默认参数（写入闪存）。
+    if (req["on_connect"] | false) ble.setConnectParams(p, true);
+
+    if (!ble.isConnected()) {
+        server.send(503, "application/json", "{\"error\":\"BLE not connected\"}");
+        return;
+    }
+    if (!ble.requestLink(p)) {
+        server.send(409, "application/json", "{\"error\":\"Link request refused (update in progress?)\"}");
+        return;
+    }
+
+    // EN: The central answers asynchronously: reply now; loop() reports the outcome within `wait_ms` as SSE "link".
+    // 中文: 中心设备异步应答：立即回复；loop() 在 `wait_ms` 内以 SSE "link" 事件报告结果。
+    linkWatchActive = true;
+    linkWatchStart = millis();
+    linkWatchPolledAt = 0;
+    linkWatchMs = constrain((int)(req["wait_ms"] | 1000), 0, 3000);
+    linkWatchMin = p.minInterval;
+    linkWatchMax = p.maxInterval;
+
+    StaticJsonDocument<512> doc;
+    doc["status"] = "requested";
+    doc["requested_min_interval_ms"] = p.minInterval * 1.25f;
+    doc["requested_max_interval_ms"] = p.maxInterval * 1.25f;
+    doc["wait_ms"] = linkWatchMs;
+    fillLinkJson(doc);
+    String out;
+    serializeJson(doc, out);
+    server.send(202, "application/json", out);
+}
+
+// EN: Polls the live link every 50 ms while a request is outstanding; publishes once it matches or `wait_ms` runs out.
+// 中文: 有未应答请求时每 50ms 读取一次链路；匹配或 `wait_ms` 用尽时发布一次结果。
+static void watchLinkRequest() {
+    if (!linkWatchActive) return;
+    unsigned long now = millis();
+    if (now - linkWatchPolledAt < 50) return;
+    linkWatchPolledAt = now;
+    BleLinkState st;
+    bool up = ble.readLink(st);
+    bool accepted = up && st.interval >= linkWatchMin && st.interval <= linkWatchMax;
+    if (up && !accepted && now - linkWatchStart < linkWatchMs) return;
+    linkWatchActive = false;
+    events.publishf("link", "{\"accepted\":%s,\"interval_ms\":%.2f,\"latency\":%u,\"timeout_ms\":%u,\"waited_ms\":%lu}",
+                    accepted ? "true" : "false", st.interval * 1.25f, (unsigned)st.latency, (unsigned)st.timeout * 10,
+                    now - linkWatchStart);
+}
+
+// EN: GET /net/wifi: link state and outage statistics from the Wi-Fi supervisor.
+// 中文: GET /net/wifi：Wi-Fi 守护提供的链路状态与断线统计。
+void handleNetWifi() {
+    ble.pulseRx(80);
+    const WifiStats& st = net.wifiStats();
+    StaticJsonDocument<384> doc;
+    doc["connected"] = WiFi.status() == WL_CONNECTED;
+    doc["rssi"] = WiFi.RSSI();
+    doc["bssid"] = WiFi.BSSIDstr();
+    doc["channel"] = WiFi.channel();
+    doc["outages"] = st.outages;
+    doc["current_outage_ms"] = net.currentOutageMs();
+    doc["last_outage_ms"] = st.lastOutageMs;
+    doc["longest_outage_ms"] = st.longestOutageMs;
+    doc["total_outage_ms"] = st.totalOutageMs;
+    doc["fast_reconnects"] = st.fastReconnects;
+    doc["scan_reconnects"] = st.scanReconnects;
+    String out;
+    serializeJson(doc, out);
+    server.send(200, "application/json", out);
+}
+
+// EN: GET /sys/boot: per-stage boot timestamps (ms since power-on), the reset reason and the OTA download state.
+// 中文: GET /sys/boot：各启动阶段时间戳（自上电起的毫秒）、复位原因与 OTA 下载状态。
+void handleSysBoot() {
+    ble.pulseRx(80);
+    StaticJsonDocument<512> doc;
+    BootTimeline::toJson(doc.createNestedObject("stages_ms"));
+    doc["reset_reason"] = (int)esp_reset_reason();
+    doc["uptime_ms"] = millis();
+    JsonObject o = doc.createNestedObject("ota");
+    o["updating"] = ota.isUpdating();
+    o["internal_low_water"] = ota.getLastOtaInternalLowWater();
+    String out;
+    serializeJson(doc, out);
+    server.send(200, "application/json", out);
+}
+
+// EN: First SSE message for a new subscriber: the state a dashboard needs before deltas arrive.
+// 中文: 新订阅者收到的第一条 SSE：面板在接收增量前需要的状态。
+static void fillEventSnapshot(char* buf, size_t size) {
+    snprintf(buf, size, "{\"ble\":%s,\"wifi\":%s,\"auto_swipe\":%s,\"next_ms\":%ld,\"adv_phase\":\"%s\"}",
+             ble.isConnected() ? "true" : "false", WiFi.status() == WL_CONNECTED ? "true" : "false",
+             autoSwipe.isEnabled() ? "true" : "false", autoSwipe.nextActionInMs(),
+             BleDriver::advPhaseName(ble.reconnectStats().phase));
+}
+
+// EN: Publish BLE/Wi-Fi transitions as SSE deltas (edge-triggered, nothing is sent while stable).
+// 中文: 把蓝牙/Wi-Fi 的状态变化作为 SSE 增量推送（边沿触发，稳定时不发送）。
+static void publishLinkEvents() {
+    watchLinkRequest();
+    static bool lastBle = false;
+    static bool lastWifi = false;
+    bool bleUp = ble.isConnected();
+    bool wifiUp = WiFi.status() == WL_CONNECTED;
+    if (bleUp != lastBle) {
+        lastBle = bleUp;
+        if (bleUp) {
+            events.publishf("ble", "{\"connected\":true,\"reconnect_ms\":%lu}",
+                            (unsigned long)ble.reconnectStats().lastMs);
+        } else {
+            events.publish("ble", "{\"connected\":false}");
+        }
+    }
+    // EN: Only the recovery is published: while Wi-Fi is down no subscriber can be reached, and outage_ms covers the gap.
+    // 中文: 只推送恢复事件：Wi-Fi 断开期间任何订阅者都收不到，断线时长由 outage_ms 给出。
+    if (wifiUp != lastWifi) {
+        lastWifi = wifiUp;
+        if (wifiUp) {
+            events.publishf("wifi", "{\"connected\":true,\"outage_ms\":%lu}",
+                            (unsigned long)net.wifiStats().lastOutageMs);
+        }
+    }
 }
 
 void setup() {
+    BootTimeline::mark(BootStage::SetupStart);
+    EventLog::begin();
     DEBUG_SERIAL_BEGIN(115200);
     randomSeed(analogRead(0));
 
     pinMode(PIN_BOOT, INPUT_PULLUP);
-    pinMode(PIN_LED, OUTPUT);
-    digitalWrite(PIN_LED, LOW);
+    bootLed.beginGpio(PIN_LED, true);
 
     DEBUG_PRINTF("PSRAM: %s, size=%d, free_psram=%d, free_internal=%d\n",
         psramFound() ? "yes" : "no",
@@ -112,29 +733,47 @@ void setup() {
     // 中文: 在启动 Wi-Fi 前，将 OTA/LED 控制器关联到网络助手。
     net.setOtaUpdater(&ota);
 
-    // 1. 自动配网 (阻塞式，直到连上 WiFi 才会继续)
-    // EN: Auto WiFi provisioning (blocking until WiFi is connected)
+    // 1. 蓝牙先启动：使用上次启动缓存的名字，已绑定手机无需等待 Wi-Fi/DHCP/OTA 即可重连
+    // EN: Start BLE first with the name cached on the last boot, so bonded phones reconnect
+    // EN: without waiting for Wi-Fi association, DHCP and the OTA handshake.
+    ble.begin(net.getCachedBleName());
+    ota.setBleDriver(&ble);
+
+    // 2. 自动配网 (阻塞式，直到连上 WiFi 才会继续；期间蓝牙已在工作)
+    // EN: Auto WiFi provisioning (blocking until WiFi is connected; BLE is already running)
     // 第一次运行请用手机连接 "Wacom-Setup-xxxx" 热点进行配置
     // EN: On first boot, connect to the "Wacom-Setup-xxxx" AP with a phone/PC to configure WiFi
     net.autoConfig();
+    BootTimeline::mark(BootStage::WifiConnected);
+
+    // EN: From here on the supervisor owns reconnects (cached BSSID/channel first, then scans with backoff).
+    // 中文: 此后由守护逻辑负责重连（先用缓存的 BSSID/信道，再带退避的全信道扫描）。
+    net.beginWifiSupervisor();
     
     // EN: Turn off AP mode LED after successful Wi-Fi connection.
     // 中文: Wi-Fi 连接成功后关闭 AP 模式指示灯。
     ota.setApModeLed(false);
-    
-    // EN: Perform an OTA check immediately after Wi-Fi is connected.
-    // 中文: 在 Wi-Fi 连接后执行一次上电 OTA 检查。
-    ota.checkAndUpdate();
+
+    // 3. 网络通了之后，根据 IP 生成蓝牙名；与缓存不同时更新广播并保存给下次启动
+    // EN: With the IP known, refresh the BLE name if it changed and cache it for the next boot
+    String bleName = net.getDynamicBleName();
+    ble.setDeviceName(bleName);
+    net.cacheBleName(bleName);
 
     // EN: Start UDP discovery responder for PC-side scanning.
     // 中文: 启动 UDP 发现响应器，便于 PC 端扫描。
     net.beginDiscoveryResponder(DISCOVERY_PORT, DISCOVERY_MAGIC, String(CURRENT_FIRMWARE_VERSION));
-    
-    // 2. 网络通了之后，根据 IP 生成蓝牙名
-    // EN: After WiFi is up, generate BLE name based on IP
-    String bleName = net.getDynamicBleName();
-    ble.begin(bleName);
-    ota.setBleDriver(&ble);
+    net.setDiscoveryHints([](DiscoveryHints& h) {
+        h.bleConnected = ble.isConnected();
+        // EN: Pending manual requests already count held /action items (ActionBuffer registers each one).
+        // 中文: 待处理手动请求已包含暂存的 /action（ActionBuffer 每暂存一条即登记一次）。
+        h.queueDepth = arbiter.pendingManual();
+        h.busy = arbiter.owner() != InputOwner::Idle;
+    });
+
+    // EN: Fleet clock sync for `at`-scheduled actions.
+    // 中文: 集群时钟同步，用于带 `at` 的定时动作。
+    timeSync.begin();
 
     // 重置 WiFi 的接口
     server.on("/reset_wifi", HTTP_GET, []() {
@@ -145,22 +784,82 @@ void setup() {
         ESP.restart(); // 重启后就会重新出现 Wacom-Setup 热点
     });
     
+    // EN: Heap/stack telemetry (GET/POST /sys/heap) and admission control.
+    // 中文: 堆/栈遥测（GET/POST /sys/heap）与准入控制。
+    sysMon.begin(&server);
+
+    // EN: Per-subsystem loop() timing and worst stalls (GET/POST /sys/loop).
+    // 中文: 按子系统统计 loop() 耗时与最严重卡顿（GET/POST /sys/loop）。
+    loopProf.begin(&server);
+
+    // EN: Per-screen affine calibration (GET/POST /calibrate), applied by BleDriver to every point.
+    // 中文: 按屏幕尺寸的仿射校准（GET/POST /calibrate），由 BleDriver 应用于每个坐标点。
+    screenCalib.begin(&server);
+    ble.setCalibration(&screenCalib);
+
+    // EN: Recorded human traces in LittleFS (GET/POST/DELETE /traces), replayed by the `trace` action.
+    // 中文: LittleFS 中的真人轨迹库（GET/POST/DELETE /traces），由 `trace` 动作回放。
+    traces.begin(&server);
+
     // 自动上划接口注册
+    autoSwipe.setSysMonitor(&sysMon);
     autoSwipe.begin(&server, &ble);
+    events.setSnapshot(fillEventSnapshot);
+    events.begin(&server);
+    autoSwipe.setEventStream(&events);
+
+    // EN: Manual /action vs auto-swipe priority (GET/POST /arbiter).
+    // 中文: 手动 /action 与自动上划的优先级仲裁（GET/POST /arbiter）。
+    arbiter.begin(&server);
+    autoSwipe.setArbiter(&arbiter);
+    // EN: Store-and-forward for "buffer": true actions while BLE is down (GET /action/queue).
+    // 中文: 蓝牙断开时暂存带 "buffer": true 的动作（GET /action/queue）。
+    actionBuffer.begin(&server, &arbiter, &events);
+
+    // EN: LAN-pushed OTA: POST /ota?md5=...|sha256=... with the raw .bin as body.
+    // 中文: 局域网推送 OTA：POST /ota?md5=...|sha256=...，请求体为原始 .bin。
+    ota.attachLanUpload(&server);
 
-    server.on("/action", HTTP_POST, handleAction);
+    // EN: The second callback receives the body in chunks, so WebServer never builds the "plain" String.
+    // 中文: 第二个回调按块接收请求体，WebServer 不再构造 "plain" String。
+    server.on("/action", HTTP_POST, handleAction, handleActionBody);
+    server.on("/time_sync", HTTP_GET, handleTimeSyncGet);
+    server.on("/time_sync", HTTP_POST, handleTimeSyncPost);
+    server.on("/bench/hid", HTTP_POST, handleBenchHid);
+    server.on("/ble/link", HTTP_GET, handleBleLinkGet);
+    server.on("/ble/link", HTTP_POST, handleBleLinkPost);
+    server.on("/sys/boot", HTTP_GET, handleSysBoot);
+    EventLog::attachHttp(&server);
+    server.on("/net/wifi", HTTP_GET, handleNetWifi);
     server.begin();
+    BootTimeline::mark(BootStage::HttpReady);
     DEBUG_PRINTLN("[System] Ready. Control: http://" + net.getLocalIP() + "/action");
+
+    // 4. 上电 OTA 检查放到后台任务，不再阻塞启动
+    // EN: The boot OTA check runs in a background task instead of blocking boot.
+    ota.startBackgroundCheck(OTA_BOOT_CHECK_SPREAD_MS);
 }
 
 void loop() {
-    server.handleClient();
-    autoSwipe.tick();
-    ble.tick();
-    net.tickDiscovery();
+    // EN: Each lap charges the time since the previous one to a subsystem (one esp_timer read per call).
+    // 中文: 每个 lap 把距上一次的时间记到一个子系统（每次调用只读一次 esp_timer）。
+    uint32_t c = loopProf.beginPass();
+    fireScheduledAction();   c = loopProf.lap(LoopSection::Scheduled, c);
+    server.handleClient();   c = loopProf.lap(LoopSection::Http, c);
+    forwardBufferedAction(); c = loopProf.lap(LoopSection::ActionBuffer, c);
+    autoSwipe.tick();        c = loopProf.lap(LoopSection::AutoSwipe, c);
+    ble.tick();              c = loopProf.lap(LoopSection::Ble, c);
+    net.tickWifi();          c = loopProf.lap(LoopSection::Wifi, c);
+    net.tickDiscovery();     c = loopProf.lap(LoopSection::Discovery, c);
+    timeSync.tick();         c = loopProf.lap(LoopSection::TimeSync, c);
+    sysMon.tick();           c = loopProf.lap(LoopSection::SysMon, c);
+    EventLog::tick();        c = loopProf.lap(LoopSection::EventLog, c);
+    publishLinkEvents();
+    events.tick();           c = loopProf.lap(LoopSection::Events, c);
     // EN: Handle timed OTA polling and system status LED.
     // 中文: 处理 OTA 定时轮询和系统状态灯。
     ota.tick(WiFi.status() == WL_CONNECTED, ble.isConnected());
+    c = loopProf.lap(LoopSection::Ota, c);
 
     // 检测 BOOT 按键长按以恢复出厂设置
     int btn = digitalRead(PIN_BOOT);
@@ -171,24 +870,30 @@ void loop() {
         } else if (!resettingNow && millis() - bootPressAt >= 2000) {
             resettingNow = true;
 
-            // LED 快闪 25 次
-            for (int i = 0; i < 25; i++) {
-                digitalWrite(PIN_LED, HIGH);
-                delay(120);
-                digitalWrite(PIN_LED, LOW);
-                delay(120);
-            }
-
-            // 清除 BLE 配对与 WiFi 配置
-            ble.resetPairing();
-            WiFi.disconnect(true, true); // 断开并清空凭证
-            net.resetSettings();         // 清除 WiFiManager/静态 IP
-
-            DEBUG_PRINTLN("Rebooting..");
-            delay(200);
-            ESP.restart();
+            // LED 快闪 25 次（非阻塞，播完后再执行清除）
+            // EN: Blink 25x (120ms on / 120ms off) without blocking; the reset runs once it finishes.
+            LedPattern blink;
+            blink.mode = LedMode::Blink;
+            blink.color = 1;
+            blink.periodMs = 240;
+            blink.repeats = 25;
+            bootLed.play(blink);
         }
     } else {
         bootPressed = false;
     }
+
+    bootLed.tick();
+    loopProf.lap(LoopSection::Button, c);
+    loopProf.endPass();
+    if (resettingNow && bootLed.isDone()) {
+        // 清除 BLE 配对与 WiFi 配置
+        ble.resetPairing();
+        WiFi.disconnect(true, true); // 断开并清空凭证
+        net.resetSettings();         // 清除 WiFiManager/静态 IP
+
+        DEBUG_PRINTLN("Rebooting..");
+        delay(200);
+        ESP.restart();
+    }
 }
@@ -0,0 +1,202 @@
+// EventLog: ring storage, Serial drain and the GET /log endpoint.
+// EventLog：环形存储、串口输出与 GET /log 接口。
+#include "Config.h"
+#include "EventLog.h"
+#include <esp_attr.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+
+static_assert((EVENT_LOG_CAPACITY & (EVENT_LOG_CAPACITY - 1)) == 0, "EVENT_LOG_CAPACITY must be a power of two");
+static_assert(sizeof(LogRecord) == 16, "LogRecord must stay 16 bytes (tools/log_decode reads it raw)");
+
+static const uint32_t kRingMagic = 0x454C4F47; // "ELOG"
+static const uint32_t kRingMask = EVENT_LOG_CAPACITY - 1;
+
+// /log 二进制格式的文件头 / Header of the /log binary dump
+struct LogDumpHeader {
+    char magic[4];      // "ELOG"
+    uint8_t version;    // 2：每段一个文件头 / 2: one header per chunk
+    uint8_t recordSize; // sizeof(LogRecord)
+    uint16_t boot;      // 当前启动序号 / current boot number
+    uint32_t firstSeq;  // 本段第一条记录的序号 / sequence number of the chunk's first record
+    uint32_t count;     // 本段记录条数（连续序号）/ records in this chunk (consecutive seqs)
+};
+
+// 软重启不清零：.noinit 段不参与启动时初始化 / Not cleared on soft reboot: .noinit is skipped by startup init
+struct LogRing {
+    uint32_t magic;
+    uint32_t head;      // 已写入总数（单调递增）/ records ever written (monotonic)
+    uint32_t drained;   // 已输出到串口的序号 / next sequence to print on Serial
+    uint16_t boot;
+    uint16_t reserved;
+    LogRecord rec[EVENT_LOG_CAPACITY];
+};
+static __NOINIT_ATTR LogRing s_ring;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_ready = false;
+static WebServer* s_server = nullptr;
+
+static const char* const kEventNames[] = {
+#define LOG_EVENT(name, fmt) #name,
+#include "LogEvents.def"
+#undef LOG_EVENT
+};
+static const char* const kEventFormats[] = {
+#define LOG_EVENT(name, fmt) fmt,
+#include "LogEvents.def"
+#undef LOG_EVENT
+};
+
+void EventLog::begin() {
+    esp_reset_reason_t reason = esp_reset_reason();
+    bool coldBoot = reason == ESP_RST_POWERON || reason == ESP_RST_BROWNOUT || reason == ESP_RST_UNKNOWN;
+    bool valid = s_ring.magic == kRingMagic && s_ring.head - s_ring.drained <= (uint32_t)EVENT_LOG_CAPACITY * 2;
+    if (coldBoot || !valid) {
+        // 上电后 RAM 内容随机，重建空环 / RAM is random after power-on: start an empty ring
+        s_ring.magic = kRingMagic;
+        s_ring.head = 0;
+        s_ring.drained = 0;
+        s_ring.boot = 0;
+    } else {
+        s_ring.boot++;
+    }
+    s_ready = true;
+    log(LogEvent::Boot, s_ring.boot, (int32_t)reason);
+}
+
+void EventLog::log(LogEvent id, int32_t a, int32_t b) {
+    if (!s_ready) return;
+    uint32_t ts = (uint32_t)(esp_timer_get_time() / 1000);
+    portENTER_CRITICAL_SAFE(&s_lock);
+    LogRecord& r = s_ring.rec[s_ring.head & kRingMask];
+    r.tsMs = ts;
+    r.id = (uint16_t)id;
+    r.boot = s_ring.boot;
+    r.a = a;
+    r.b = b;
+    s_ring.head++;
+    portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+const char* EventLog::name(LogEvent id) {
+    uint16_t i = (uint16_t)id;
+    return i < (uint16_t)LogEvent::Count ? kEventNames[i] : "Unknown";
+}
+
+// 一条记录 → 一行文本 / One record → one text line
+static int formatRecord(uint32_t seq, const LogRecord& r, char* out, size_t size) {
+    int n = snprintf(out, size, "[Ev %lu] b%u %lu.%03lu ", (unsigned long)seq, (unsigned)r.boot,
+                     (unsigned long)(r.tsMs / 1000), (unsigned long)(r.tsMs % 1000));
+    if (n < 0 || (size_t)n >= size) return (int)size - 1;
+    if (r.id < (uint16_t)LogEvent::Count) {
+        n += snprintf(out + n, size - n, kEventFormats[r.id], (long)r.a, (long)r.b);
+    } else {
+        n += snprintf(out + n, size - n, "event %u a=%ld b=%ld", (unsigned)r.id, (long)r.a, (long)r.b);
+    }
+    if ((size_t)n >= size - 1) n = (int)size - 2;
+    out[n++] = '\n';
+    out[n] = '\0';
+    return n;
+}
+
+// 取出 [seq] 处的记录；已被覆盖时把 seq 前移到最旧一条 / Copy the record at seq; skip ahead if it was overwritten
+static bool readRecord(uint32_t& seq, LogRecord& out) {
+    bool ok = false;
+    portENTER_CRITICAL(&s_lock);
+    uint32_t head = s_ring.head;
+    if (head - seq > EVENT_LOG_CAPACITY) seq = head - EVENT_LOG_CAPACITY;
+    if (seq != head) {
+        out = s_ring.rec[seq & kRingMask];
+        ok = true;
+    }
+    portEXIT_CRITICAL(&s_lock);
+    return ok;
+}
+
+void EventLog::tick() {
+#if DEBUG_LOG_ENABLED
+    if (!s_ready) return;
+    for (int budget = 4; budget > 0; budget--) {
+        uint32_t seq = s_ring.drained;
+        LogRecord r;
+        if (!readRecord(seq, r)) break;
+        char line[112];
+        int n = formatRecord(seq, r, line, sizeof(line));
+        if (Serial.availableForWrite() < n) break; // 缓冲满：下次再发 / TX buffer full: try next loop
+        Serial.write((const uint8_t*)line, n);
+        s_ring.drained = seq + 1;
+    }
+#endif
+}
+
+void EventLog::attachHttp(WebServer* srv) {
+    s_server = srv;
+    if (s_server) s_server->on("/log", HTTP_GET, handleGet);
+}
+
+// GET /log[?since=<seq>][&format=text]：默认二进制（若干段“文件头 + 16 字节记录”，小端），由 tools/log_decode 解码
+// EN: GET /log[?since=<seq>][&format=text]: binary by default (chunks of header + 16-byte little-endian records) for tools/log_decode
+void EventLog::handleGet() {
+    uint32_t head = s_ring.head;
+    uint32_t first = head > EVENT_LOG_CAPACITY ? head - EVENT_LOG_CAPACITY : 0;
+    if (s_server->hasArg("since")) {
+        uint32_t since = (uint32_t)strtoul(s_server->arg("since").c_str(), nullptr, 10);
+        if (since > first) first = since < head ? since : head;
+    }
+    bool text = s_server->arg("format") == "text";
+
+    s_server->setContentLength(CONTENT_LENGTH_UNKNOWN);
+    s_server->send(200, text ? "text/plain" : "application/octet-stream", "");
+
+    char buf[512];
+    size_t used = 0;
+    LogDumpHeader h;
+    memcpy(h.magic, "ELOG", 4);
+    h.version = 2;
+    h.recordSize = sizeof(LogRecord);
+    h.boot = s_ring.boot;
+    h.firstSeq = first;
+    h.count = 0;
+    // 记录在发送期间可能被覆盖：从幸存的最旧一条之后继续，不重复发送。二进制转储分段发出，每段为文件头加其后连续的记录，
+    // 文件头的条数在该段发出前才填写，序号出现跳跃时另起一段
+    // EN: Records may be overwritten while sending: carry on after the oldest survivor instead of repeating it.
+    // EN: Binary dumps go out in chunks, each a header plus the consecutive records behind it; the header's count is
+    // EN: filled in just before its chunk is sent, and a jump in seq starts a new chunk.
+    for (uint32_t seq = first; (int32_t)(head - seq) > 0;) {
+        LogRecord r;
+        uint32_t at = seq;
+        if (!readRecord(at, r) || (int32_t)(head - at) <= 0) break;
+        seq = at + 1;
+        if (text) {
+            char line[112];
+            int n = formatRecord(at, r, line, sizeof(line));
+            if (used + n > sizeof(buf)) {
+                s_server->sendContent(buf, used);
+                used = 0;
+            }
+            memcpy(buf + used, line, n);
+            used += n;
+        } else {
+            if (h.count > 0 && (at != h.firstSeq + h.count || used + sizeof(r) > sizeof(buf))) {
+                memcpy(buf, &h, sizeof(h));
+                s_server->sendContent(buf, used);
+                h.count = 0;
+            }
+            if (h.count == 0) {
+                h.firstSeq = at;
+                used = sizeof(h);
+            }
+            memcpy(buf + used, &r, sizeof(r));
+            used += sizeof(r);
+            h.count++;
+        }
+    }
+    // 空转储也带一个文件头（条数 0）/ An empty dump still carries one header (count 0)
+    if (!text) {
+        if (h.count == 0) used = sizeof(h);
+        memcpy(buf, &h, sizeof(h));
+    }
+    if (used > 0) s_server->sendContent(buf, used);
+    s_server->sendContent("");
+}
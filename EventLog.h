@@ -0,0 +1,52 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+// EventLog: compact binary event ring in .noinit RAM (survives soft reboots), drained to Serial and GET /log.
+// EventLog：位于 .noinit 内存的紧凑二进制事件环（软重启后保留），后台输出到串口并通过 GET /log 读取。
+#include <Arduino.h>
+#include <WebServer.h>
+
+// 事件 ID，定义见 LogEvents.def / Event ids, see LogEvents.def
+enum class LogEvent : uint16_t {
+#define LOG_EVENT(name, fmt) name,
+#include "LogEvents.def"
+#undef LOG_EVENT
+    Count
+};
+
+// 一条 16 字节记录 / One 16-byte record
+struct LogRecord {
+    uint32_t tsMs;   // 本次启动以来的毫秒 / ms since this boot
+    uint16_t id;     // LogEvent
+    uint16_t boot;   // 启动序号（软重启递增）/ boot number (bumped on every soft reboot)
+    int32_t a;
+    int32_t b;
+};
+
+class EventLog {
+public:
+    // 在 setup() 最开始调用：校验/保留环并记录启动事件 / Call first in setup(): validate or keep the ring, log a boot event
+    static void begin();
+    // 注册 GET /log / Register GET /log
+    static void attachHttp(WebServer* srv);
+
+    /**
+     * @brief Appends one record: a timestamp and a short critical section, no formatting, no I/O.
+     * @brief 追加一条记录：只取时间戳并进入很短的临界区，不格式化、不做 I/O。
+     */
+    static void log(LogEvent id, int32_t a = 0, int32_t b = 0);
+
+    // 在 loop() 中调用：串口发送缓冲有空间时才输出少量记录，从不阻塞
+    // EN: Call in loop(): prints a few records only while the Serial TX buffer has room, never blocks
+    static void tick();
+
+    static const char* name(LogEvent id);
+
+private:
+    static void handleGet();
+};
+
+// 热路径写法 / Hot-path shorthand
+#define LOG_EV(name, ...) EventLog::log(LogEvent::name, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,175 @@
+// EventStream: listener, request-header handshake, subscriber slots, non-blocking writes and keep-alive.
+// EventStream：监听、请求头握手、订阅者槽位、非阻塞写入与心跳。
+#include "Config.h"
+#include "EventStream.h"
+#include <lwip/sockets.h>
+#include <stdarg.h>
+
+static const unsigned long SSE_PING_INTERVAL_MS = 15000;
+static const unsigned long SSE_HANDSHAKE_TIMEOUT_MS = 2000;
+
+void EventStream::begin(WebServer* srv, uint16_t port) {
+    _server = srv;
+    _port = port;
+    if (_server) _server->on("/events", HTTP_GET, [this]() { handleRedirect(); });
+}
+
+int EventStream::subscribers() const {
+    return _count;
+}
+
+// GET /events（80 端口）：正常应答 307，连接随即由 WebServer 关闭 / GET /events on port 80: a normal 307, WebServer closes as usual
+void EventStream::handleRedirect() {
+    char location[48];
+    snprintf(location, sizeof(location), "http://%s:%u/events", WiFi.localIP().toString().c_str(), (unsigned)_port);
+    _server->sendHeader("Location", location);
+    _server->sendHeader("Access-Control-Allow-Origin", "*");
+    _server->send(307, "text/plain", "");
+}
+
+// 套接字发送缓冲写不下时 send() 立即返回，不走 WiFiClient 的重试等待
+// EN: send() with MSG_DONTWAIT returns at once when the socket buffer is full, unlike WiFiClient's retry loop
+bool EventStream::sendTo(int slot, const char* data, size_t len) {
+    int fd = _clients[slot].fd();
+    if (fd < 0) return false;
+    int n = send(fd, data, len, MSG_DONTWAIT);
+    return n == (int)len;
+}
+
+void EventStream::drop(int slot) {
+    if (_state[slot] == Slot::Free) return;
+    if (_state[slot] == Slot::Live) _count--;
+    _clients[slot].stop();
+    _clients[slot] = WiFiClient();
+    _state[slot] = Slot::Free;
+}
+
+void EventStream::acceptClients() {
+    if (!_listening) {
+        // EN: Bind once Wi-Fi is up, like WebServer after autoConfig().
+        // 中文: Wi-Fi 连上后再绑定，与 autoConfig() 之后的 WebServer 一致。
+        if (WiFi.status() != WL_CONNECTED) return;
+        _listener.begin(_port);
+        _listener.setNoDelay(true);
+        _listening = true;
+    }
+    WiFiClient c = _listener.accept();
+    if (!c) return;
+
+    int slot = -1;
+    for (int i = 0; i < kMaxSubscribers; i++) {
+        if (_state[i] == Slot::Free) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        static const char kFull[] =
+            "HTTP/1.1 503 Service Unavailable\r\nContent-Type: application/json\r\nConnection: close\r\n"
+            "Access-Control-Allow-Origin: *\r\n\r\n{\"error\":\"Too many subscribers\"}";
+        send(c.fd(), kFull, sizeof(kFull) - 1, MSG_DONTWAIT);
+        c.stop();
+        return;
+    }
+    _clients[slot] = c;
+    _state[slot] = Slot::Handshake;
+    _acceptedAt[slot] = millis();
+    _tail[slot] = 0;
+    _lineLen[slot] = 0;
+}
+
+// EN: Reads whatever request bytes are there without blocking; the stream starts once the blank line arrives.
+// 中文: 非阻塞读取已到达的请求字节；读到空行后开始推送。
+void EventStream::readHandshake(int slot) {
+    if (millis() - _acceptedAt[slot] > SSE_HANDSHAKE_TIMEOUT_MS || !_clients[slot].connected()) {
+        drop(slot);
+        return;
+    }
+    char buf[64];
+    int n;
+    while ((n = recv(_clients[slot].fd(), buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+        for (int i = 0; i < n; i++) {
+            if (_lineLen[slot] < sizeof(_line[slot]) - 1) _line[slot][_lineLen[slot]++] = buf[i];
+            _tail[slot] = (_tail[slot] << 8) | (uint8_t)buf[i];
+            if (_tail[slot] != 0x0D0A0D0A) continue;
+            _line[slot][_lineLen[slot]] = '\0';
+            // EN: "GET /events" followed by a space or a query string.
+            // 中文: "GET /events" 后接空格或查询串。
+            if (strncmp(_line[slot], "GET /events", 11) == 0 && (_line[slot][11] == ' ' || _line[slot][11] == '?')) {
+                goLive(slot);
+            } else {
+                static const char kNotFound[] = "HTTP/1.1 404 Not Found\r\nConnection: close\r\n\r\n";
+                sendTo(slot, kNotFound, sizeof(kNotFound) - 1);
+                drop(slot);
+            }
+            return;
+        }
+    }
+}
+
+void EventStream::goLive(int slot) {
+    _state[slot] = Slot::Live;
+    _count++;
+
+    static const char kHeaders[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\n"
+        "Connection: keep-alive\r\n"
+        "Access-Control-Allow-Origin: *\r\n"
+        "\r\n"
+        "retry: 3000\n\n";
+    if (!sendTo(slot, kHeaders, sizeof(kHeaders) - 1)) {
+        drop(slot);
+        return;
+    }
+    DEBUG_PRINTF("[SSE] Subscriber %d connected (%d total)\n", slot, _count);
+
+    char snap[256];
+    if (_snapshotFn) _snapshotFn(snap, sizeof(snap));
+    else snprintf(snap, sizeof(snap), "{}");
+    char buf[320];
+    int n = snprintf(buf, sizeof(buf), "id: %lu\nevent: hello\ndata: %s\n\n", (unsigned long)_seq, snap);
+    if (n > 0 && n < (int)sizeof(buf) && !sendTo(slot, buf, n)) drop(slot);
+}
+
+void EventStream::publish(const char* event, const char* json) {
+    if (_count == 0) return;
+    char buf[320];
+    int n = snprintf(buf, sizeof(buf), "id: %lu\nevent: %s\ndata: %s\n\n", (unsigned long)++_seq, event, json);
+    if (n <= 0 || n >= (int)sizeof(buf)) return;
+    for (int i = 0; i < kMaxSubscribers; i++) {
+        if (_state[i] == Slot::Live && !sendTo(i, buf, n)) {
+            _dropped++;
+            drop(i);
+        }
+    }
+}
+
+void EventStream::publishf(const char* event, const char* fmt, ...) {
+    if (_count == 0) return;
+    char json[256];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(json, sizeof(json), fmt, args);
+    va_end(args);
+    if (n <= 0 || n >= (int)sizeof(json)) return;
+    publish(event, json);
+}
+
+void EventStream::tick() {
+    acceptClients();
+    for (int i = 0; i < kMaxSubscribers; i++) {
+        if (_state[i] == Slot::Handshake) readHandshake(i);
+        else if (_state[i] == Slot::Live && !_clients[i].connected()) drop(i);
+    }
+    if (_count == 0) return;
+    unsigned long now = millis();
+    if (now - _lastPingAt < SSE_PING_INTERVAL_MS) return;
+    _lastPingAt = now;
+    // 注释行心跳，防止代理/NAT 超时 / Comment-line keep-alive against proxy/NAT idle timeouts
+    static const char kPing[] = ": ping\n\n";
+    for (int i = 0; i < kMaxSubscribers; i++) {
+        if (_state[i] == Slot::Live && !sendTo(i, kPing, sizeof(kPing) - 1)) drop(i);
+    }
+}
@@ -0,0 +1,74 @@
+#ifndef EVENTSTREAM_H
+#define EVENTSTREAM_H
+
+// EventStream: Server-Sent Events on their own listener (SSE_PORT); pushes small deltas only when something changes.
+// EventStream：独立监听端口（SSE_PORT）上的 SSE 推送，仅在状态变化时推送小的增量事件。
+#include <Arduino.h>
+#include <WebServer.h>
+#include <WiFi.h>
+#include "Config.h"
+
+// 新订阅者的初始快照（写入一个 JSON 对象）/ Initial snapshot for a new subscriber (one JSON object)
+typedef void (*EventSnapshotFn)(char* buf, size_t size);
+
+class EventStream {
+public:
+    static const int kMaxSubscribers = 4;
+
+    /**
+     * @brief Listens on `port` for GET /events; GET /events on `srv` answers 307 to that port.
+     * @brief 在 `port` 上监听 GET /events；`srv` 上的 GET /events 以 307 重定向到该端口。
+     *
+     * EN: A stream kept on WebServer's own socket would park it in HC_WAIT_CLOSE for 2 s per subscribe,
+     * EN: refusing every other request (including /action) meanwhile.
+     * 中文: 若事件流占用 WebServer 自身的连接，每次订阅都会使其在 HC_WAIT_CLOSE 停留 2 秒，期间拒绝其他请求（包括 /action）。
+     */
+    void begin(WebServer* srv, uint16_t port = SSE_PORT);
+
+    /**
+     * @brief Pushes one event to every subscriber. Never blocks: a subscriber whose socket cannot take
+     *        the whole event right now is dropped (EventSource reconnects on its own).
+     * @brief 向所有订阅者推送一条事件。从不阻塞：套接字暂时写不下整条事件的订阅者会被断开（EventSource 会自动重连）。
+     * @param event Event name. / 事件名。
+     * @param json Payload, a small JSON object. / 负载，小的 JSON 对象。
+     */
+    void publish(const char* event, const char* json);
+    void publishf(const char* event, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+    // 接受新连接、读取请求头、清理断开的订阅者并发送心跳 / Accept, read request headers, reap closed subscribers, keep-alive
+    void tick();
+
+    void setSnapshot(EventSnapshotFn fn) { _snapshotFn = fn; }
+    int subscribers() const;
+    bool active() const { return _count > 0; }
+
+private:
+    // 槽位状态 / Slot state
+    enum class Slot : uint8_t { Free = 0, Handshake, Live };
+
+    WebServer* _server = nullptr;
+    WiFiServer _listener;
+    uint16_t _port = SSE_PORT;
+    bool _listening = false;
+
+    WiFiClient _clients[kMaxSubscribers];
+    Slot _state[kMaxSubscribers] = {Slot::Free, Slot::Free, Slot::Free, Slot::Free};
+    unsigned long _acceptedAt[kMaxSubscribers] = {0};
+    uint32_t _tail[kMaxSubscribers] = {0};  // 最近 4 个请求字节，用于找空行 / last 4 request bytes, to spot the blank line
+    char _line[kMaxSubscribers][16];        // 请求行开头 / start of the request line
+    uint8_t _lineLen[kMaxSubscribers] = {0};
+    int _count = 0;                         // Live 订阅者数 / live subscribers
+    uint32_t _seq = 0;
+    uint32_t _dropped = 0;
+    unsigned long _lastPingAt = 0;
+    EventSnapshotFn _snapshotFn = nullptr;
+
+    void handleRedirect();
+    void acceptClients();
+    void readHandshake(int slot);
+    void goLive(int slot);
+    bool sendTo(int slot, const char* data, size_t len);
+    void drop(int slot);
+};
+
+#endif
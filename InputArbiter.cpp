@@ -0,0 +1,128 @@
+// InputArbiter: manual-over-auto priority, post-manual quiet period and wait accounting.
+// InputArbiter：手动优先于自动、手动后的静默期与等待统计。
+#include "Config.h"
+#include "InputArbiter.h"
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+
+void ArbiterWaitStats::record(uint32_t waitUs) {
+    grants++;
+    lastUs = waitUs;
+    sumUs += waitUs;
+    if (waitUs > maxUs) maxUs = waitUs;
+}
+
+// Load the quiet period and register routes
+void InputArbiter::begin(WebServer* srv) {
+    _server = srv;
+    _pref.begin("arbiter", true);
+    _quietMs = _pref.getULong("quiet_ms", _quietMs);
+    _pref.end();
+    if (_server) {
+        _server->on("/arbiter", HTTP_GET, [this]() { handleGet(); });
+        _server->on("/arbiter", HTTP_POST, [this]() { handlePost(); });
+    }
+}
+
+const char* InputArbiter::ownerName(InputOwner owner) {
+    switch (owner) {
+    case InputOwner::Manual: return "manual";
+    case InputOwner::Auto:   return "auto";
+    default:                 return "idle";
+    }
+}
+
+uint16_t InputArbiter::enqueueManual() {
+    return _pendingManual++;
+}
+
+uint32_t InputArbiter::acquireManual(int64_t arrivedUs) {
+    int64_t now = esp_timer_get_time();
+    uint32_t waitUs = arrivedUs > 0 && now > arrivedUs ? (uint32_t)(now - arrivedUs) : 0;
+    _owner = InputOwner::Manual;
+    _ownerSince = millis();
+    _manualGen++;
+    _manual.record(waitUs);
+    return waitUs;
+}
+
+void InputArbiter::releaseManual() {
+    if (_pendingManual > 0) _pendingManual--;
+    if (_owner == InputOwner::Manual) _owner = InputOwner::Idle;
+    _lastManualEnd = millis();
+    if (_lastManualEnd == 0) _lastManualEnd = 1;
+}
+
+void InputArbiter::cancelManual() {
+    if (_pendingManual > 0) _pendingManual--;
+}
+
+unsigned long InputArbiter::quietLeftMs() const {
+    if (_lastManualEnd == 0) return 0;
+    unsigned long since = millis() - _lastManualEnd;
+    return since >= _quietMs ? 0 : _quietMs - since;
+}
+
+bool InputArbiter::autoMayRun() const {
+    return _owner == InputOwner::Idle && _pendingManual == 0 && quietLeftMs() == 0;
+}
+
+bool InputArbiter::tryAcquireAuto(unsigned long dueAt) {
+    if (!autoMayRun()) {
+        // 同一次到点只计一次 / Count one deferral per due action
+        if (!_autoWasRefused) _autoDeferred++;
+        _autoWasRefused = true;
+        return false;
+    }
+    _autoWasRefused = false;
+    long late = (long)(millis() - dueAt);
+    _auto.record(late > 0 ? (uint32_t)late * 1000 : 0);
+    _owner = InputOwner::Auto;
+    _ownerSince = millis();
+    return true;
+}
+
+void InputArbiter::releaseAuto() {
+    if (_owner == InputOwner::Auto) _owner = InputOwner::Idle;
+}
+
+// HTTP GET /arbiter: owner, quiet period and per-side waits
+void InputArbiter::handleGet() {
+    StaticJsonDocument<512> doc;
+    doc["owner"] = ownerName(_owner);
+    doc["owner_ms"] = _owner == InputOwner::Idle ? 0 : millis() - _ownerSince;
+    doc["pending_manual"] = _pendingManual;
+    doc["manual_quiet_ms"] = _quietMs;
+    doc["quiet_left_ms"] = quietLeftMs();
+    JsonObject m = doc.createNestedObject("manual");
+    m["grants"] = _manual.grants;
+    m["wait_last_us"] = _manual.lastUs;
+    m["wait_avg_us"] = _manual.avgUs();
+    m["wait_max_us"] = _manual.maxUs;
+    JsonObject a = doc.createNestedObject("auto");
+    a["grants"] = _auto.grants;
+    a["deferred"] = _autoDeferred;
+    a["replans"] = _autoReplans;
+    a["wait_last_ms"] = _auto.lastUs / 1000;
+    a["wait_avg_ms"] = _auto.avgUs() / 1000;
+    a["wait_max_ms"] = _auto.maxUs / 1000;
+    String out;
+    serializeJson(doc, out);
+    _server->send(200, "application/json", out);
+}
+
+// HTTP POST /arbiter: {"manual_quiet_ms": ms}
+void InputArbiter::handlePost() {
+    StaticJsonDocument<96> doc;
+    if (deserializeJson(doc, _server->arg("plain"))) {
+        _server->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+        return;
+    }
+    if (doc.containsKey("manual_quiet_ms")) {
+        _quietMs = constrain(doc["manual_quiet_ms"].as<long>(), 0L, 600000L);
+        _pref.begin("arbiter", false);
+        _pref.putULong("quiet_ms", _quietMs);
+        _pref.end();
+    }
+    _server->send(200, "application/json", "{\"status\":\"ok\"}");
+}
@@ -0,0 +1,91 @@
+#ifndef INPUTARBITER_H
+#define INPUTARBITER_H
+
+// InputArbiter: decides who drives the digitizer (manual /action vs auto-swipe) and accounts for waits.
+// InputArbiter：决定由谁驱动数位板（手动 /action 或自动上划），并统计各方等待时长。
+#include <Arduino.h>
+#include <WebServer.h>
+#include <Preferences.h>
+
+// 当前数位板持有者 / Current digitizer owner
+enum class InputOwner : uint8_t { Idle = 0, Manual, Auto };
+
+// 一方的授予/等待统计 / Grant and wait statistics for one side
+struct ArbiterWaitStats {
+    uint32_t grants = 0;      // 获得数位板的次数 / times the digitizer was granted
+    uint32_t lastUs = 0;      // 最近一次等待 / last wait
+    uint32_t maxUs = 0;       // 最长等待 / longest wait
+    uint64_t sumUs = 0;       // 用于平均值 / for the mean
+
+    void record(uint32_t waitUs);
+    uint32_t avgUs() const { return grants ? (uint32_t)(sumUs / grants) : 0; }
+};
+
+class InputArbiter {
+public:
+    // 读取静默期并注册 GET/POST /arbiter / Load the quiet period and register GET/POST /arbiter
+    void begin(WebServer* srv);
+
+    /**
+     * @brief Registers a manual request; returns how many manual requests are ahead of it.
+     * @brief 登记一个手动请求；返回排在它前面的手动请求数。
+     */
+    uint16_t enqueueManual();
+
+    /**
+     * @brief Grants the digitizer to the oldest manual request (manual always wins over auto).
+     * @brief 把数位板交给最早的手动请求（手动优先于自动）。
+     * @param arrivedUs esp_timer time the request body arrived; the wait is measured from here.
+     * @param arrivedUs 请求体到达时的 esp_timer 时刻；等待时长从此处起算。
+     * @return Wait in microseconds. / 等待的微秒数。
+     */
+    uint32_t acquireManual(int64_t arrivedUs);
+
+    // 手动动作结束，开始静默期 / Manual action finished; the quiet period starts
+    void releaseManual();
+
+    // 已登记的手动请求未执行即放弃（如暂存过期），不触发静默期 / A registered manual request was dropped unrun (e.g. expired in the buffer); no quiet period
+    void cancelManual();
+
+    /**
+     * @brief Auto-swipe asks for the digitizer; refused while manual requests are pending or during the quiet period.
+     * @brief 自动上划请求数位板；有手动请求排队或处于静默期时拒绝。
+     * @param dueAt millis() the action was planned for; the lateness is recorded as the auto wait.
+     * @param dueAt 动作计划执行的 millis()；延后部分记为自动方等待。
+     */
+    bool tryAcquireAuto(unsigned long dueAt);
+    void releaseAuto();
+
+    // 自动上划此刻可否运行（不改变状态）/ Whether auto-swipe may run now (no state change)
+    bool autoMayRun() const;
+
+    // 每次手动抢占递增；自动上划据此丢弃旧计划并重新排程 / Bumped on every manual grant; auto-swipe replans when it changes
+    uint32_t manualGeneration() const { return _manualGen; }
+    void noteAutoReplan() { _autoReplans++; }
+
+    InputOwner owner() const { return _owner; }
+    // 已登记未结束的手动请求数（含暂存项）/ Registered, unfinished manual requests (held items included)
+    uint16_t pendingManual() const { return _pendingManual; }
+    static const char* ownerName(InputOwner owner);
+    unsigned long quietLeftMs() const;
+
+private:
+    Preferences _pref;
+    WebServer* _server = nullptr;
+    InputOwner _owner = InputOwner::Idle;
+    unsigned long _ownerSince = 0;
+    uint16_t _pendingManual = 0;
+    unsigned long _lastManualEnd = 0;   // 0 = 尚无手动动作 / no manual action yet
+    unsigned long _quietMs = 3000;
+    uint32_t _manualGen = 0;
+    bool _autoWasRefused = false;
+    uint32_t _autoDeferred = 0;         // 到点但被拒绝的次数 / due but refused episodes
+    uint32_t _autoReplans = 0;
+    ArbiterWaitStats _manual;
+    ArbiterWaitStats _auto;
+
+    void handleGet();
+    void handlePost();
+};
+
+#endif
@@ -0,0 +1,155 @@
+// LoopProfiler: histogram percentiles, top-N stall list, threshold warnings and the /sys/loop endpoint.
+// LoopProfiler：直方图分位数、前 N 卡顿榜、阈值告警与 /sys/loop 接口。
+#include "Config.h"
+#include "LoopProfiler.h"
+#include "EventLog.h"
+#include <ArduinoJson.h>
+#include <esp_timer.h>
+
+// 与 LoopSection 一一对应 / One per LoopSection, same order
+static const char* const kSectionNames[] = {
+    "http", "action_buffer", "auto_swipe", "ble", "wifi", "discovery", "time_sync",
+    "sys_mon", "event_log", "events", "ota", "button", "scheduled",
+};
+
+// 告警最多每秒一条，避免串口/日志被刷屏 / At most one warning per second so Serial and the log are not flooded
+static const unsigned long LOOP_WARN_MIN_GAP_MS = 1000;
+
+uint32_t LoopSectionStats::percentileUs(float p) const {
+    if (count == 0) return 0;
+    uint32_t target = (uint32_t)ceilf(count * p);
+    uint32_t seen = 0;
+    for (int b = 0; b < kBuckets; b++) {
+        seen += hist[b];
+        if (seen >= target) {
+            return min((uint32_t)((1UL << (b + 1)) - 1), maxUs);
+        }
+    }
+    return maxUs;
+}
+
+const char* LoopProfiler::sectionName(LoopSection section) {
+    int i = (int)section;
+    return i < (int)LoopSection::Count ? kSectionNames[i] : "?";
+}
+
+// Load the threshold and register routes
+void LoopProfiler::begin(WebServer* srv) {
+    _server = srv;
+    _pref.begin("loop_prof", true);
+    _warnUs = _pref.getUInt("warn_us", _warnUs);
+    _pref.end();
+    if (_server) {
+        _server->on("/sys/loop", HTTP_GET, [this]() { handleGet(); });
+        _server->on("/sys/loop", HTTP_POST, [this]() { handlePost(); });
+    }
+}
+
+uint32_t LoopProfiler::beginPass() {
+    _passStartUs = esp_timer_get_time();
+    _passWorstUs = 0;
+    return (uint32_t)_passStartUs;
+}
+
+void LoopProfiler::endPass() {
+    uint32_t passUs = (uint32_t)(esp_timer_get_time() - _passStartUs);
+    _pass.add(passUs);
+    noteStall(passUs);
+
+    if (_warnUs == 0 || passUs < _warnUs) return;
+    _warnings++;
+    unsigned long now = millis();
+    if (now - _lastWarnAt < LOOP_WARN_MIN_GAP_MS) return;
+    _lastWarnAt = now;
+    LOG_EV(LoopStall, (int32_t)passUs, (int32_t)_passWorst);
+    DEBUG_PRINTF("[Loop] pass %lu us > %lu us, worst: %s %lu us\n",
+                 (unsigned long)passUs, (unsigned long)_warnUs, sectionName(_passWorst), (unsigned long)_passWorstUs);
+}
+
+// 保留最慢的 N 轮（替换榜中最小的一项）/ Keep the N slowest passes (replace the smallest entry)
+void LoopProfiler::noteStall(uint32_t passUs) {
+    int slot;
+    if (_stallCount < kTopStalls) {
+        slot = _stallCount++;
+    } else {
+        slot = 0;
+        for (int i = 1; i < kTopStalls; i++) {
+            if (_stalls[i].passUs < _stalls[slot].passUs) slot = i;
+        }
+        if (passUs <= _stalls[slot].passUs) return;
+    }
+    _stalls[slot].atMs = millis();
+    _stalls[slot].passUs = passUs;
+    _stalls[slot].section = _passWorst;
+    _stalls[slot].sectionUs = _passWorstUs;
+}
+
+void LoopProfiler::reset() {
+    for (LoopSectionStats& s : _sections) s = LoopSectionStats();
+    _pass = LoopSectionStats();
+    _stallCount = 0;
+    _warnings = 0;
+}
+
+static void fillStats(JsonObject o, const LoopSectionStats& s) {
+    o["count"] = s.count;
+    o["min_us"] = s.count ? s.minUs : 0;
+    o["avg_us"] = s.count ? (uint32_t)(s.sumUs / s.count) : 0;
+    o["max_us"] = s.maxUs;
+    o["p99_us"] = s.percentileUs(0.99f);
+}
+
+// HTTP GET /sys/loop: per-section min/avg/max/p99, pass stats and the worst stalls (slowest first)
+void LoopProfiler::handleGet() {
+    StaticJsonDocument<2048> doc;
+    doc["uptime_ms"] = millis();
+    doc["warn_us"] = _warnUs;
+    doc["warnings"] = _warnings;
+    fillStats(doc.createNestedObject("pass"), _pass);
+
+    JsonObject secs = doc.createNestedObject("sections");
+    for (int i = 0; i < (int)LoopSection::Count; i++) {
+        fillStats(secs.createNestedObject(kSectionNames[i]), _sections[i]);
+    }
+
+    LoopStall sorted[kTopStalls];
+    for (int i = 0; i < _stallCount; i++) sorted[i] = _stalls[i];
+    for (int i = 1; i < _stallCount; i++) {
+        LoopStall v = sorted[i];
+        int j = i - 1;
+        while (j >= 0 && sorted[j].passUs < v.passUs) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = v;
+    }
+    JsonArray stalls = doc.createNestedArray("stalls");
+    for (int i = 0; i < _stallCount; i++) {
+        JsonObject o = stalls.createNestedObject();
+        o["at_ms"] = sorted[i].atMs;
+        o["us"] = sorted[i].passUs;
+        o["section"] = sectionName(sorted[i].section);
+        o["section_us"] = sorted[i].sectionUs;
+    }
+
+    String out;
+    serializeJson(doc, out);
+    _server->send(200, "application/json", out);
+}
+
+// HTTP POST /sys/loop: {"warn_us": us (0 = off), "reset": true}
+void LoopProfiler::handlePost() {
+    StaticJsonDocument<96> doc;
+    if (deserializeJson(doc, _server->arg("plain"))) {
+        _server->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+        return;
+    }
+    if (doc.containsKey("warn_us")) {
+        _warnUs = doc["warn_us"].as<uint32_t>();
+        _pref.begin("loop_prof", false);
+        _pref.putUInt("warn_us", _warnUs);
+        _pref.end();
+    }
+    if (doc["reset"] | false) reset();
+    _server->send(200, "application/json", "{\"status\":\"ok\"}");
+}
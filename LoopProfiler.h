@@ -0,0 +1,117 @@
+#ifndef LOOPPROFILER_H
+#define LOOPPROFILER_H
+
+// LoopProfiler: per-subsystem time accounting of loop() with esp_timer, plus a worst-stall list.
+// LoopProfiler：用 esp_timer 按子系统统计 loop() 耗时，并记录最严重的卡顿。
+#include <Arduino.h>
+#include <WebServer.h>
+#include <Preferences.h>
+#include <esp_timer.h>
+
+// loop() 中被计时的子系统。数值是 LoopStall 日志记录的区段编号，只能在末尾追加，与调用顺序无关（Scheduled 最先调用）
+// Timed loop() subsystems. The values are the section indices LoopStall logs, so only append; they do not follow
+// call order (Scheduled runs first)
+enum class LoopSection : uint8_t {
+    Http = 0,
+    ActionBuffer,
+    AutoSwipe,
+    Ble,
+    Wifi,
+    Discovery,
+    TimeSync,
+    SysMon,
+    EventLog,
+    Events,
+    Ota,
+    Button,
+    Scheduled,
+    Count
+};
+
+// 单个子系统的耗时统计（微秒）；分位数来自 2 的幂直方图 / Per-section timing (µs); percentiles come from a power-of-two histogram
+struct LoopSectionStats {
+    static const int kBuckets = 24; // 桶 i 覆盖 [2^i, 2^(i+1)) µs / bucket i covers [2^i, 2^(i+1)) µs
+    uint32_t count = 0;
+    uint32_t minUs = UINT32_MAX;
+    uint32_t maxUs = 0;
+    uint64_t sumUs = 0;
+    uint32_t hist[kBuckets] = {0};
+
+    inline void add(uint32_t us) {
+        count++;
+        sumUs += us;
+        if (us < minUs) minUs = us;
+        if (us > maxUs) maxUs = us;
+        int b = us ? 31 - __builtin_clz(us) : 0;
+        hist[b < kBuckets ? b : kBuckets - 1]++;
+    }
+    // 分位数的桶上界 / Upper bound of the bucket holding the percentile
+    uint32_t percentileUs(float p) const;
+};
+
+// 一次卡顿：整轮耗时 + 当轮最慢的子系统 / One stall: pass time + the slowest section in that pass
+struct LoopStall {
+    uint32_t atMs = 0;       // 发生时刻（开机毫秒）/ uptime when it happened
+    uint32_t passUs = 0;
+    LoopSection section = LoopSection::Http;
+    uint32_t sectionUs = 0;
+};
+
+class LoopProfiler {
+public:
+    static const int kTopStalls = 8;
+
+    // 读取告警阈值并注册 GET/POST /sys/loop / Load the warning threshold and register GET/POST /sys/loop
+    void begin(WebServer* srv);
+
+    // 一轮开始，返回计时起点（微秒）/ Start of a pass; returns the time mark (µs)
+    uint32_t beginPass();
+
+    /**
+     * @brief Charges the time since `mark` to `section` and returns the new mark, so each call costs one timer read.
+     * @brief 把自 `mark` 以来的时间记到 `section`，并返回新的起点；每次调用只读一次计时器。
+     *
+     * EN: esp_timer rather than the cycle counter, which wraps after ~17.9 s at 240 MHz and would misreport a 30 s
+     * EN: /bench/hid. The 32-bit µs mark only wraps after ~71 min, and the unsigned difference stays exact across it.
+     * 中文: 使用 esp_timer 而非周期计数器：后者在 240MHz 下约 17.9s 回绕，30s 的 /bench/hid 会被记错。
+     * 中文: 32 位微秒起点约 71 分钟才回绕，且无符号差值跨越回绕仍然准确。
+     */
+    inline uint32_t lap(LoopSection section, uint32_t mark) {
+        uint32_t now = (uint32_t)esp_timer_get_time();
+        uint32_t us = now - mark;
+        _sections[(int)section].add(us);
+        if (us > _passWorstUs) {
+            _passWorstUs = us;
+            _passWorst = section;
+        }
+        return now;
+    }
+
+    // 一轮结束：整轮统计、卡顿榜与阈值告警 / End of a pass: pass stats, stall list and threshold warning
+    void endPass();
+
+    static const char* sectionName(LoopSection section);
+
+private:
+    Preferences _pref;
+    WebServer* _server = nullptr;
+    int64_t _passStartUs = 0;
+    uint32_t _passWorstUs = 0;
+    LoopSection _passWorst = LoopSection::Http;
+
+    LoopSectionStats _sections[(int)LoopSection::Count];
+    LoopSectionStats _pass;
+    LoopStall _stalls[kTopStalls];
+    int _stallCount = 0;
+
+    uint32_t _warnUs = 0;     // 0 = 关闭告警 / 0 = warnings off
+    uint32_t _warnings = 0;
+    unsigned long _lastWarnAt = 0;
+
+    void noteStall(uint32_t passUs);
+    void reset();
+    void handleGet();
+    void handlePost();
+};
+
+#endif
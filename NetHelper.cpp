@@ -1,7 +1,21 @@
 #include "Config.h"
 #include "NetHelper.h"
+#include "EventLog.h"
 #include "ota.h" // EN: Include OtaUpdater header here for its definition. / 中文: 在这里引入 OtaUpdater 头文件以获取其定义。
 #include <nvs_flash.h> // 引入 NVS 操作库
+#include <ESPmDNS.h>
+#include <esp_mac.h>
+
+// EN: Upper bound of the random delay before answering a discovery probe.
+// 中文: 回应发现探测前随机延迟的上限。
+static const unsigned long DISCOVERY_MAX_JITTER_MS = 50;
+
+// EN: Wi-Fi supervisor timing: targeted attempt, full-scan attempt, and backoff between failed rounds.
+// 中文: Wi-Fi 守护时序：定向连接、全信道扫描连接，以及失败轮次之间的退避。
+static const unsigned long WIFI_FAST_TIMEOUT_MS = 4000;
+static const unsigned long WIFI_SCAN_TIMEOUT_MS = 12000;
+static const unsigned long WIFI_BACKOFF_MIN_MS = 1000;
+static const unsigned long WIFI_BACKOFF_MAX_MS = 60000;
 
 // EN: Flag to indicate whether WiFiManager parameters should be saved.
 // 中文: 标志位，用于指示是否需要保存 WiFiManager 的参数。
@@ -107,6 +121,7 @@ void NetHelper::beginDiscoveryResponder(uint16_t port, const String& magic, cons
     _discoveryPort = port;
     _discoveryMagic = magic;
     _discoveryVersion = version;
+    rebuildDiscoveryReply();
 
     if (_udp.begin(port)) {
         _udpActive = true;
@@ -114,39 +129,104 @@ void NetHelper::beginDiscoveryResponder(uint16_t port, const String& magic, cons
     } else {
         DEBUG_PRINTF("[UDP] Failed to bind discovery port %u\n", port);
     }
+    beginMdns();
 }
 
-void NetHelper::tickDiscovery() {
-    if (!_udpActive || WiFi.status() != WL_CONNECTED) {
+void NetHelper::beginMdns() {
+    String mac = WiFi.macAddress();
+    mac.replace(":", "");
+    mac.toLowerCase();
+    String host = "wacom-" + mac.substring(mac.length() - 4);
+    if (!MDNS.begin(host.c_str())) {
+        DEBUG_PRINTLN("[mDNS] Failed to start responder");
         return;
     }
+    // EN: _http._tcp for browsers/tools, _blemouse._udp points at the discovery port.
+    // 中文: _http._tcp 供浏览器/工具使用，_blemouse._udp 指向发现端口。
+    MDNS.addService("http", "tcp", 80);
+    MDNS.addServiceTxt("http", "tcp", "device", "esp32-ble-mouse");
+    MDNS.addServiceTxt("http", "tcp", "version", _discoveryVersion.c_str());
+    MDNS.addService("blemouse", "udp", _discoveryPort);
+    MDNS.addServiceTxt("blemouse", "udp", "version", _discoveryVersion.c_str());
+    _mdnsActive = true;
+    DEBUG_PRINTF("[mDNS] %s.local registered\n", host.c_str());
+}
 
-    int packetSize = _udp.parsePacket();
-    if (!packetSize) {
-        return;
-    }
+void NetHelper::rebuildDiscoveryReply() {
+    IPAddress ip = WiFi.localIP();
+    _replyIp = (uint32_t)ip;
+    _replyPrefixLen = snprintf(_replyPrefix, sizeof(_replyPrefix),
+                               "{\"device\":\"esp32-ble-mouse\",\"ip\":\"%u.%u.%u.%u\",\"mac\":\"%s\",\"version\":\"%s\"",
+                               ip[0], ip[1], ip[2], ip[3], WiFi.macAddress().c_str(), _discoveryVersion.c_str());
+    if (_replyPrefixLen < 0 || _replyPrefixLen >= (int)sizeof(_replyPrefix)) _replyPrefixLen = sizeof(_replyPrefix) - 1;
+}
 
-    char incoming[80];
-    int len = _udp.read(incoming, sizeof(incoming) - 1);
-    if (len <= 0) {
+void NetHelper::sendDiscoveryReply(const IPAddress& ip, uint16_t port) {
+    DiscoveryHints hints;
+    if (_hintFn) _hintFn(hints);
+
+    char tail[96];
+    int tailLen = snprintf(tail, sizeof(tail), ",\"ble\":%s,\"queue\":%d,\"busy\":%s,\"uptime\":%lu}",
+                           hints.bleConnected ? "true" : "false", hints.queueDepth,
+                           hints.busy ? "true" : "false", millis() / 1000UL);
+
+    _udp.beginPacket(ip, port);
+    _udp.write((const uint8_t*)_replyPrefix, _replyPrefixLen);
+    _udp.write((const uint8_t*)tail, tailLen);
+    _udp.endPacket();
+}
+
+void NetHelper::tickDiscovery() {
+    if (!_udpActive || WiFi.status() != WL_CONNECTED) {
         return;
     }
-    incoming[len] = '\0';
 
-    String probe = String(incoming);
-    probe.trim();
-    if (probe != _discoveryMagic) {
-        return;
+    if ((uint32_t)WiFi.localIP() != _replyIp) {
+        rebuildDiscoveryReply();
     }
 
-    String response = "{\"device\":\"esp32-ble-mouse\",\"ip\":\"" + WiFi.localIP().toString() +
-                      "\",\"mac\":\"" + WiFi.macAddress() +
-                      "\",\"version\":\"" + _discoveryVersion + "\"}";
+    // EN: Drain every pending probe this pass; replies are queued with a small random delay.
+    // 中文: 本轮读完所有待处理探测；回复带小的随机延迟入队。
+    unsigned long now = millis();
+    int packetSize;
+    while ((packetSize = _udp.parsePacket()) > 0) {
+        char incoming[80];
+        int len = _udp.read(incoming, sizeof(incoming) - 1);
+        if (len <= 0) continue;
+        while (len > 0 && isspace((unsigned char)incoming[len - 1])) len--;
+        int start = 0;
+        while (start < len && isspace((unsigned char)incoming[start])) start++;
+        if (len - start != (int)_discoveryMagic.length() ||
+            memcmp(incoming + start, _discoveryMagic.c_str(), len - start) != 0) {
+            continue;
+        }
+
+        IPAddress rip = _udp.remoteIP();
+        uint16_t rport = _udp.remotePort();
+        int slot = -1;
+        for (int i = 0; i < kMaxPendingReplies; i++) {
+            if (_pending[i].used && _pending[i].ip == rip && _pending[i].port == rport) { slot = -2; break; }
+            if (!_pending[i].used && slot == -1) slot = i;
+        }
+        if (slot == -2) continue; // EN: Same scanner already queued. / 中文: 同一扫描端已在队列中。
+        if (slot < 0) {
+            // EN: Queue full: answer right away rather than drop the probe.
+            // 中文: 队列已满：立即回复，而不是丢弃探测。
+            sendDiscoveryReply(rip, rport);
+            continue;
+        }
+        _pending[slot].ip = rip;
+        _pending[slot].port = rport;
+        _pending[slot].dueAt = now + random(0, DISCOVERY_MAX_JITTER_MS + 1);
+        _pending[slot].used = true;
+    }
 
-    DEBUG_PRINTLN("[UDP] Discovery probe received, replying with device info.");
-    _udp.beginPacket(_udp.remoteIP(), _udp.remotePort());
-    _udp.write((const uint8_t*)response.c_str(), response.length());
-    _udp.endPacket();
+    for (int i = 0; i < kMaxPendingReplies; i++) {
+        if (_pending[i].used && (long)(now - _pending[i].dueAt) >= 0) {
+            sendDiscoveryReply(_pending[i].ip, _pending[i].port);
+            _pending[i].used = false;
+        }
+    }
 }
 
 // EN: Helper: save static IP config into NVS.
@@ -199,10 +279,16 @@ void NetHelper::resetSettings() {
     DEBUG_PRINTLN("[WiFi] All settings erased (WiFi + Static IP + NVS)!");
 }
 
+String NetHelper::macSuffix() {
+    uint8_t mac[6];
+    esp_read_mac(mac, ESP_MAC_WIFI_STA);
+    char buf[5];
+    snprintf(buf, sizeof(buf), "%02X%02X", mac[4], mac[5]);
+    return String(buf);
+}
+
 String NetHelper::getDynamicBleName() {
-    String mac = WiFi.macAddress(); 
-    mac.replace(":", ""); 
-    String macSuffix = mac.substring(mac.length() - 4);
+    String macSuffix = this->macSuffix();
     
     IPAddress ip = WiFi.localIP();
     int lastOctet = ip[3];
@@ -213,3 +299,153 @@ String NetHelper::getDynamicBleName() {
     String name = "Wacom-" + macSuffix + "-" + ipSuffix;
     return name;
 }
+
+// EN: BLE name from the previous boot; the IP part is only known after DHCP.
+// 中文: 上次启动的蓝牙名称；IP 部分要等 DHCP 完成后才知道。
+String NetHelper::getCachedBleName() {
+    pref.begin("net_config", true);
+    String name = pref.getString("ble_name", "");
+    pref.end();
+    if (name.length() == 0) name = "Wacom-" + macSuffix() + "-000";
+    return name;
+}
+
+void NetHelper::cacheBleName(const String& name) {
+    pref.begin("net_config", false);
+    if (pref.getString("ble_name", "") != name) pref.putString("ble_name", name);
+    pref.end();
+}
+
+// EN: Take over reconnects from the core; the cached AP from NVS covers a boot-time outage.
+// 中文: 从内核接管重连；NVS 中缓存的 AP 用于启动后立即断线的情况。
+void NetHelper::beginWifiSupervisor() {
+    _ssid = WiFi.SSID();
+    _psk = WiFi.psk();
+    pref.begin("net_config", true);
+    _haveBssid = pref.getBytes("bssid", _bssid, sizeof(_bssid)) == sizeof(_bssid);
+    _channel = pref.getInt("chan", 0);
+    pref.end();
+    if (_channel <= 0) _haveBssid = false;
+
+    WiFi.setAutoReconnect(false);
+    if (WiFi.status() == WL_CONNECTED) {
+        rememberAccessPoint();
+        _wifiState = WifiState::Connected;
+    } else {
+        _outageStart = millis();
+        _wifiStats.outages++;
+        _nextAttemptAt = millis();
+        _wifiState = WifiState::Backoff;
+    }
+}
+
+void NetHelper::rememberAccessPoint() {
+    uint8_t* bssid = WiFi.BSSID();
+    int32_t channel = WiFi.channel();
+    if (!bssid || channel <= 0) return;
+    if (_haveBssid && channel == _channel && memcmp(bssid, _bssid, sizeof(_bssid)) == 0) return;
+
+    memcpy(_bssid, bssid, sizeof(_bssid));
+    _channel = channel;
+    _haveBssid = true;
+    pref.begin("net_config", false);
+    pref.putBytes("bssid", _bssid, sizeof(_bssid));
+    pref.putInt("chan", _channel);
+    pref.end();
+    DEBUG_PRINTF("[WiFi] Cached AP %02X:%02X:%02X:%02X:%02X:%02X ch%d\n",
+                 _bssid[0], _bssid[1], _bssid[2], _bssid[3], _bssid[4], _bssid[5], (int)_channel);
+}
+
+void NetHelper::restartNetServices() {
+    if (_discoveryPort != 0) {
+        _udp.stop();
+        _udpActive = _udp.begin(_discoveryPort);
+        for (int i = 0; i < kMaxPendingReplies; i++) _pending[i].used = false;
+        rebuildDiscoveryReply();
+        DEBUG_PRINTF("[UDP] Discovery re-bound: %s\n", _udpActive ? "ok" : "failed");
+    }
+    if (_mdnsActive) {
+        MDNS.end();
+        _mdnsActive = false;
+        beginMdns();
+    }
+}
+
+uint32_t NetHelper::currentOutageMs() const {
+    if (_wifiState == WifiState::Idle || _wifiState == WifiState::Connected || _outageStart == 0) return 0;
+    return millis() - _outageStart;
+}
+
+void NetHelper::tickWifi() {
+    if (_wifiState == WifiState::Idle) return;
+    unsigned long now = millis();
+    bool up = WiFi.status() == WL_CONNECTED;
+
+    switch (_wifiState) {
+    case WifiState::Connected:
+        if (!up) {
+            _outageStart = now ? now : 1;
+            _wifiStats.outages++;
+            _wifiStats.attempts = 0;
+            _backoffMs = 0;
+            _nextAttemptAt = now;
+            _wifiState = WifiState::Backoff;
+            LOG_EV(WifiLost, (int32_t)_wifiStats.outages);
+        }
+        return;
+
+    case WifiState::FastConnecting:
+    case WifiState::ScanConnecting: {
+        bool fast = _wifiState == WifiState::FastConnecting;
+        if (up) {
+            uint32_t outage = now - _outageStart;
+            _wifiStats.lastOutageMs = outage;
+            _wifiStats.totalOutageMs += outage;
+            if (outage > _wifiStats.longestOutageMs) _wifiStats.longestOutageMs = outage;
+            if (fast) _wifiStats.fastReconnects++;
+            else _wifiStats.scanReconnects++;
+            LOG_EV(WifiRestored, (int32_t)outage, fast ? 1 : 0);
+            _outageStart = 0;
+            _backoffMs = 0;
+            _wifiState = WifiState::Connected;
+            rememberAccessPoint();
+            restartNetServices();
+            return;
+        }
+        if (now - _attemptStart < (fast ? WIFI_FAST_TIMEOUT_MS : WIFI_SCAN_TIMEOUT_MS)) return;
+
+        if (fast) {
+            // EN: Cached AP did not answer (moved/roamed): full scan right away.
+            // 中文: 缓存的 AP 无响应（信道变化/漫游）：立即全信道扫描。
+            _wifiStats.attempts++;
+            _attemptStart = now;
+            WiFi.disconnect(false, false);
+            WiFi.begin(_ssid.c_str(), _psk.c_str());
+            _wifiState = WifiState::ScanConnecting;
+            return;
+        }
+        _backoffMs = _backoffMs == 0 ? WIFI_BACKOFF_MIN_MS : min(_backoffMs * 2, WIFI_BACKOFF_MAX_MS);
+        _nextAttemptAt = now + _backoffMs;
+        _wifiState = WifiState::Backoff;
+        LOG_EV(WifiBackoff, (int32_t)_backoffMs, (int32_t)_wifiStats.attempts);
+        return;
+    }
+
+    case WifiState::Backoff:
+        if ((long)(now - _nextAttemptAt) < 0) return;
+        _wifiStats.attempts++;
+        _attemptStart = now;
+        WiFi.disconnect(false, false);
+        if (_haveBssid) {
+            WiFi.begin(_ssid.c_str(), _psk.c_str(), _channel, _bssid);
+            _wifiState = WifiState::FastConnecting;
+        } else {
+            WiFi.begin(_ssid.c_str(), _psk.c_str());
+            _wifiState = WifiState::ScanConnecting;
+        }
+        return;
+
+    default:
+        return;
+    }
+}
@@ -8,6 +8,27 @@
 
 class OtaUpdater; // EN: Forward declaration for OtaUpdater. / 中文: OtaUpdater 的前向声明。
 
+// EN: Cheap load hints appended to each discovery reply so controllers can pick idle devices.
+// 中文: 附加在每个发现回复中的轻量负载提示，便于控制端挑选空闲设备。
+struct DiscoveryHints {
+    bool bleConnected = false; // EN: BLE link up. / 中文: 蓝牙已连接。
+    int queueDepth = 0;        // EN: Pending actions on the device. / 中文: 设备上待执行的动作数。
+    bool busy = false;         // EN: A gesture is running right now. / 中文: 当前正在执行手势。
+};
+typedef void (*DiscoveryHintFn)(DiscoveryHints& hints);
+
+// EN: Wi-Fi supervisor counters, published via GET /net/wifi.
+// 中文: Wi-Fi 守护计数，通过 GET /net/wifi 发布。
+struct WifiStats {
+    uint32_t outages = 0;            // EN: Times the link was lost. / 中文: 断线次数。
+    uint32_t lastOutageMs = 0;       // EN: Duration of the last finished outage. / 中文: 最近一次已恢复断线的时长。
+    uint32_t longestOutageMs = 0;    // EN: Longest finished outage. / 中文: 最长断线时长。
+    uint32_t totalOutageMs = 0;      // EN: Sum of finished outages. / 中文: 累计断线时长。
+    uint32_t fastReconnects = 0;     // EN: Recovered via cached BSSID/channel. / 中文: 通过缓存 BSSID/信道恢复的次数。
+    uint32_t scanReconnects = 0;     // EN: Recovered via a full scan. / 中文: 通过全信道扫描恢复的次数。
+    uint32_t attempts = 0;           // EN: Reconnect attempts in the current outage. / 中文: 本次断线中的重连尝试次数。
+};
+
 /**
  * @class NetHelper
  * @brief Manages Wi-Fi connection, auto-provisioning, and dynamic BLE name generation.
@@ -36,6 +57,20 @@ public:
      * @return 用于蓝牙设备名称的字符串。
      */
     String getDynamicBleName(); 
+
+    /**
+     * @brief Returns the BLE name saved on the last boot, so BLE can start before Wi-Fi.
+     * @brief 返回上次启动保存的蓝牙名称，使蓝牙可在 Wi-Fi 之前启动。
+     * @return The cached name, or a MAC-only name on first boot.
+     * @return 缓存的名称；首次启动时为仅含 MAC 的名称。
+     */
+    String getCachedBleName();
+
+    /**
+     * @brief Saves the BLE name for the next boot (written only when it changed).
+     * @brief 保存蓝牙名称供下次启动使用（仅在变化时写入）。
+     */
+    void cacheBleName(const String& name);
     
     /**
      * @brief Gets the local IP address of the device.
@@ -69,6 +104,34 @@ public:
      */
     void tickDiscovery();
 
+    /**
+     * @brief Registers a callback that fills load hints for discovery replies.
+     * @brief 注册回调，为发现回复填充负载提示。
+     * @param fn Callback invoked once per reply; may be nullptr.
+     * @param fn 每次回复调用一次的回调；可为 nullptr。
+     */
+    void setDiscoveryHints(DiscoveryHintFn fn) { _hintFn = fn; }
+
+    /**
+     * @brief Takes over reconnects from the core: remembers BSSID/channel of the current link.
+     * @brief 接管 Wi-Fi 重连：记录当前链路的 BSSID/信道。
+     */
+    void beginWifiSupervisor();
+
+    /**
+     * @brief Drives reconnects: targeted BSSID/channel first, then full scans with exponential backoff.
+     * @brief 驱动重连：先按 BSSID/信道定向连接，失败后全信道扫描并指数退避。
+     */
+    void tickWifi();
+
+    const WifiStats& wifiStats() const { return _wifiStats; }
+
+    /**
+     * @brief Milliseconds into the current outage, 0 when connected.
+     * @brief 当前断线已持续的毫秒数，已连接时为 0。
+     */
+    uint32_t currentOutageMs() const;
+
 private:
     // EN: Instance for reading/writing flash (NVS).
     // 中文: 用于读写闪存 (NVS) 的实例。
@@ -92,12 +155,81 @@ private:
      */
     bool loadConfig(char* ip, char* gw, char* sn);
 
+    /**
+     * @brief Last four hex digits of the station MAC (readable before Wi-Fi starts).
+     * @brief 站点 MAC 的后四位十六进制（Wi-Fi 启动前即可读取）。
+     */
+    String macSuffix();
+
     // --- UDP discovery / UDP 发现 ---
     WiFiUDP _udp;
     bool _udpActive = false;
     uint16_t _discoveryPort = 0;
     String _discoveryMagic;
     String _discoveryVersion;
+    DiscoveryHintFn _hintFn = nullptr;
+
+    // EN: Static part of the reply, rebuilt only when the IP or version changes.
+    // 中文: 回复中的静态部分，仅在 IP 或版本变化时重建。
+    char _replyPrefix[160];
+    int _replyPrefixLen = 0;
+    uint32_t _replyIp = 0;
+
+    // EN: Replies waiting for their random delay (spreads answers from a large subnet).
+    // 中文: 等待随机延迟后发送的回复（把大网段的回复在时间上打散）。
+    struct PendingReply {
+        IPAddress ip;
+        uint16_t port = 0;
+        unsigned long dueAt = 0;
+        bool used = false;
+    };
+    static const int kMaxPendingReplies = 8;
+    PendingReply _pending[kMaxPendingReplies];
+    bool _mdnsActive = false;
+
+    // --- Wi-Fi supervisor / Wi-Fi 守护 ---
+    enum class WifiState : uint8_t { Idle, Connected, Backoff, FastConnecting, ScanConnecting };
+    WifiState _wifiState = WifiState::Idle;
+    WifiStats _wifiStats;
+    String _ssid;
+    String _psk;
+    uint8_t _bssid[6] = {0, 0, 0, 0, 0, 0};
+    int32_t _channel = 0;
+    bool _haveBssid = false;
+    unsigned long _outageStart = 0;
+    unsigned long _attemptStart = 0;
+    unsigned long _nextAttemptAt = 0;
+    unsigned long _backoffMs = 0;
+
+    /**
+     * @brief Saves BSSID/channel of the live link (NVS write only when they change).
+     * @brief 保存当前链路的 BSSID/信道（仅在变化时写入 NVS）。
+     */
+    void rememberAccessPoint();
+
+    /**
+     * @brief Re-binds UDP discovery and mDNS after the link comes back.
+     * @brief 链路恢复后重新绑定 UDP 发现与 mDNS。
+     */
+    void restartNetServices();
+
+    /**
+     * @brief Rebuilds the cached reply prefix from the current IP/MAC/version.
+     * @brief 根据当前 IP/MAC/版本重建缓存的回复前缀。
+     */
+    void rebuildDiscoveryReply();
+
+    /**
+     * @brief Sends one reply (prefix + live load hints) to the given peer.
+     * @brief 向指定对端发送一次回复（前缀 + 实时负载提示）。
+     */
+    void sendDiscoveryReply(const IPAddress& ip, uint16_t port);
+
+    /**
+     * @brief Registers the mDNS hostname and DNS-SD services.
+     * @brief 注册 mDNS 主机名与 DNS-SD 服务。
+     */
+    void beginMdns();
 };
 
 #endif
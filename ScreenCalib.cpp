@@ -0,0 +1,247 @@
+// ScreenCalib: least-squares calibration solver, NVS persistence and Q16 transform building.
+// ScreenCalib：最小二乘校准求解、NVS 持久化与 Q16 变换生成。
+#include "Config.h"
+#include "ScreenCalib.h"
+#include <ArduinoJson.h>
+#include <math.h>
+
+static const int kMaxCalibPoints = 8;
+
+// 未校准时的线性映射（等价于 map(v, 0, W, 0, 32767)）/ Plain linear mapping used without calibration
+static void linearMatrix(int screenW, int screenH, double m[6]) {
+    m[0] = (double)DIGITIZER_MAX / max(1, screenW); m[1] = 0; m[2] = 0;
+    m[3] = 0; m[4] = (double)DIGITIZER_MAX / max(1, screenH); m[5] = 0;
+}
+
+// 逻辑坐标（旋转后的应用画面）→ 自然竖屏像素 / Logical (rotated app frame) → natural portrait pixels
+static void rotationMatrix(int rotation, int screenW, int screenH, double r[6]) {
+    switch (rotation) {
+    case 90:  r[0] = 0;  r[1] = -1; r[2] = screenW; r[3] = 1;  r[4] = 0;  r[5] = 0;       break;
+    case 180: r[0] = -1; r[1] = 0;  r[2] = screenW; r[3] = 0;  r[4] = -1; r[5] = screenH; break;
+    case 270: r[0] = 0;  r[1] = 1;  r[2] = 0;       r[3] = -1; r[4] = 0;  r[5] = screenH; break;
+    default:  r[0] = 1;  r[1] = 0;  r[2] = 0;       r[3] = 0;  r[4] = 1;  r[5] = 0;       break;
+    }
+}
+
+// 3×3 行列式 / 3×3 determinant
+static double det3(const double k[3][3]) {
+    return k[0][0] * (k[1][1] * k[2][2] - k[1][2] * k[2][1])
+         - k[0][1] * (k[1][0] * k[2][2] - k[1][2] * k[2][0])
+         + k[0][2] * (k[1][0] * k[2][1] - k[1][1] * k[2][0]);
+}
+
+// Cramer 法求解 k·s = rhs / Solve k·s = rhs with Cramer's rule
+static void solve3(const double k[3][3], double det, const double rhs[3], double s[3]) {
+    for (int col = 0; col < 3; col++) {
+        double t[3][3];
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) t[r][c] = (c == col) ? rhs[r] : k[r][c];
+        }
+        s[col] = det3(t) / det;
+    }
+}
+
+const CalibEntry* ScreenCalibration::find(int screenW, int screenH) const {
+    for (int i = 0; i < count; i++) {
+        if (entries[i].screenW == screenW && entries[i].screenH == screenH) return &entries[i];
+    }
+    return nullptr;
+}
+
+void ScreenCalibration::load() {
+    pref.begin("calib", true);
+    count = min((int)pref.getUChar("n", 0), kMaxEntries);
+    if (count > 0 && pref.getBytes("tbl", entries, sizeof(CalibEntry) * count) != sizeof(CalibEntry) * count) {
+        count = 0;
+    }
+    pref.end();
+}
+
+void ScreenCalibration::save() {
+    pref.begin("calib", false);
+    pref.putUChar("n", (uint8_t)count);
+    if (count > 0) pref.putBytes("tbl", entries, sizeof(CalibEntry) * count);
+    else pref.remove("tbl");
+    pref.end();
+    gen++;
+}
+
+// Load the table and register routes
+void ScreenCalibration::begin(WebServer* srv) {
+    server = srv;
+    load();
+    DEBUG_PRINTF("[Calib] %d calibrated screen(s)\n", count);
+    if (server) {
+        server->on("/calibrate", HTTP_GET, [this]() { handleGet(); });
+        server->on("/calibrate", HTTP_POST, [this]() { handlePost(); });
+    }
+}
+
+// 组合：数位板 = M · R · 逻辑坐标，并转为 Q16 / Compose digitizer = M · R · logical and convert to Q16
+static void composeQ16(const double m[6], int screenW, int screenH, int rotation, AffineQ16& out) {
+    double r[6];
+    rotationMatrix(rotation, screenW, screenH, r);
+    double a = m[0] * r[0] + m[1] * r[3];
+    double b = m[0] * r[1] + m[1] * r[4];
+    double c = m[0] * r[2] + m[1] * r[5] + m[2];
+    double d = m[3] * r[0] + m[4] * r[3];
+    double e = m[3] * r[1] + m[4] * r[4];
+    double f = m[3] * r[2] + m[4] * r[5] + m[5];
+
+    out.a = (int32_t)lround(a * 65536.0);
+    out.b = (int32_t)lround(b * 65536.0);
+    out.c = (int64_t)llround(c * 65536.0);
+    out.d = (int32_t)lround(d * 65536.0);
+    out.e = (int32_t)lround(e * 65536.0);
+    out.f = (int64_t)llround(f * 65536.0);
+}
+
+bool ScreenCalibration::buildTransform(int screenW, int screenH, int rotation, AffineQ16& out) const {
+    const CalibEntry* entry = find(screenW, screenH);
+    if (!entry) {
+        buildLinearTransform(screenW, screenH, rotation, out);
+        return false;
+    }
+    double m[6];
+    for (int i = 0; i < 6; i++) m[i] = entry->m[i];
+    composeQ16(m, screenW, screenH, rotation, out);
+    return true;
+}
+
+void ScreenCalibration::buildLinearTransform(int screenW, int screenH, int rotation, AffineQ16& out) {
+    double m[6];
+    linearMatrix(screenW, screenH, m);
+    composeQ16(m, screenW, screenH, rotation, out);
+}
+
+// HTTP GET /calibrate: stored matrices
+void ScreenCalibration::handleGet() {
+    StaticJsonDocument<1024> doc;
+    JsonArray arr = doc.createNestedArray("entries");
+    for (int i = 0; i < count; i++) {
+        JsonObject o = arr.createNestedObject();
+        o["screen_w"] = entries[i].screenW;
+        o["screen_h"] = entries[i].screenH;
+        JsonArray mat = o.createNestedArray("matrix");
+        for (int k = 0; k < 6; k++) mat.add(entries[i].m[k]);
+    }
+    doc["max_entries"] = kMaxEntries;
+    String out;
+    serializeJson(doc, out);
+    server->send(200, "application/json", out);
+}
+
+// HTTP POST /calibrate: solve from tapped reference points, or clear one screen
+// 每个点：x/y 为用 /action 点击的目标像素，tx/ty 为手机上实际落点像素（如“指针位置”开发者选项）。
+// EN: Each point: x/y is the pixel tapped via /action, tx/ty is where the touch actually landed on the phone.
+void ScreenCalibration::handlePost() {
+    StaticJsonDocument<1024> doc;
+    if (deserializeJson(doc, server->arg("plain"))) {
+        server->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+        return;
+    }
+    int screenW = doc["screen_w"] | 0;
+    int screenH = doc["screen_h"] | 0;
+    if (screenW <= 0 || screenH <= 0 || screenW > 0xFFFF || screenH > 0xFFFF) {
+        server->send(400, "application/json", "{\"error\":\"screen_w/screen_h required\"}");
+        return;
+    }
+
+    int idx = -1;
+    for (int i = 0; i < count; i++) {
+        if (entries[i].screenW == screenW && entries[i].screenH == screenH) idx = i;
+    }
+
+    if (doc["clear"] | false) {
+        if (idx >= 0) {
+            for (int i = idx; i < count - 1; i++) entries[i] = entries[i + 1];
+            count--;
+            save();
+        }
+        server->send(200, "application/json", "{\"status\":\"cleared\"}");
+        return;
+    }
+
+    JsonArray pts = doc["points"].as<JsonArray>();
+    int n = pts.isNull() ? 0 : (int)pts.size();
+    if (n < 3 || n > kMaxCalibPoints) {
+        server->send(400, "application/json", "{\"error\":\"3-8 points required\"}");
+        return;
+    }
+
+    // 点击时使用的映射（已有校准或线性映射）/ Mapping the taps were sent with (existing calibration or linear)
+    double cur[6];
+    if (idx >= 0) {
+        for (int i = 0; i < 6; i++) cur[i] = entries[idx].m[i];
+    } else {
+        linearMatrix(screenW, screenH, cur);
+    }
+
+    // 最小二乘拟合：实际落点 → 当时发送的数位板坐标。即“要落在该像素，需要发送的坐标”。
+    // EN: Least-squares fit from observed pixel → digitizer value that was sent, i.e. "what to send to land here".
+    double ata[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
+    double atx[3] = {0, 0, 0};
+    double aty[3] = {0, 0, 0};
+    double obs[kMaxCalibPoints][2];
+    double sent[kMaxCalibPoints][2];
+    for (int i = 0; i < n; i++) {
+        JsonObject p = pts[i];
+        double x = p["x"] | 0.0, y = p["y"] | 0.0;
+        double ox = p["tx"] | x, oy = p["ty"] | y;
+        obs[i][0] = ox; obs[i][1] = oy;
+        sent[i][0] = cur[0] * x + cur[1] * y + cur[2];
+        sent[i][1] = cur[3] * x + cur[4] * y + cur[5];
+        double row[3] = {ox, oy, 1.0};
+        for (int r = 0; r < 3; r++) {
+            for (int c = 0; c < 3; c++) ata[r][c] += row[r] * row[c];
+            atx[r] += row[r] * sent[i][0];
+            aty[r] += row[r] * sent[i][1];
+        }
+    }
+
+    double det = det3(ata);
+    double scale = (double)screenW * screenH;
+    if (fabs(det) < 1e-6 * scale * scale) {
+        server->send(400, "application/json", "{\"error\":\"Points are collinear\"}");
+        return;
+    }
+    double sx[3], sy[3];
+    solve3(ata, det, atx, sx);
+    solve3(ata, det, aty, sy);
+
+    // 残差（数位板单位）/ Fit residual (digitizer units)
+    double sq = 0;
+    for (int i = 0; i < n; i++) {
+        double fx = sx[0] * obs[i][0] + sx[1] * obs[i][1] + sx[2] - sent[i][0];
+        double fy = sy[0] * obs[i][0] + sy[1] * obs[i][1] + sy[2] - sent[i][1];
+        sq += fx * fx + fy * fy;
+    }
+    double rms = sqrt(sq / n);
+
+    if (idx < 0) {
+        if (count == kMaxEntries) {
+            // 表满时淘汰最早的一条 / Evict the oldest entry when full
+            for (int i = 0; i < count - 1; i++) entries[i] = entries[i + 1];
+            count--;
+        }
+        idx = count++;
+    }
+    CalibEntry& e = entries[idx];
+    e.screenW = (uint16_t)screenW;
+    e.screenH = (uint16_t)screenH;
+    e.m[0] = sx[0]; e.m[1] = sx[1]; e.m[2] = sx[2];
+    e.m[3] = sy[0]; e.m[4] = sy[1]; e.m[5] = sy[2];
+    save();
+    DEBUG_PRINTF("[Calib] %dx%d solved from %d points, rms=%.1f\n", screenW, screenH, n, rms);
+
+    StaticJsonDocument<256> res;
+    res["status"] = "ok";
+    res["screen_w"] = screenW;
+    res["screen_h"] = screenH;
+    JsonArray mat = res.createNestedArray("matrix");
+    for (int k = 0; k < 6; k++) mat.add(e.m[k]);
+    res["rms"] = rms;
+    String out;
+    serializeJson(res, out);
+    server->send(200, "application/json", out);
+}
@@ -0,0 +1,70 @@
+#ifndef SCREENCALIB_H
+#define SCREENCALIB_H
+
+// ScreenCalib: per-screen affine calibration (rotation/scale/offset) from screen pixels to digitizer units.
+// ScreenCalib：按屏幕尺寸保存的仿射校准（旋转/缩放/偏移），把屏幕像素映射到数位板坐标。
+#include <Arduino.h>
+#include <WebServer.h>
+#include <Preferences.h>
+
+// 数位板坐标上限（与 HID 描述符的逻辑最大值一致）/ Digitizer max (matches the HID logical maximum)
+static const int32_t DIGITIZER_MAX = 32767;
+
+// Q16 定点 2×3 仿射矩阵：dx = (a*x + b*y + c) >> 16，dy = (d*x + e*y + f) >> 16
+// Q16 fixed-point 2×3 affine: dx = (a*x + b*y + c) >> 16, dy = (d*x + e*y + f) >> 16
+struct AffineQ16 {
+    int32_t a = 0, b = 0;
+    int64_t c = 0;
+    int32_t d = 0, e = 0;
+    int64_t f = 0;
+
+    inline void apply(int x, int y, long& outX, long& outY) const {
+        int64_t vx = ((int64_t)a * x + (int64_t)b * y + c + 0x8000) >> 16;
+        int64_t vy = ((int64_t)d * x + (int64_t)e * y + f + 0x8000) >> 16;
+        outX = vx < 0 ? 0 : (vx > DIGITIZER_MAX ? DIGITIZER_MAX : (long)vx);
+        outY = vy < 0 ? 0 : (vy > DIGITIZER_MAX ? DIGITIZER_MAX : (long)vy);
+    }
+};
+
+// 一条校准记录（浮点，只在求解/持久化时使用）/ One calibration entry (float; only used to solve/persist)
+struct CalibEntry {
+    uint16_t screenW = 0;
+    uint16_t screenH = 0;
+    float m[6] = {0, 0, 0, 0, 0, 0}; // 像素 → 数位板 / pixel → digitizer: [a b c; d e f]
+};
+
+class ScreenCalibration {
+public:
+    static const int kMaxEntries = 4;
+
+    void begin(WebServer* srv);
+
+    /**
+     * @brief Builds the fixed-point transform for a screen size and rotation (0/90/180/270).
+     * @brief 为指定屏幕尺寸与旋转角（0/90/180/270）生成定点变换。
+     * @return True if a stored calibration was used, false for the plain linear mapping.
+     * @return 使用了已保存的校准返回 true，否则为普通线性映射返回 false。
+     */
+    bool buildTransform(int screenW, int screenH, int rotation, AffineQ16& out) const;
+
+    // 无校准表时的线性映射 + 旋转 / Linear mapping + rotation when no table is attached
+    static void buildLinearTransform(int screenW, int screenH, int rotation, AffineQ16& out);
+
+    // 每次表变化递增，供调用方判断缓存是否失效 / Bumped on every table change so callers can invalidate caches
+    uint32_t generation() const { return gen; }
+
+private:
+    Preferences pref;
+    WebServer* server = nullptr;
+    CalibEntry entries[kMaxEntries];
+    int count = 0;
+    uint32_t gen = 1;
+
+    const CalibEntry* find(int screenW, int screenH) const;
+    void load();
+    void save();
+    void handleGet();
+    void handlePost();
+};
+
+#endif
@@ -0,0 +1,122 @@
+// StatusLed: timeline evaluation for Solid/Blink/Breathe/Sequence patterns.
+// StatusLed：常亮/闪烁/呼吸/序列灯效的时间线计算。
+#include "StatusLed.h"
+
+void StatusLed::beginRgb(int pin) {
+    _pin = pin;
+    _isRgb = true;
+    _written = 0xFFFFFFFF;
+    off();
+}
+
+void StatusLed::beginGpio(int pin, bool activeHigh) {
+    _pin = pin;
+    _isRgb = false;
+    _activeHigh = activeHigh;
+    pinMode(pin, OUTPUT);
+    _written = 0xFFFFFFFF;
+    off();
+}
+
+void StatusLed::play(const LedPattern& pattern) {
+    portENTER_CRITICAL(&_mux);
+    _queued = pattern;
+    _dirty = true;
+    _done = false;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void StatusLed::solid(uint32_t color) {
+    LedPattern p;
+    p.mode = LedMode::Solid;
+    p.color = color;
+    play(p);
+}
+
+void StatusLed::off() {
+    LedPattern p;
+    p.mode = LedMode::Off;
+    play(p);
+}
+
+// Scale each channel of 0xRRGGBB by level/255
+static uint32_t scaleColor(uint32_t color, uint32_t level) {
+    uint32_t r = ((color >> 16) & 0xFF) * level / 255;
+    uint32_t g = ((color >> 8) & 0xFF) * level / 255;
+    uint32_t b = (color & 0xFF) * level / 255;
+    return (r << 16) | (g << 8) | b;
+}
+
+uint32_t StatusLed::colorAt(unsigned long elapsed, bool& finished) const {
+    finished = false;
+    switch (_pattern.mode) {
+    case LedMode::Off:
+        finished = true;
+        return 0;
+    case LedMode::Solid:
+        finished = true;
+        return _pattern.color;
+    case LedMode::Blink:
+    case LedMode::Breathe: {
+        unsigned long period = _pattern.periodMs ? _pattern.periodMs : 1000;
+        if (_pattern.repeats && elapsed >= period * _pattern.repeats) {
+            finished = true;
+            return 0;
+        }
+        unsigned long phase = elapsed % period;
+        if (_pattern.mode == LedMode::Blink) return phase < period / 2 ? _pattern.color : 0;
+        // EN: Quantize to 32 levels so the LED is rewritten at most ~64 times per period.
+        // 中文: 量化为 32 级，每个周期最多重写约 64 次。
+        unsigned long half = period / 2;
+        unsigned long ramp = phase < half ? phase : period - phase;
+        uint32_t level = half ? (uint32_t)(ramp * 31 / half) * 255 / 31 : 255;
+        return scaleColor(_pattern.color, level);
+    }
+    case LedMode::Sequence: {
+        if (!_pattern.steps || _pattern.stepCount == 0) {
+            finished = true;
+            return 0;
+        }
+        unsigned long cycle = 0;
+        for (uint8_t i = 0; i < _pattern.stepCount; i++) cycle += _pattern.steps[i].ms;
+        if (cycle == 0 || (_pattern.repeats && elapsed >= cycle * _pattern.repeats)) {
+            finished = true;
+            return 0;
+        }
+        unsigned long t = elapsed % cycle;
+        for (uint8_t i = 0; i < _pattern.stepCount; i++) {
+            if (t < _pattern.steps[i].ms) return _pattern.steps[i].color;
+            t -= _pattern.steps[i].ms;
+        }
+        return 0;
+    }
+    }
+    return 0;
+}
+
+void StatusLed::write(uint32_t color) {
+    if (_pin < 0 || color == _written) return;
+    _written = color;
+    if (_isRgb) {
+        neopixelWrite(_pin, (color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF);
+    } else {
+        bool on = color != 0;
+        digitalWrite(_pin, on == _activeHigh ? HIGH : LOW);
+    }
+}
+
+void StatusLed::tick() {
+    if (_dirty) {
+        portENTER_CRITICAL(&_mux);
+        _pattern = _queued;
+        _dirty = false;
+        portEXIT_CRITICAL(&_mux);
+        _startedAt = millis();
+    }
+    bool finished = false;
+    uint32_t color = colorAt(millis() - _startedAt, finished);
+    // EN: Solid/Off patterns count as done once applied; finite Blink/Sequence when their cycles end.
+    // 中文: 常亮/熄灭在应用后即视为完成；有限次数的闪烁/序列在周期结束后完成。
+    if (finished && !_dirty) _done = true;
+    write(color);
+}
@@ -0,0 +1,80 @@
+#ifndef STATUSLED_H
+#define STATUSLED_H
+
+// StatusLed: non-blocking, table-driven LED pattern engine (RMT-driven WS2812 or plain GPIO).
+// StatusLed：非阻塞、表驱动的 LED 灯效引擎（RMT 驱动的 WS2812 或普通 GPIO）。
+#include <Arduino.h>
+
+// 灯效类型 / Pattern kind
+enum class LedMode : uint8_t {
+    Off,
+    Solid,    // 常亮 / steady color
+    Blink,    // 亮灭各半周期 / on for half the period, off for the other half
+    Breathe,  // 三角波呼吸 / triangle-wave brightness
+    Sequence, // 按步骤表播放 / play a table of (color, duration) steps
+};
+
+// 序列中的一步 / One step of a sequence
+struct LedStep {
+    uint32_t color; // 0xRRGGBB
+    uint16_t ms;    // 持续时间 / duration
+};
+
+// 声明式灯效描述 / Declarative pattern description
+struct LedPattern {
+    LedMode mode = LedMode::Off;
+    uint32_t color = 0;            // Solid/Blink/Breathe 颜色 / color for Solid/Blink/Breathe
+    uint16_t periodMs = 1000;      // Blink/Breathe 周期 / full period for Blink/Breathe
+    const LedStep* steps = nullptr; // Sequence 步骤表 / steps for Sequence
+    uint8_t stepCount = 0;
+    uint8_t repeats = 0;           // 播放次数，0 = 无限 / number of cycles, 0 = forever
+};
+
+/**
+ * @class StatusLed
+ * @brief Advances the active pattern from timestamps in tick(); writes the LED only when the color changes.
+ * @brief 在 tick() 中按时间戳推进当前灯效；仅在颜色变化时写 LED。
+ *
+ * EN: The WS2812 path uses the core's RMT driver (neopixelWrite), which clocks the bits out in
+ * EN: hardware, so no interrupts are disabled around BLE/Wi-Fi activity.
+ * 中文: WS2812 通过内核的 RMT 驱动（neopixelWrite）输出，由硬件产生波形，
+ * 中文: 不会在 BLE/Wi-Fi 活动期间关闭中断。
+ */
+class StatusLed {
+public:
+    // 初始化 WS2812 (RMT) / init a WS2812 on `pin` (RMT)
+    void beginRgb(int pin);
+    // 初始化普通 GPIO 灯 / init a plain GPIO LED
+    void beginGpio(int pin, bool activeHigh);
+
+    // 开始播放灯效（可从其它任务调用）/ start a pattern (safe to call from another task)
+    void play(const LedPattern& pattern);
+    void solid(uint32_t color);
+    void off();
+
+    // 推进时间线并按需写灯 / advance the timeline and write the LED if needed
+    void tick();
+
+    // 有限次数的灯效是否已播完 / whether a finite pattern has finished
+    bool isDone() const { return _done; }
+
+    static uint32_t rgb(uint8_t r, uint8_t g, uint8_t b) { return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b; }
+
+private:
+    int _pin = -1;
+    bool _isRgb = false;
+    bool _activeHigh = true;
+
+    LedPattern _pattern;
+    unsigned long _startedAt = 0;
+    volatile bool _done = true;
+    volatile bool _dirty = false;  // 新灯效待应用 / a new pattern was queued
+    LedPattern _queued;
+    uint32_t _written = 0xFFFFFFFF; // 上次写出的颜色 / last color written
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+
+    uint32_t colorAt(unsigned long elapsed, bool& finished) const;
+    void write(uint32_t color);
+};
+
+#endif
@@ -0,0 +1,102 @@
+// SysMonitor: implementation of heap sampling, stack high-water marks and 503 admission control.
+// SysMonitor：堆采样、任务栈高水位与 503 准入控制的实现。
+#include "Config.h"
+#include "SysMonitor.h"
+#include "EventLog.h"
+#include <ArduinoJson.h>
+#include <esp_heap_caps.h>
+
+// 需要报告栈高水位的任务名 / Tasks whose stack high-water mark is reported
+static const char* const kWatchedTasks[] = {"loopTask", "nimble_host", "tiT", "wifi", "ota_dl", "ota_chk"};
+
+// Take one heap sample
+void SysMonitor::takeSample() {
+    sample.at = millis();
+    sample.freeInternal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    sample.largestInternal = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    sample.minEverInternal = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    sample.freePsram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    sample.largestPsram = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+    if (sample.largestInternal < lowestLargestInternal) lowestLargestInternal = sample.largestInternal;
+}
+
+// Load threshold and register routes
+void SysMonitor::begin(WebServer* srv) {
+    server = srv;
+    pref.begin("sys_mon", true);
+    minLargestBlock = pref.getUInt("min_block", minLargestBlock);
+    sampleIntervalMs = pref.getULong("interval", sampleIntervalMs);
+    pref.end();
+    takeSample();
+    lastSampleAt = sample.at;
+
+    if (server) {
+        server->on("/sys/heap", HTTP_GET, [this]() { handleGet(); });
+        server->on("/sys/heap", HTTP_POST, [this]() { handlePost(); });
+    }
+}
+
+// Periodic sampling from loop()
+void SysMonitor::tick() {
+    if (millis() - lastSampleAt < sampleIntervalMs) return;
+    lastSampleAt = millis();
+    takeSample();
+}
+
+// Admission check against the live largest free block
+bool SysMonitor::admit() {
+    uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (largest < lowestLargestInternal) lowestLargestInternal = largest;
+    if (largest >= minLargestBlock) return true;
+    rejected++;
+    LOG_EV(MemReject, (int32_t)largest, (int32_t)minLargestBlock);
+    return false;
+}
+
+void SysMonitor::rejectLowMemory() {
+    if (server) server->send(503, "application/json", "{\"error\":\"Low memory\"}");
+}
+
+// HTTP GET /sys/heap: latest sample + per-task stack high-water marks
+void SysMonitor::handleGet() {
+    takeSample();
+    StaticJsonDocument<768> doc;
+    doc["uptime_ms"] = millis();
+    doc["free_internal"] = sample.freeInternal;
+    doc["largest_internal"] = sample.largestInternal;
+    doc["min_ever_internal"] = sample.minEverInternal;
+    doc["lowest_largest_internal"] = lowestLargestInternal;
+    doc["free_psram"] = sample.freePsram;
+    doc["largest_psram"] = sample.largestPsram;
+    doc["min_largest_block"] = minLargestBlock;
+    doc["interval_ms"] = sampleIntervalMs;
+    doc["rejected"] = rejected;
+
+    // 栈高水位（字节）/ Stack high-water marks (bytes left at the deepest point)
+    JsonObject stacks = doc.createNestedObject("stack_hwm");
+    for (const char* name : kWatchedTasks) {
+        TaskHandle_t h = xTaskGetHandle(name);
+        if (h) stacks[name] = (uint32_t)uxTaskGetStackHighWaterMark(h);
+    }
+
+    String out;
+    serializeJson(doc, out);
+    server->send(200, "application/json", out);
+}
+
+// HTTP POST /sys/heap: {"min_largest_block": bytes, "interval_ms": ms}
+void SysMonitor::handlePost() {
+    StaticJsonDocument<128> doc;
+    if (deserializeJson(doc, server->arg("plain"))) {
+        server->send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+        return;
+    }
+    if (doc.containsKey("min_largest_block")) minLargestBlock = doc["min_largest_block"].as<uint32_t>();
+    if (doc.containsKey("interval_ms")) sampleIntervalMs = max(500UL, doc["interval_ms"].as<unsigned long>());
+
+    pref.begin("sys_mon", false);
+    pref.putUInt("min_block", minLargestBlock);
+    pref.putULong("interval", sampleIntervalMs);
+    pref.end();
+    server->send(200, "application/json", "{\"status\":\"ok\"}");
+}
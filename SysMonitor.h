@@ -0,0 +1,47 @@
+#ifndef SYSMONITOR_H
+#define SYSMONITOR_H
+
+// SysMonitor: periodic heap/PSRAM/stack telemetry and memory-pressure admission control.
+// SysMonitor：周期性采集堆/PSRAM/栈水位，并在内存紧张时做准入控制。
+#include <Arduino.h>
+#include <WebServer.h>
+#include <Preferences.h>
+
+// 一次采样 / One telemetry sample
+struct HeapSample {
+    unsigned long at = 0;          // 采样时刻 millis / sample time (millis)
+    uint32_t freeInternal = 0;     // 内部堆剩余 / free internal heap
+    uint32_t largestInternal = 0;  // 内部堆最大连续块 / largest free internal block
+    uint32_t minEverInternal = 0;  // 内部堆历史最低 / minimum-ever free internal heap
+    uint32_t freePsram = 0;        // PSRAM 剩余 / free PSRAM
+    uint32_t largestPsram = 0;     // PSRAM 最大连续块 / largest free PSRAM block
+};
+
+class SysMonitor {
+public:
+    void begin(WebServer* srv);
+    void tick();
+
+    // 准入检查：最大连续块低于阈值时返回 false / Admission: false when the largest block is below the threshold
+    bool admit();
+    // 以 503 拒绝请求 / Reject the current request with 503
+    void rejectLowMemory();
+
+    const HeapSample& last() const { return sample; }
+
+private:
+    Preferences pref;
+    WebServer* server = nullptr;
+    HeapSample sample;
+    uint32_t lowestLargestInternal = 0xFFFFFFFF; // 最大连续块的历史最低 / lowest largest-block seen
+    uint32_t minLargestBlock = 12 * 1024;        // 准入阈值 / admission threshold (bytes)
+    unsigned long sampleIntervalMs = 5000;
+    unsigned long lastSampleAt = 0;
+    uint32_t rejected = 0;                       // 被拒绝的请求数 / rejected request count
+
+    void takeSample();
+    void handleGet();
+    void handlePost();
+};
+
+#endif
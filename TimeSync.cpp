@@ -0,0 +1,145 @@
+// TimeSync: implementation of the UDP offset estimator and deadline sleep helper.
+// TimeSync：UDP 偏移估计器与截止时刻睡眠辅助函数的实现。
+#include "Config.h"
+#include "TimeSync.h"
+#include <WiFi.h>
+#include <esp_timer.h>
+
+// EN: Local UDP port used for probes, and assumed worst-case crystal drift (ppm) for the error bound.
+// 中文: 探测所用的本地 UDP 端口，以及误差上界中假设的最大晶振漂移（ppm）。
+static const uint16_t TIME_SYNC_LOCAL_PORT = 48322;
+static const int64_t TIME_SYNC_DRIFT_PPM = 40;
+// EN: An offset older than this many intervals (a server gone quiet) no longer counts as synced for `at` actions.
+// 中文: 超过这么多个周期未更新的偏移（服务器已无响应）不再视为可用于 `at` 动作的同步。
+static const unsigned long TIME_SYNC_STALE_INTERVALS = 3;
+static const unsigned long TIME_SYNC_MIN_STALE_MS = 30000;
+
+void TimeSync::begin() {
+    pref.begin("time_sync", true);
+    _host = pref.getString("host", "");
+    _port = pref.getUShort("port", 48330);
+    _intervalMs = pref.getULong("interval", 10000);
+    pref.end();
+
+    _udpActive = _udp.begin(TIME_SYNC_LOCAL_PORT);
+    if (_host.length() > 0) {
+        DEBUG_PRINTF("[TimeSync] Server %s:%u, every %lu ms\n", _host.c_str(), _port, _intervalMs);
+    }
+}
+
+void TimeSync::configure(const String& host, uint16_t port, unsigned long intervalMs) {
+    _host = host;
+    _port = port;
+    _intervalMs = max(1000UL, intervalMs);
+    _synced = false;
+    _samples = 0;
+    _burstSent = 0;
+    _lastBurstAt = 0;
+
+    pref.begin("time_sync", false);
+    pref.putString("host", _host);
+    pref.putUShort("port", _port);
+    pref.putULong("interval", _intervalMs);
+    pref.end();
+}
+
+int64_t TimeSync::errorUs() const {
+    if (!_synced) return -1;
+    int64_t age = esp_timer_get_time() - _syncedAtLocalUs;
+    return _rttUs / 2 + age * TIME_SYNC_DRIFT_PPM / 1000000;
+}
+
+int64_t TimeSync::nowUs() const {
+    return esp_timer_get_time() + _offsetUs;
+}
+
+unsigned long TimeSync::lastSyncAgeMs() const {
+    if (!_synced) return 0;
+    return (unsigned long)((esp_timer_get_time() - _syncedAtLocalUs) / 1000);
+}
+
+bool TimeSync::isFresh() const {
+    if (!_synced) return false;
+    return lastSyncAgeMs() <= max(TIME_SYNC_MIN_STALE_MS, _intervalMs * TIME_SYNC_STALE_INTERVALS);
+}
+
+int64_t TimeSync::sleepUntilLocalUs(int64_t localUs) {
+    int64_t now = esp_timer_get_time();
+    // EN: Coarse sleep leaves ~2ms for the spin so scheduler slop doesn't make us late.
+    // 中文: 粗粒度睡眠预留约 2ms 自旋，避免调度误差导致迟到。
+    if (localUs - now > 3000) {
+        delay((uint32_t)((localUs - now - 2000) / 1000));
+    }
+    while ((now = esp_timer_get_time()) < localUs) {
+    }
+    return now - localUs;
+}
+
+void TimeSync::sendProbe() {
+    char msg[48];
+    int len = snprintf(msg, sizeof(msg), "TSYNC1 %lu %lld", (unsigned long)++_seq, (long long)esp_timer_get_time());
+    _udp.beginPacket(_host.c_str(), _port);
+    _udp.write((const uint8_t*)msg, len);
+    _udp.endPacket();
+}
+
+void TimeSync::readReplies() {
+    int size;
+    while ((size = _udp.parsePacket()) > 0) {
+        int64_t t4 = esp_timer_get_time();
+        char buf[96];
+        int len = _udp.read(buf, sizeof(buf) - 1);
+        if (len <= 0) continue;
+        buf[len] = '\0';
+
+        unsigned long seq;
+        long long t1, t2, t3;
+        if (sscanf(buf, "TSYNC1 %lu %lld %lld %lld", &seq, &t1, &t2, &t3) != 4) continue;
+        int64_t rtt = (t4 - t1) - (t3 - t2);
+        if (rtt < 0 || t1 > t4) continue;
+        int64_t offset = ((t2 - t1) + (t3 - t4)) / 2;
+        // EN: Keep the lowest-RTT sample of the burst: its offset has the tightest bound.
+        // 中文: 保留本批中 RTT 最小的样本：其偏移误差界最紧。
+        if (_burstBestRtt < 0 || rtt < _burstBestRtt) {
+            _burstBestRtt = rtt;
+            _burstBestOffset = offset;
+        }
+        _samples++;
+    }
+}
+
+void TimeSync::finishBurst() {
+    if (_burstBestRtt >= 0) {
+        _offsetUs = _burstBestOffset;
+        _rttUs = _burstBestRtt;
+        _syncedAtLocalUs = esp_timer_get_time();
+        _synced = true;
+    }
+    _burstBestRtt = -1;
+    _burstSent = 0;
+}
+
+void TimeSync::tick() {
+    if (!_udpActive || _host.length() == 0 || WiFi.status() != WL_CONNECTED) return;
+
+    readReplies();
+
+    unsigned long now = millis();
+    if (_burstSent == 0) {
+        if (_lastBurstAt != 0 && now - _lastBurstAt < _intervalMs) return;
+        _lastBurstAt = now;
+        _burstBestRtt = -1;
+    } else if (now - _lastProbeAt < (unsigned long)kBurstSpacingMs) {
+        return;
+    }
+
+    if (_burstSent < kBurstSize) {
+        sendProbe();
+        _lastProbeAt = now;
+        _burstSent++;
+    } else {
+        // EN: One extra spacing after the last probe lets late replies arrive before we commit.
+        // 中文: 最后一个探测后再等一个间隔，让迟到的回复到达后再提交结果。
+        finishBurst();
+    }
+}
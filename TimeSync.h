@@ -0,0 +1,109 @@
+#ifndef TIMESYNC_H
+#define TIMESYNC_H
+
+// TimeSync: lightweight fleet clock sync against a LAN UDP time server (NTP-style 4 timestamps).
+// TimeSync：基于局域网 UDP 时间服务器的轻量级集群时钟同步（NTP 式四时间戳）。
+#include <Arduino.h>
+#include <WiFiUdp.h>
+#include <Preferences.h>
+
+/**
+ * @class TimeSync
+ * @brief Estimates the offset between esp_timer and a shared server clock (Unix epoch, µs).
+ * @brief 估算 esp_timer 与共享服务器时钟（Unix 纪元，微秒）之间的偏移。
+ *
+ * Probe  : "TSYNC1 <seq> <t1>"                 (t1 = device local µs)
+ * Reply  : "TSYNC1 <seq> <t1> <t2> <t3>"       (t2/t3 = server receive/send µs)
+ * offset = ((t2 - t1) + (t3 - t4)) / 2, error bound = RTT / 2 of the best (lowest RTT) sample.
+ */
+class TimeSync {
+public:
+    /**
+     * @brief Loads the server address from NVS and opens the UDP socket.
+     * @brief 从 NVS 读取服务器地址并打开 UDP 套接字。
+     */
+    void begin();
+
+    /**
+     * @brief Sets and persists the time server; an empty host disables sync.
+     * @brief 设置并保存时间服务器；host 为空时关闭同步。
+     */
+    void configure(const String& host, uint16_t port, unsigned long intervalMs);
+
+    /**
+     * @brief Sends probe bursts and consumes replies; call this in loop().
+     * @brief 发送探测并处理回复；在 loop() 中调用。
+     */
+    void tick();
+
+    bool isSynced() const { return _synced; }
+
+    /**
+     * @brief Synced and the last good burst is recent: within 3 sync intervals, and never less than 30 s.
+     * @brief 已同步且最近一次成功同步不算久：不超过 3 个同步周期（下限 30 秒）。
+     */
+    bool isFresh() const;
+    int64_t offsetUs() const { return _offsetUs; }
+    int64_t rttUs() const { return _rttUs; }
+
+    /**
+     * @brief Error bound (µs): best-sample RTT/2 plus drift allowance since that sample.
+     * @brief 误差上界（微秒）：最佳样本 RTT/2 加上自该样本以来的漂移余量。
+     */
+    int64_t errorUs() const;
+
+    /**
+     * @brief Current synced time (server clock, µs).
+     * @brief 当前同步后的时间（服务器时钟，微秒）。
+     */
+    int64_t nowUs() const;
+
+    /**
+     * @brief Converts a synced timestamp (µs) to the local esp_timer timeline.
+     * @brief 将同步时间戳（微秒）转换为本地 esp_timer 时间线。
+     */
+    int64_t toLocalUs(int64_t syncedUs) const { return syncedUs - _offsetUs; }
+
+    /**
+     * @brief Sleeps (coarse delay, then spin) until the local µs deadline; returns lateness in µs.
+     * @brief 睡眠到本地微秒截止时刻（先粗粒度 delay，再自旋）；返回迟到的微秒数。
+     */
+    static int64_t sleepUntilLocalUs(int64_t localUs);
+
+    const String& host() const { return _host; }
+    uint16_t port() const { return _port; }
+    unsigned long intervalMs() const { return _intervalMs; }
+    unsigned long lastSyncAgeMs() const;
+    uint32_t samples() const { return _samples; }
+
+private:
+    Preferences pref;
+    WiFiUDP _udp;
+    bool _udpActive = false;
+    String _host;
+    uint16_t _port = 0;
+    unsigned long _intervalMs = 10000;
+
+    // --- Burst state / 探测批次状态 ---
+    static const int kBurstSize = 8;       // EN: Probes per burst. / 中文: 每批探测数。
+    static const int kBurstSpacingMs = 40; // EN: Gap between probes. / 中文: 探测间隔。
+    uint32_t _seq = 0;
+    int _burstSent = 0;
+    unsigned long _lastProbeAt = 0;
+    unsigned long _lastBurstAt = 0;
+    int64_t _burstBestRtt = -1;
+    int64_t _burstBestOffset = 0;
+
+    // --- Result / 结果 ---
+    bool _synced = false;
+    int64_t _offsetUs = 0;
+    int64_t _rttUs = 0;
+    int64_t _syncedAtLocalUs = 0;
+    uint32_t _samples = 0;
+
+    void sendProbe();
+    void readReplies();
+    void finishBurst();
+};
+
+#endif
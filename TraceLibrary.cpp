@@ -0,0 +1,431 @@
+// TraceLibrary: LittleFS-backed trace storage, streaming zigzag/varint decoder and similarity-transform replay.
+// TraceLibrary：基于 LittleFS 的轨迹存储、流式 zigzag/varint 解码与相似变换回放。
+#include "Config.h"
+#include "TraceLibrary.h"
+#include <LittleFS.h>
+#include <ArduinoJson.h>
+
+static const char* TRACE_DATA_PATH = "/traces.bin";
+static const char* TRACE_INDEX_PATH = "/traces.idx";
+static const char TRACE_MAGIC[4] = {'T', 'R', 'C', '1'};
+static const int TRACE_LIST_MAX = 50;
+
+static inline int32_t unzigzag(uint32_t v) {
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+// Mount the filesystem, read the index size and register routes
+void TraceLibrary::begin(WebServer* srv) {
+    _server = srv;
+    _mounted = LittleFS.begin(true);
+    if (_mounted) refreshCounts();
+    DEBUG_PRINTF("[Trace] fs=%s, %d trace(s), %u bytes\n", _mounted ? "ok" : "unavailable", _count, (unsigned)_dataBytes);
+    if (_server) {
+        _server->on("/traces", HTTP_GET, [this]() { handleList(); });
+        _server->on("/traces", HTTP_POST, [this]() { handleUploadDone(); }, [this]() { handleUploadChunk(); });
+        _server->on("/traces", HTTP_DELETE, [this]() { handleClear(); });
+    }
+}
+
+void TraceLibrary::refreshCounts() {
+    _count = 0;
+    _dataBytes = 0;
+    File idx = LittleFS.open(TRACE_INDEX_PATH, "r");
+    if (idx) {
+        // 掉电留下的半条索引会被忽略 / A torn trailing entry (power loss) is ignored
+        _count = (int)(idx.size() / sizeof(TraceIndexEntry));
+        idx.close();
+    }
+    File data = LittleFS.open(TRACE_DATA_PATH, "r");
+    if (data) {
+        _dataBytes = data.size();
+        data.close();
+    }
+}
+
+bool TraceLibrary::readEntry(int index, TraceIndexEntry& e) {
+    if (index < 0 || index >= _count) return false;
+    File idx = LittleFS.open(TRACE_INDEX_PATH, "r");
+    if (!idx) return false;
+    bool ok = idx.seek((uint32_t)index * sizeof(TraceIndexEntry))
+           && idx.read((uint8_t*)&e, sizeof(e)) == sizeof(e);
+    idx.close();
+    return ok;
+}
+
+int TraceLibrary::findByName(const char* name, TraceIndexEntry& e) {
+    File idx = LittleFS.open(TRACE_INDEX_PATH, "r");
+    if (!idx) return -1;
+    for (int i = 0; i < _count; i++) {
+        if (idx.read((uint8_t*)&e, sizeof(e)) != sizeof(e)) break;
+        if (strncmp(e.name, name, sizeof(e.name)) == 0) {
+            idx.close();
+            return i;
+        }
+    }
+    idx.close();
+    return -1;
+}
+
+// 读出一条轨迹并还原为相对首点的绝对坐标/时刻 / Read one trace back into coordinates/times relative to the first sample
+bool TraceLibrary::decodePoints(const TraceIndexEntry& e) {
+    if (e.points < 2 || e.points > TRACE_MAX_POINTS || e.bytes > sizeof(_rec)) return false;
+    File data = LittleFS.open(TRACE_DATA_PATH, "r");
+    if (!data) return false;
+    bool ok = data.seek(e.offset) && data.read(_rec, e.bytes) == e.bytes;
+    data.close();
+    if (!ok) return false;
+
+    int pos = 0;
+    int32_t x = 0, y = 0;
+    uint32_t t = 0;
+    for (int i = 0; i < e.points; i++) {
+        uint32_t v[3];
+        for (int f = 0; f < 3; f++) {
+            uint32_t acc = 0;
+            int shift = 0;
+            while (true) {
+                if (pos >= e.bytes || shift > 14) return false;
+                uint8_t b = _rec[pos++];
+                acc |= (uint32_t)(b & 0x7F) << shift;
+                if (!(b & 0x80)) break;
+                shift += 7;
+            }
+            v[f] = acc;
+        }
+        x += unzigzag(v[0]);
+        y += unzigzag(v[1]);
+        if (i > 0) t += v[2];
+        if (i == 0) {
+            // 首点作为原点 / The first sample is the origin
+            _px[0] = 0;
+            _py[0] = 0;
+            _pt[0] = 0;
+            x = y = 0;
+            continue;
+        }
+        _px[i] = (int16_t)constrain(x, -32767, 32767);
+        _py[i] = (int16_t)constrain(y, -32767, 32767);
+        _pt[i] = t;
+    }
+    return true;
+}
+
+bool TraceLibrary::build(const char* name, int x1, int y1, int x2, int y2, int durationMs,
+                         const ActionOptions& opts, BleDriver& ble, GesturePlan& out, TraceInfo* info) {
+    if (!_mounted || _count == 0) return false;
+
+    TraceIndexEntry e;
+    int index;
+    if (name && name[0] != '\0') {
+        index = findByName(name, e);
+        if (index < 0) return false;
+    } else {
+        index = (int)random(0, _count);
+        if (!readEntry(index, e)) return false;
+    }
+    if (!decodePoints(e)) return false;
+
+    const int n = e.points;
+    const uint32_t recordedMs = _pt[n - 1];
+    int targetMs = durationMs > 0 ? durationMs : (int)recordedMs;
+    if (targetMs <= 0) targetMs = n * 10;
+
+    // 相似变换（旋转 + 等比缩放）把录制的首→末位移对齐到请求的起→终点，保留手抖与弧度
+    // EN: Similarity transform (rotation + uniform scale) maps the recorded start→end onto the requested one,
+    // EN: keeping the human wobble and arc
+    float sx = _px[n - 1], sy = _py[n - 1];
+    float tx = x2 - x1, ty = y2 - y1;
+    float len2 = sx * sx + sy * sy;
+    float a = 1.0f, b = 0.0f;
+    if (len2 >= 1.0f) {
+        a = (tx * sx + ty * sy) / len2;
+        b = (ty * sx - tx * sy) / len2;
+    }
+
+    // 按 delayInterval 等时重采样，与普通滑动共用同一回放时序 / Resample evenly at delayInterval so playback uses the normal swipe timing
+    int stepTime = opts.delayInterval;
+    if (stepTime <= 0) stepTime = 10;
+    int steps = targetMs / stepTime;
+    if (steps < 2) steps = 2;
+    uint32_t stepUs = (uint32_t)stepTime * 1000;
+    if (steps > GesturePlan::kMaxPoints) {
+        stepUs = (uint32_t)((uint64_t)steps * stepUs / GesturePlan::kMaxPoints);
+        steps = GesturePlan::kMaxPoints;
+    }
+
+    int seg = 0;
+    for (int i = 1; i <= steps; i++) {
+        float lx, ly;
+        if (recordedMs > 0) {
+            float tq = (float)recordedMs * i / steps;
+            while (seg < n - 2 && (float)_pt[seg + 1] < tq) seg++;
+            float span = (float)(_pt[seg + 1] - _pt[seg]);
+            float frac = span > 0 ? (tq - _pt[seg]) / span : 1.0f;
+            frac = constrain(frac, 0.0f, 1.0f);
+            lx = _px[seg] + frac * (_px[seg + 1] - _px[seg]);
+            ly = _py[seg] + frac * (_py[seg + 1] - _py[seg]);
+        } else {
+            // 无时间戳：按点序均匀 / No timestamps: uniform over sample order
+            float fi = (float)(n - 1) * i / steps;
+            int k = min((int)fi, n - 2);
+            float frac = fi - k;
+            lx = _px[k] + frac * (_px[k + 1] - _px[k]);
+            ly = _py[k] + frac * (_py[k + 1] - _py[k]);
+        }
+        _rx[i - 1] = x1 + (int)lroundf(a * lx - b * ly);
+        _ry[i - 1] = y1 + (int)lroundf(b * lx + a * ly);
+    }
+
+    ble.buildPath(x1, y1, _rx, _ry, steps, stepUs, opts, out);
+    if (info) {
+        info->index = index;
+        info->points = e.points;
+        info->durationMs = (uint16_t)min(recordedMs, (uint32_t)0xFFFF);
+    }
+    return true;
+}
+
+// --- Upload / 上传 ---
+// 请求体："TRC1"，随后若干条记录：u8 名称长度(0-11)、名称、varint 点数(2-512)、
+// 每点 zigzag varint dx、zigzag varint dy、varint dt_ms（相对上一点；首点相对原点，其 dt 忽略）。
+// EN: Body: "TRC1", then records: u8 name length (0-11), name, varint point count (2-512),
+// EN: per point zigzag-varint dx, zigzag-varint dy, varint dt_ms (vs the previous point; the first is vs the origin, its dt ignored).
+
+void TraceLibrary::uploadFail(const char* error) {
+    if (_up == UpState::Failed) return;
+    _upError = error;
+    _up = UpState::Failed;
+}
+
+void TraceLibrary::commitRecord() {
+    _entry.offset = _upOffset;
+    _entry.bytes = _recLen;
+    _entry.points = _recPoints;
+    _entry.durationMs = (uint16_t)_curT;
+    _entry.dx = (int16_t)_curX;
+    _entry.dy = (int16_t)_curY;
+    _entry.reserved = 0;
+
+    size_t wrote = _upData.write(_rec, _recLen);
+    _upOffset += wrote;
+    if (wrote != _recLen) {
+        uploadFail("storage full");
+        return;
+    }
+    if (_upIndex.write((const uint8_t*)&_entry, sizeof(_entry)) != sizeof(_entry)) {
+        uploadFail("storage full");
+        return;
+    }
+    _upAdded++;
+    _count++;
+    _dataBytes = _upOffset;
+}
+
+void TraceLibrary::uploadByte(uint8_t b) {
+    switch (_up) {
+    case UpState::Magic:
+        if (b != (uint8_t)TRACE_MAGIC[_magicPos]) {
+            uploadFail("bad magic");
+            return;
+        }
+        if (++_magicPos == sizeof(TRACE_MAGIC)) _up = UpState::NameLen;
+        return;
+
+    case UpState::NameLen:
+        if (b >= sizeof(_entry.name)) {
+            uploadFail("name too long");
+            return;
+        }
+        memset(_entry.name, 0, sizeof(_entry.name));
+        _nameLen = b;
+        _namePos = 0;
+        _varint = 0;
+        _varShift = 0;
+        _up = b > 0 ? UpState::Name : UpState::Count;
+        return;
+
+    case UpState::Name:
+        _entry.name[_namePos++] = (char)b;
+        if (_namePos == _nameLen) _up = UpState::Count;
+        return;
+
+    case UpState::Count:
+    case UpState::Points:
+        break;
+
+    default:
+        return;
+    }
+
+    // varint 跨块累积 / varints accumulate across chunk boundaries
+    if (_up == UpState::Points) _rec[_recLen++] = b;
+    _varint |= (uint32_t)(b & 0x7F) << _varShift;
+    if (b & 0x80) {
+        _varShift += 7;
+        if (_varShift > 14) uploadFail("varint too long");
+        return;
+    }
+    uint32_t v = _varint;
+    _varint = 0;
+    _varShift = 0;
+
+    if (_up == UpState::Count) {
+        if (v < 2 || v > TRACE_MAX_POINTS) {
+            uploadFail("point count must be 2-512");
+            return;
+        }
+        _recPoints = (uint16_t)v;
+        _recDone = 0;
+        _recLen = 0;
+        _field = 0;
+        _curX = _curY = 0;
+        _curT = 0;
+        _up = UpState::Points;
+        return;
+    }
+
+    if (_field == 0) {
+        _curX += unzigzag(v);
+    } else if (_field == 1) {
+        _curY += unzigzag(v);
+    } else if (_recDone > 0) {
+        _curT += v;
+    }
+    if (++_field < 3) return;
+    _field = 0;
+
+    if (_recDone == 0) {
+        // 位移相对首点 / Displacement is relative to the first sample
+        _curX = 0;
+        _curY = 0;
+    }
+    if (_curX < -32767 || _curX > 32767 || _curY < -32767 || _curY > 32767) {
+        uploadFail("coordinate out of range");
+        return;
+    }
+    if (_curT > 0xFFFF) {
+        uploadFail("trace longer than 65535 ms");
+        return;
+    }
+    if (++_recDone == _recPoints) {
+        commitRecord();
+        if (_up != UpState::Failed) _up = UpState::NameLen;
+    }
+}
+
+void TraceLibrary::handleUploadChunk() {
+    HTTPRaw& raw = _server->raw();
+
+    if (raw.status == RAW_START) {
+        _upError = nullptr;
+        _upAdded = 0;
+        _magicPos = 0;
+        _up = UpState::Magic;
+        if (!_mounted) {
+            uploadFail("filesystem unavailable");
+            return;
+        }
+        if (_server->arg("replace") == "1") {
+            LittleFS.remove(TRACE_DATA_PATH);
+            LittleFS.remove(TRACE_INDEX_PATH);
+            refreshCounts();
+        }
+        _upData = LittleFS.open(TRACE_DATA_PATH, "a");
+        _upIndex = LittleFS.open(TRACE_INDEX_PATH, "a");
+        if (!_upData || !_upIndex) {
+            uploadFail("open failed");
+            return;
+        }
+        _upOffset = _upData.size();
+        return;
+    }
+
+    if (raw.status == RAW_WRITE) {
+        // 逐字节解码，不需要整个请求体在内存中 / Decoded byte by byte; the body never has to fit in RAM
+        for (size_t i = 0; i < raw.currentSize && _up != UpState::Failed; i++) uploadByte(raw.buf[i]);
+        return;
+    }
+
+    if (raw.status == RAW_END || raw.status == RAW_ABORTED) {
+        if (raw.status == RAW_ABORTED) uploadFail("aborted");
+        else if (_up == UpState::Magic) uploadFail("empty body");
+        else if (_up != UpState::NameLen && _up != UpState::Failed) uploadFail("truncated record");
+        if (_upData) _upData.close();
+        if (_upIndex) _upIndex.close();
+        _up = _up == UpState::Failed ? UpState::Failed : UpState::Done;
+    }
+}
+
+// HTTP POST /traces[?replace=1]: reply after the body was consumed
+void TraceLibrary::handleUploadDone() {
+    // 请求体未走到 RAW_END（如空请求体）时在这里收尾 / Finish here when the body never reached RAW_END (e.g. empty)
+    if (_upData) _upData.close();
+    if (_upIndex) _upIndex.close();
+
+    char reply[160];
+    if (_up != UpState::Done) {
+        // 错误前已完整的记录会保留 / Records completed before the error are kept
+        snprintf(reply, sizeof(reply), "{\"error\":\"%s\",\"added\":%d,\"traces\":%d}",
+                 _upError ? _upError : "no body", _upAdded, _count);
+        _server->send(400, "application/json", reply);
+    } else {
+        DEBUG_PRINTF("[Trace] +%d trace(s), %d total, %u bytes\n", _upAdded, _count, (unsigned)_dataBytes);
+        snprintf(reply, sizeof(reply), "{\"status\":\"ok\",\"added\":%d,\"traces\":%d,\"data_bytes\":%u}",
+                 _upAdded, _count, (unsigned)_dataBytes);
+        _server->send(200, "application/json", reply);
+    }
+    _up = UpState::Failed;
+    _upError = nullptr;
+    _upAdded = 0;
+}
+
+// HTTP GET /traces[?offset=&limit=]: counts, storage and a page of the index
+void TraceLibrary::handleList() {
+    int offset = max(0, (int)_server->arg("offset").toInt());
+    int limit = _server->hasArg("limit") ? (int)_server->arg("limit").toInt() : 20;
+    limit = constrain(limit, 0, TRACE_LIST_MAX);
+
+    StaticJsonDocument<4096> doc;
+    doc["mounted"] = _mounted;
+    doc["traces"] = _count;
+    doc["data_bytes"] = _dataBytes;
+    doc["index_bytes"] = (uint32_t)_count * sizeof(TraceIndexEntry);
+    if (_mounted) {
+        doc["fs_total"] = (uint32_t)LittleFS.totalBytes();
+        doc["fs_used"] = (uint32_t)LittleFS.usedBytes();
+    }
+    JsonArray items = doc.createNestedArray("items");
+    File idx = _mounted ? LittleFS.open(TRACE_INDEX_PATH, "r") : File();
+    if (idx && offset < _count && idx.seek((uint32_t)offset * sizeof(TraceIndexEntry))) {
+        TraceIndexEntry e;
+        for (int i = offset; i < _count && i < offset + limit; i++) {
+            if (idx.read((uint8_t*)&e, sizeof(e)) != sizeof(e)) break;
+            char name[sizeof(e.name) + 1];
+            memcpy(name, e.name, sizeof(e.name));
+            name[sizeof(e.name)] = '\0';
+            JsonObject o = items.createNestedObject();
+            o["i"] = i;
+            o["name"] = name;
+            o["points"] = e.points;
+            o["duration_ms"] = e.durationMs;
+            o["dx"] = e.dx;
+            o["dy"] = e.dy;
+            o["bytes"] = e.bytes;
+        }
+    }
+    if (idx) idx.close();
+    String out;
+    serializeJson(doc, out);
+    _server->send(200, "application/json", out);
+}
+
+// HTTP DELETE /traces: drop the whole library
+void TraceLibrary::handleClear() {
+    if (_mounted) {
+        LittleFS.remove(TRACE_DATA_PATH);
+        LittleFS.remove(TRACE_INDEX_PATH);
+        refreshCounts();
+    }
+    _server->send(200, "application/json", "{\"status\":\"cleared\"}");
+}
@@ -0,0 +1,108 @@
+#ifndef TRACELIBRARY_H
+#define TRACELIBRARY_H
+
+// TraceLibrary: recorded human swipe traces in LittleFS, streamed in compressed and replayed time-scaled.
+// TraceLibrary：保存在 LittleFS 的真人滑动轨迹，压缩流式上传，回放时按起止点与时长缩放。
+#include <Arduino.h>
+#include <WebServer.h>
+#include <FS.h>
+
+#include "BleDriver.h"
+
+// 每条轨迹的最大采样点数 / Max samples per trace
+static const int TRACE_MAX_POINTS = 512;
+// 单点编码后最大字节：dx、dy 各 3 字节 zigzag varint，dt 3 字节 varint
+// EN: Max encoded bytes per sample: 3-byte zigzag varints for dx/dy, 3-byte varint for dt
+static const int TRACE_MAX_POINT_BYTES = 9;
+
+// 索引条目（定长，随机读取只需 seek）/ Index entry (fixed size, random access is one seek)
+struct TraceIndexEntry {
+    char name[12];          // 可为空 / may be empty
+    uint32_t offset;        // 点数据在 traces.bin 中的偏移 / offset of the point data in traces.bin
+    uint16_t bytes;         // 点数据字节数 / encoded point bytes
+    uint16_t points;        // 采样点数 / sample count
+    uint16_t durationMs;    // 首点到末点的时长 / first to last sample
+    int16_t dx, dy;         // 首点到末点的位移（录制像素）/ net displacement (recorded pixels)
+    uint16_t reserved;
+};
+
+// 一次回放选中的轨迹 / Trace picked for a replay
+struct TraceInfo {
+    int index = -1;
+    uint16_t points = 0;
+    uint16_t durationMs = 0;
+};
+
+class TraceLibrary {
+public:
+    // 挂载 LittleFS（首次自动格式化）并注册 /traces / Mount LittleFS (formatting on first use) and register /traces
+    void begin(WebServer* srv);
+
+    /**
+     * @brief Builds a swipe plan from a stored trace: rotated/scaled onto x1,y1→x2,y2 and stretched to durationMs.
+     * @brief 由已存轨迹生成滑动计划：旋转/缩放到 x1,y1→x2,y2，并拉伸到 durationMs。
+     * @param name Trace name, or nullptr/"" for a random trace. / 轨迹名；nullptr 或空串表示随机选取。
+     * @param durationMs Target duration, 0 keeps the recorded one. / 目标时长，0 保持录制时长。
+     * @return False if the library is empty, the name is unknown or the data is unreadable.
+     * @return 库为空、名称不存在或数据不可读时返回 false。
+     */
+    bool build(const char* name, int x1, int y1, int x2, int y2, int durationMs,
+               const ActionOptions& opts, BleDriver& ble, GesturePlan& out, TraceInfo* info = nullptr);
+
+    int count() const { return _count; }
+    bool mounted() const { return _mounted; }
+
+private:
+    WebServer* _server = nullptr;
+    bool _mounted = false;
+    int _count = 0;
+    uint32_t _dataBytes = 0;
+
+    // 上传流式解码状态 / Streaming upload decoder state
+    enum class UpState : uint8_t { Magic, NameLen, Name, Count, Points, Done, Failed };
+    UpState _up = UpState::Failed;
+    File _upData;
+    File _upIndex;
+    uint32_t _upOffset = 0;
+    const char* _upError = nullptr;
+    int _upAdded = 0;
+    uint8_t _magicPos = 0;
+    uint8_t _nameLen = 0;
+    uint8_t _namePos = 0;
+    uint32_t _varint = 0;
+    uint8_t _varShift = 0;
+    uint8_t _field = 0;            // 0 = dx，1 = dy，2 = dt
+    uint16_t _recPoints = 0;
+    uint16_t _recDone = 0;
+    uint16_t _recLen = 0;
+    int32_t _curX = 0, _curY = 0;
+    uint32_t _curT = 0;
+    TraceIndexEntry _entry;
+
+    // 单条记录缓冲：完整解码后才写入闪存，中断的上传不会留下半条轨迹
+    // EN: One-record buffer: written to flash only once fully decoded, so an aborted upload never leaves half a trace
+    uint8_t _rec[TRACE_MAX_POINTS * TRACE_MAX_POINT_BYTES];
+
+    // 回放解码/重采样缓冲 / Replay decode and resample buffers
+    int16_t _px[TRACE_MAX_POINTS];
+    int16_t _py[TRACE_MAX_POINTS];
+    uint32_t _pt[TRACE_MAX_POINTS];
+    int _rx[GesturePlan::kMaxPoints];
+    int _ry[GesturePlan::kMaxPoints];
+
+    void refreshCounts();
+    bool readEntry(int index, TraceIndexEntry& e);
+    int findByName(const char* name, TraceIndexEntry& e);
+    bool decodePoints(const TraceIndexEntry& e);
+
+    void uploadByte(uint8_t b);
+    void uploadFail(const char* error);
+    void commitRecord();
+
+    void handleList();
+    void handleUploadChunk();
+    void handleUploadDone();
+    void handleClear();
+};
+
+#endif
@@ -1,56 +1,118 @@
 #include "Config.h"
 #include "ota.h"
 #include "BleDriver.h"
+#include "BootTimeline.h"
+#include "EventLog.h"
 #include <WiFi.h>
 #include <WiFiClientSecure.h>
 #include <HTTPClient.h>
 #include <ArduinoJson.h>
 #include <Update.h>
 #include <stdlib.h> // For malloc and free
+#include <esp_heap_caps.h>
+#include <esp_random.h>
+#include <mbedtls/platform.h>
+#if __has_include(<esp_mem.h>)
+#include <esp_mem.h> // esp_mbedtls_mem_calloc/free：IDF 配置的 mbedTLS 分配器 / the IDF-configured mbedTLS allocator
+#endif
+#include <mbedtls/sha256.h>
+#include <WebServer.h>
 
 // --- Constants / 常量 ---
-// EN: NeoPixel LED parameters.
-// 中文: NeoPixel 灯珠参数。
+// EN: WS2812 status LED pin.
+// 中文: WS2812 状态灯引脚。
 #define PIXEL_PIN    48
-#define PIXEL_COUNT  1
+
+// EN: Keep-BLE OTA: background task and PSRAM buffer sizing.
+// 中文: 保持 BLE 的 OTA：后台任务与 PSRAM 缓冲尺寸。
+#define OTA_TASK_STACK_SIZE          12288
+#define OTA_TASK_PRIORITY            1
+#define OTA_PSRAM_BUFFER_SIZE        (16 * 1024)
+#define OTA_EXTMEM_THRESHOLD_DOWNLOAD 256
+#define OTA_EXTMEM_THRESHOLD_DEFAULT  4096
 
 // EN: URL for the OTA update JSON file.
 // 中文: 用于 OTA 更新的 JSON 文件 URL。
 const char* OTA_JSON_URL = "https://datav-d-gzcom.oss-cn-hangzhou.aliyuncs.com/esp32/s3/otaup.json";
 
+static void steerTlsToPsram(bool enable);
+
+// EN: Random offset in [0, spreadMs); esp_random() is seeded by the RF noise once Wi-Fi is up.
+// 中文: [0, spreadMs) 内的随机偏移；Wi-Fi 启动后 esp_random() 由射频噪声提供熵。
+static uint32_t randomSpread(uint32_t spreadMs) {
+    return spreadMs ? esp_random() % spreadMs : 0;
+}
+
 // --- LED Helper Functions / LED 辅助函数 ---
 
+// EN: Blink pattern while Wi-Fi or BLE is down, and the red/blue flash shown before each download attempt.
+// 中文: Wi-Fi 或 BLE 未就绪时的闪烁灯效，以及每次下载尝试前的红蓝闪烁。
+static const LedStep kOtaAttemptSteps[] = {
+    {0xFF0000, 100}, {0x0000FF, 100}, {0xFF0000, 100}, {0x0000FF, 100}, {0xFF0000, 100}, {0x0000FF, 100}, {0x000000, 200},
+};
+
+static LedPattern notReadyPattern() {
+    LedPattern p;
+    p.mode = LedMode::Blink;
+    p.color = StatusLed::rgb(0, 0, 255);
+    p.periodMs = 1000;
+    return p;
+}
+
+static LedPattern otaAttemptPattern() {
+    LedPattern p;
+    p.mode = LedMode::Sequence;
+    p.steps = kOtaAttemptSteps;
+    p.stepCount = sizeof(kOtaAttemptSteps) / sizeof(kOtaAttemptSteps[0]);
+    p.repeats = 1;
+    return p;
+}
+
 void OtaUpdater::setLedColor(uint32_t color) {
-    _strip.setPixelColor(0, color);
-    _strip.show();
+    _led.solid(color);
+    _statusLedMode = -1;
+    // EN: Apply immediately on the loop task (setup/blocking paths); the download task leaves it to tick().
+    // 中文: 在 loop 任务（setup/阻塞路径）中立即生效；下载任务则交给 tick() 处理。
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    if (self != _downloadTask && self != _checkTask) _led.tick();
 }
 
 void OtaUpdater::ledOff() {
-    _strip.clear();
-    _strip.show();
+    setLedColor(0);
 }
 
 // --- Public Methods / 公有方法 ---
 
 void OtaUpdater::begin(long long currentVersion) {
     _currentVersion = currentVersion;
-    // EN: Initialize the NeoPixel strip.
-    // 中文: 初始化 NeoPixel 灯条。
-    _strip = Adafruit_NeoPixel(PIXEL_COUNT, PIXEL_PIN, NEO_GRB + NEO_KHZ800);
-    _strip.begin();
+    // EN: Initialize the WS2812 status LED (RMT-driven).
+    // 中文: 初始化 WS2812 状态灯（RMT 驱动）。
+    _led.beginRgb(PIXEL_PIN);
     ledOff();
 }
 
 void OtaUpdater::tick(bool isWifiConnected, bool isBleConnected) {
+    _led.tick();
+
     // --- 1. Handle timed OTA polling / 处理 OTA 定时轮询 ---
     if (_lastCheckMillis == 0) {
         // EN: Initialize timer on first run.
         // 中文: 首次运行时初始化计时器。
         _lastCheckMillis = millis();
+        _checkSpreadMillis = randomSpread(OTA_CHECK_SPREAD_MS);
     }
-    if (millis() - _lastCheckMillis > _checkIntervalMillis) {
-        checkAndUpdate();
-        _lastCheckMillis = millis();
+    // EN: The check itself (TLS handshake + GET) runs in the ota_chk task; loop() only starts it.
+    // 中文: 检查本身（TLS 握手 + GET）在 ota_chk 任务中执行，loop() 只负责启动。
+    if (isWifiConnected && millis() - _lastCheckMillis > _checkIntervalMillis + _checkSpreadMillis &&
+        !_downloading && !_checking) {
+        startBackgroundCheck();
+    }
+
+    // EN: An update found by the background check that needs the blocking (BLE-paused) path.
+    // 中文: 后台检查发现、需要走阻塞（暂停蓝牙）路径的更新。
+    if (_updateQueued && !_checking) {
+        _updateQueued = false;
+        runDownload(_pendingUrl, _pendingMd5, false);
     }
 
     // --- 2. Handle status LED logic / 处理状态灯逻辑 ---
@@ -63,19 +125,15 @@ void OtaUpdater::tick(bool isWifiConnected, bool isBleConnected) {
     // EN: If both Wi-Fi and BLE are connected, the device is fully operational.
     // 中文: 如果 Wi-Fi 和蓝牙都已连接，设备处于完全工作状态。
     if (isWifiConnected && isBleConnected) {
-        ledOff(); // EN: Turn off the LED. / 中文: 关闭 LED。
-    } else {
-        // EN: If either connection is down, blink blue to indicate "not ready".
-        // 中文: 如果任一连接断开，则蓝色闪烁以表示“未就绪”。
-        if (millis() - _lastStatusBlink > 500) { // EN: Non-blocking blink every 500ms. / 中文: 每 500 毫秒进行非阻塞闪烁。
-            _lastStatusBlink = millis();
-            _statusLedState = !_statusLedState;
-            if (_statusLedState) {
-                setLedColor(_strip.Color(0, 0, 255)); // Blue
-            } else {
-                ledOff();
-            }
+        if (_statusLedMode != 0) {
+            ledOff(); // EN: Turn off the LED. / 中文: 关闭 LED。
+            _statusLedMode = 0;
         }
+    } else if (_statusLedMode != 1) {
+        // EN: If either connection is down, blink blue (500ms on / 500ms off) to indicate "not ready".
+        // 中文: 如果任一连接断开，则蓝色闪烁（亮 500ms / 灭 500ms）以表示“未就绪”。
+        _led.play(notReadyPattern());
+        _statusLedMode = 1;
     }
 }
 
@@ -84,16 +142,29 @@ void OtaUpdater::setApModeLed(bool active) {
     // 中文: AP 模式也接管 LED 控制权，暂时将 _isOtaInProgress 设置为 true。
     _isOtaInProgress = active; 
     if (active) {
-        setLedColor(_strip.Color(255, 255, 0)); // EN: Solid Yellow for AP mode. / 中文: AP 模式常亮黄灯。
+        setLedColor(StatusLed::rgb(255, 255, 0)); // EN: Solid Yellow for AP mode. / 中文: AP 模式常亮黄灯。
     } else {
         ledOff();
     }
 }
 
 void OtaUpdater::checkAndUpdate() {
-    _isOtaInProgress = true; // EN: Take control of the LED for the OTA process. / 中文: 为 OTA 流程接管 LED 控制权。
+    // EN: The check leaves the LED alone; it is only taken once an update is actually downloaded.
+    // 中文: 检查过程不再占用状态灯；只有真正开始下载更新时才接管。
     DEBUG_PRINTLN("Checking for OTA update...");
-    setLedColor(_strip.Color(0, 0, 255)); 
+
+    // EN: Validators are only trusted for the firmware that stored them (a LAN push may have changed it).
+    // 中文: 校验头只对写入它的固件版本有效（局域网推送可能已更换固件）。
+    _pref.begin("ota", true);
+    String etag, lastModified;
+    if (_pref.getLong64("ver", -1) == _currentVersion) {
+        etag = _pref.getString("etag", "");
+        lastModified = _pref.getString("lmod", "");
+    }
+    _pref.end();
+
+    bool steered = psramFound();
+    if (steered) steerTlsToPsram(true);
 
     WiFiClientSecure client;
     client.setInsecure();
@@ -101,25 +172,43 @@ void OtaUpdater::checkAndUpdate() {
 
     if (!http.begin(client, OTA_JSON_URL)) {
         DEBUG_PRINTLN("Failed to connect to OTA server.");
-        ledOff();
-        _isOtaInProgress = false; // EN: Release LED control. / 中文: 释放 LED 控制权。
+        if (steered) steerTlsToPsram(false);
         return;
     }
 
+    static const char* kValidatorHeaders[] = {"ETag", "Last-Modified"};
+    http.collectHeaders(kValidatorHeaders, 2);
+    http.setReuse(false);
+    http.setTimeout(10000);
+    if (etag.length()) http.addHeader("If-None-Match", etag);
+    if (lastModified.length()) http.addHeader("If-Modified-Since", lastModified);
+
     int httpCode = http.GET();
+    if (httpCode == HTTP_CODE_NOT_MODIFIED) {
+        // EN: Same manifest as the last up-to-date check: headers only, no body.
+        // 中文: 与上次“已是最新”时的清单相同：仅有响应头，无响应体。
+        LOG_EV(OtaCheck, httpCode, 0);
+        http.end();
+        if (steered) steerTlsToPsram(false);
+        DEBUG_PRINTLN("Firmware is up to date (304).");
+        return;
+    }
     if (httpCode != HTTP_CODE_OK) {
-        DEBUG_PRINTF("Failed to get OTA config, HTTP code: %d\n", httpCode);
+        LOG_EV(OtaCheck, httpCode, 0);
         http.end();
-        ledOff();
-        _isOtaInProgress = false; // EN: Release LED control. / 中文: 释放 LED 控制权。
+        if (steered) steerTlsToPsram(false);
         return;
     }
 
     String payload = http.getString();
+    etag = http.header("ETag");
+    lastModified = http.header("Last-Modified");
     http.end();
+    // EN: Restore the allocator before a download task may steer it again.
+    // 中文: 在下载任务可能再次切换分配器之前先恢复。
+    if (steered) steerTlsToPsram(false);
 
-    DEBUG_PRINT("OTA JSON payload: ");
-    DEBUG_PRINTLN(payload);
+    LOG_EV(OtaCheck, httpCode, (int32_t)payload.length());
 
     // Use static allocation to avoid heap pressure during TLS operations.
     StaticJsonDocument<512> doc;
@@ -128,8 +217,6 @@ void OtaUpdater::checkAndUpdate() {
     if (error) {
         DEBUG_PRINT("JSON deserialization failed: ");
         DEBUG_PRINTLN(error.c_str());
-        ledOff();
-        _isOtaInProgress = false; // EN: Release LED control. / 中文: 释放 LED 控制权。
         return;
     }
 
@@ -140,46 +227,157 @@ void OtaUpdater::checkAndUpdate() {
     DEBUG_PRINTF("Current version: %lld, Server version: %lld\n", _currentVersion, serverVersion);
 
     if (serverVersion > _currentVersion) {
+        // EN: Validators are not cached here, so a failed update is retried with a full GET next time.
+        // 中文: 此处不缓存校验头，更新失败时下次检查仍会完整拉取清单并重试。
         DEBUG_PRINTLN("New firmware version available. Starting update...");
         performUpdate(firmwareUrl, firmwareMd5);
     } else {
         DEBUG_PRINTLN("Firmware is up to date.");
-        ledOff();
-        _isOtaInProgress = false; // EN: Release LED control. / 中文: 释放 LED 控制权。
+        _pref.begin("ota", false);
+        _pref.putLong64("ver", _currentVersion);
+        _pref.putString("etag", etag);
+        _pref.putString("lmod", lastModified);
+        _pref.end();
+    }
+}
+
+// --- PSRAM-first allocator for mbedTLS / mbedTLS 的 PSRAM 优先分配器 ---
+// EN: mbedTLS allocates two ~16KB record buffers per session. Routing them to PSRAM keeps the
+// EN: internal heap free for NimBLE, which is what lets BLE stay up during the download.
+// 中文: mbedTLS 每个会话会分配两块约 16KB 的记录缓冲。将其放到 PSRAM 可以为 NimBLE 留出内部堆，
+// 中文: 这样下载期间蓝牙就无需关闭。
+#if defined(MBEDTLS_PLATFORM_MEMORY) && !defined(MBEDTLS_PLATFORM_CALLOC_MACRO)
+#define OTA_CAN_STEER_TLS_ALLOC 1
+static void* otaPsramCalloc(size_t n, size_t size) {
+    void* p = heap_caps_calloc(n, size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!p) p = heap_caps_calloc(n, size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    return p;
+}
+static void otaTlsFree(void* p) {
+    heap_caps_free(p); // EN: Works for both heaps. / 中文: 两种堆均适用。
+}
+#else
+#define OTA_CAN_STEER_TLS_ALLOC 0
+#endif
+
+static void steerTlsToPsram(bool enable) {
+#if OTA_CAN_STEER_TLS_ALLOC
+    // EN: Disabling reinstalls mbedTLS's configured pair (MBEDTLS_PLATFORM_STD_*: esp_mbedtls_mem_calloc/free under
+    // EN: the IDF's CONFIG_MBEDTLS_*_MEM_ALLOC policy), so TLS sessions after the check are unaffected.
+    // 中文: 关闭时恢复 mbedTLS 配置的分配器（MBEDTLS_PLATFORM_STD_*：按 IDF 的 CONFIG_MBEDTLS_*_MEM_ALLOC 策略为
+    // 中文: esp_mbedtls_mem_calloc/free），检查结束后的其他 TLS 会话不受影响。
+    if (enable) mbedtls_platform_set_calloc_free(otaPsramCalloc, otaTlsFree);
+    else mbedtls_platform_set_calloc_free(MBEDTLS_PLATFORM_STD_CALLOC, MBEDTLS_PLATFORM_STD_FREE);
+#else
+    // EN: mbedTLS uses the default malloc here; lower the PSRAM threshold instead.
+    // 中文: 该配置下 mbedTLS 走默认 malloc，改为降低 PSRAM 分配阈值。
+    heap_caps_malloc_extmem_enable(enable ? OTA_EXTMEM_THRESHOLD_DOWNLOAD : OTA_EXTMEM_THRESHOLD_DEFAULT);
+#endif
+}
+
+void OtaUpdater::downloadTaskEntry(void* arg) {
+    OtaUpdater* self = static_cast<OtaUpdater*>(arg);
+    self->runDownload(self->_pendingUrl, self->_pendingMd5, true);
+    self->_downloadTask = nullptr;
+    vTaskDelete(nullptr);
+}
+
+void OtaUpdater::checkTaskEntry(void* arg) {
+    OtaUpdater* self = static_cast<OtaUpdater*>(arg);
+    if (self->_checkDelayMs) vTaskDelay(pdMS_TO_TICKS(self->_checkDelayMs));
+    self->checkAndUpdate();
+    BootTimeline::mark(BootStage::OtaCheckDone);
+    self->_checking = false;
+    self->_checkTask = nullptr;
+    vTaskDelete(nullptr);
+}
+
+void OtaUpdater::startBackgroundCheck(uint32_t spreadMs) {
+    if (_checking || _downloading) return;
+    _checking = true;
+    _lastCheckMillis = millis();
+    _checkSpreadMillis = randomSpread(OTA_CHECK_SPREAD_MS);
+    _checkDelayMs = randomSpread(spreadMs);
+    BaseType_t ok = xTaskCreatePinnedToCore(&OtaUpdater::checkTaskEntry, "ota_chk",
+                                            OTA_TASK_STACK_SIZE, this, OTA_TASK_PRIORITY,
+                                            &_checkTask, 0);
+    if (ok != pdPASS) {
+        // EN: No task: fall back to the synchronous check.
+        // 中文: 无法创建任务时退回同步检查。
+        _checkTask = nullptr;
+        _checking = false;
+        checkAndUpdate();
+        BootTimeline::mark(BootStage::OtaCheckDone);
     }
 }
 
 void OtaUpdater::performUpdate(const String& url, const String& md5) {
+    _isOtaInProgress = true; // EN: Take control of the LED for the download. / 中文: 为下载接管 LED 控制权。
+    bool inCheckTask = _checkTask != nullptr && xTaskGetCurrentTaskHandle() == _checkTask;
+#if OTA_KEEP_BLE_ALIVE
+    if (psramFound()) {
+        // EN: Keep BLE alive: download on core 0 at low priority so loop() (gestures) and NimBLE keep running.
+        // 中文: 保持蓝牙在线：在 core 0 上以低优先级下载，loop()（手势）与 NimBLE 继续运行。
+        _pendingUrl = url;
+        _pendingMd5 = md5;
+        _downloading = true;
+        BaseType_t ok = xTaskCreatePinnedToCore(&OtaUpdater::downloadTaskEntry, "ota_dl",
+                                                OTA_TASK_STACK_SIZE, this, OTA_TASK_PRIORITY,
+                                                &_downloadTask, 0);
+        if (ok == pdPASS) {
+            DEBUG_PRINTLN("[OTA] Keep-BLE mode: download running in background task.");
+            return;
+        }
+        _downloadTask = nullptr;
+        _downloading = false;
+        DEBUG_PRINTLN("[OTA] Failed to start download task, falling back to blocking mode.");
+    }
+#endif
+    if (inCheckTask) {
+        // EN: Pausing BLE from a side task would race loop(); let tick() run the blocking download.
+        // 中文: 在旁路任务中暂停蓝牙会与 loop() 竞争；交给 tick() 执行阻塞下载。
+        _pendingUrl = url;
+        _pendingMd5 = md5;
+        _updateQueued = true;
+        return;
+    }
+    runDownload(url, md5, false);
+}
+
+void OtaUpdater::runDownload(const String& url, const String& md5, bool keepBle) {
+    _downloading = true;
     bool blePaused = false;
-    if (_ble) {
+    if (_ble && !keepBle) {
         _ble->pause();
         blePaused = true;
     }
 
     bool success = false;
-    // Keep the buffer small to reduce RAM usage while downloading over TLS.
-    const size_t bufferSize = 1024;
-    uint8_t* buffer = (uint8_t*)malloc(bufferSize);
+    // EN: Keep-BLE mode uses a large PSRAM buffer; otherwise keep it small to reduce internal RAM usage over TLS.
+    // 中文: 保持 BLE 模式使用较大的 PSRAM 缓冲；否则保持小缓冲以降低 TLS 期间内部 RAM 占用。
+    const size_t bufferSize = keepBle ? OTA_PSRAM_BUFFER_SIZE : 1024;
+    uint8_t* buffer = keepBle ? (uint8_t*)heap_caps_malloc(bufferSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)
+                              : (uint8_t*)malloc(bufferSize);
+    size_t lowWater = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
 
     if (!buffer) {
         DEBUG_PRINTLN("Failed to allocate buffer for OTA download!");
-        setLedColor(_strip.Color(255, 0, 0));
+        setLedColor(StatusLed::rgb(255, 0, 0));
         if (blePaused && _ble) _ble->resume();
+        _downloading = false;
         _isOtaInProgress = false; // EN: Release LED control (fatal error). / 中文: 释放 LED 控制权（致命错误）。
         return;
     }
 
+    if (keepBle) steerTlsToPsram(true);
+
     for (int i = 0; i < _maxRetries; i++) {
         DEBUG_PRINTF("Downloading firmware... Attempt %d/%d\n", i + 1, _maxRetries);
 
-        for (int j = 0; j < 3; j++) {
-            setLedColor(_strip.Color(255, 0, 0));
-            delay(100);
-            setLedColor(_strip.Color(0, 0, 255));
-            delay(100);
-        }
-        ledOff();
-        delay(200);
+        // EN: Red/blue attempt flash runs on the LED engine; no blocking delays.
+        // 中文: 红蓝闪烁交给灯效引擎播放，不再阻塞延时。
+        _led.play(otaAttemptPattern());
+        _statusLedMode = -1;
 
         HTTPClient http;
         WiFiClientSecure fwClient;
@@ -204,7 +402,7 @@ void OtaUpdater::performUpdate(const String& url, const String& md5) {
         }
 
         // 下载阶段：用青色指示“正在下载”
-        setLedColor(_strip.Color(0, 150, 255));
+        setLedColor(StatusLed::rgb(0, 150, 255));
         DEBUG_PRINTLN("HTTP connected, start downloading...");
 
         int contentLength = http.getSize();
@@ -217,14 +415,14 @@ void OtaUpdater::performUpdate(const String& url, const String& md5) {
 
         DEBUG_PRINTLN("Update process started. Flashing firmware...");
         // 刷写阶段：用绿色指示“正在刷写”
-        setLedColor(_strip.Color(0, 255, 0));
+        setLedColor(StatusLed::rgb(0, 255, 0));
 
         if (!Update.begin(contentLength)) {
             DEBUG_PRINT("Not enough space to begin OTA: ");
             DEBUG_PRINTLN(Update.errorString());
             http.end();
             Update.abort();
-            goto end_update_free_buffer; 
+            break;
         }
 
         Update.setMD5(md5.c_str());
@@ -245,13 +443,18 @@ void OtaUpdater::performUpdate(const String& url, const String& md5) {
                     lastDataMs = millis(); // reset timeout on progress
                     if (contentLength > 0 && written >= nextLog) {
                         int percent = (written * 100) / contentLength;
-                        DEBUG_PRINTF("Flashing... %d%% (%u/%d)\n", percent, (unsigned)written, contentLength);
+                        LOG_EV(OtaProgress, percent, (int32_t)written);
                         nextLog += contentLength / 10;
                     }
                 }
             } else {
                 delay(1);
             }
+            if (!keepBle) _led.tick(); // EN: loop() is blocked in this mode. / 中文: 此模式下 loop() 被阻塞。
+            // EN: Track the internal heap low-water mark while TLS is active.
+            // 中文: TLS 活动期间跟踪内部堆低水位。
+            size_t freeInternal = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+            if (freeInternal < lowWater) lowWater = freeInternal;
             // abort if no data arrives for too long to avoid hanging
             if (millis() - lastDataMs > 15000) {
                 DEBUG_PRINTLN("Download stalled (no data for 15s), aborting.");
@@ -269,6 +472,8 @@ void OtaUpdater::performUpdate(const String& url, const String& md5) {
 
         if (Update.isFinished()) {
             DEBUG_PRINTLN("Update successful! Rebooting...");
+            // 记录在软重启后仍保留于事件环 / The record survives the soft reboot in the event ring
+            LOG_EV(OtaResult, 1, (int32_t)lowWater);
             success = true;
             http.end(); 
             free(buffer); 
@@ -281,13 +486,152 @@ void OtaUpdater::performUpdate(const String& url, const String& md5) {
         }
     }
 
-end_update_free_buffer:
     free(buffer); 
+    if (keepBle) steerTlsToPsram(false);
+
+    _internalLowWater = lowWater;
+    DEBUG_PRINTF("[OTA] Internal heap low-water during download: %u bytes (min ever %u)\n",
+                 (unsigned)lowWater, (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL));
 
     if (!success) {
         DEBUG_PRINTLN("Failed to update firmware after all retries.");
-        setLedColor(_strip.Color(255, 0, 0));
+        LOG_EV(OtaResult, 0, (int32_t)lowWater);
+        setLedColor(StatusLed::rgb(255, 0, 0));
         if (blePaused && _ble) _ble->resume();
     }
+    _downloading = false;
     _isOtaInProgress = false; // EN: Release LED control. / 中文: 释放 LED 控制权。
 }
+
+// --- LAN push OTA / 局域网推送 OTA ---
+// EN: SHA-256 state for the upload in flight (only one upload at a time).
+// 中文: 进行中的推送所用的 SHA-256 状态（同一时间仅允许一个推送）。
+static mbedtls_sha256_context s_lanSha;
+static bool s_lanActive = false;
+
+void OtaUpdater::attachLanUpload(WebServer* srv) {
+    _server = srv;
+    if (!_server) return;
+    // EN: Non-multipart bodies are delivered to the second callback chunk by chunk (HTTPRaw).
+    // 中文: 非 multipart 请求体会通过第二个回调按块传入（HTTPRaw）。
+    _server->on("/ota", HTTP_POST, [this]() { handleLanUploadDone(); }, [this]() { handleLanUploadChunk(); });
+}
+
+void OtaUpdater::handleLanUploadChunk() {
+    HTTPRaw& raw = _server->raw();
+
+    if (raw.status == RAW_START) {
+        _lanOk = false;
+        _lanError = "";
+        _lanWritten = 0;
+        _lanStartMs = millis();
+        s_lanActive = false;
+
+        String token = LAN_OTA_TOKEN;
+        if (token.length() > 0 && _server->arg("token") != token) {
+            _lanError = "unauthorized";
+            return;
+        }
+        if (_downloading) {
+            _lanError = "update already in progress";
+            return;
+        }
+        String md5 = _server->arg("md5");
+        _lanSha256 = _server->arg("sha256");
+        _lanSha256.toLowerCase();
+        if (md5.length() != 32 && _lanSha256.length() != 64) {
+            _lanError = "md5 or sha256 required";
+            return;
+        }
+
+        size_t size = _server->hasArg("size") ? (size_t)_server->arg("size").toInt() : UPDATE_SIZE_UNKNOWN;
+        if (!Update.begin(size)) {
+            _lanError = String("begin failed: ") + Update.errorString();
+            return;
+        }
+        if (md5.length() == 32) Update.setMD5(md5.c_str());
+        mbedtls_sha256_init(&s_lanSha);
+        mbedtls_sha256_starts(&s_lanSha, 0);
+
+        _isOtaInProgress = true;
+        _downloading = true;
+        s_lanActive = true;
+        setLedColor(StatusLed::rgb(0, 255, 0)); // EN: Green = flashing. / 中文: 绿色 = 刷写中。
+        DEBUG_PRINTF("[OTA] LAN upload started, size=%d\n", (int)size);
+        return;
+    }
+
+    if (!s_lanActive) return;
+
+    if (raw.status == RAW_WRITE) {
+        if (Update.write(raw.buf, raw.currentSize) != raw.currentSize) {
+            _lanError = String("write failed: ") + Update.errorString();
+            Update.abort();
+            mbedtls_sha256_free(&s_lanSha);
+            s_lanActive = false;
+            return;
+        }
+        mbedtls_sha256_update(&s_lanSha, raw.buf, raw.currentSize);
+        _lanWritten += raw.currentSize;
+    } else if (raw.status == RAW_END) {
+        uint8_t digest[32];
+        mbedtls_sha256_finish(&s_lanSha, digest);
+        mbedtls_sha256_free(&s_lanSha);
+        s_lanActive = false;
+
+        if (_lanSha256.length() == 64) {
+            char hex[65];
+            for (int i = 0; i < 32; i++) sprintf(hex + i * 2, "%02x", digest[i]);
+            if (_lanSha256 != hex) {
+                _lanError = "sha256 mismatch";
+                Update.abort();
+                return;
+            }
+        }
+        // EN: end(true) accepts an unknown size and verifies MD5 when set.
+        // 中文: end(true) 允许未知长度，并在设置了 MD5 时进行校验。
+        if (!Update.end(true)) {
+            _lanError = String("end failed: ") + Update.errorString();
+            return;
+        }
+        _lanOk = true;
+    } else if (raw.status == RAW_ABORTED) {
+        DEBUG_PRINTLN("[OTA] LAN upload aborted by client.");
+        _lanError = "aborted";
+        Update.abort();
+        mbedtls_sha256_free(&s_lanSha);
+        s_lanActive = false;
+    }
+}
+
+void OtaUpdater::handleLanUploadDone() {
+    unsigned long elapsed = millis() - _lanStartMs;
+    if (s_lanActive) {
+        // EN: Body ended without RAW_END (e.g. empty body); discard the partial image.
+        // 中文: 请求体未走到 RAW_END（如空请求体），丢弃不完整镜像。
+        Update.abort();
+        mbedtls_sha256_free(&s_lanSha);
+        s_lanActive = false;
+        if (_lanError.length() == 0) _lanError = "incomplete body";
+    }
+
+    if (!_lanOk) {
+        if (_lanError.length() == 0) _lanError = "no body";
+        DEBUG_PRINTF("[OTA] LAN upload failed: %s\n", _lanError.c_str());
+        int code = _lanError == "unauthorized" ? 401 : (_lanError == "update already in progress" ? 409 : 400);
+        _server->send(code, "application/json", "{\"error\":\"" + _lanError + "\"}");
+        if (_downloading && !_downloadTask) {
+            _downloading = false;
+            setLedColor(StatusLed::rgb(255, 0, 0));
+            _isOtaInProgress = false;
+        }
+        return;
+    }
+
+    DEBUG_PRINTF("[OTA] LAN upload ok: %u bytes in %lu ms. Rebooting...\n", (unsigned)_lanWritten, elapsed);
+    _server->send(200, "application/json",
+                  "{\"status\":\"ok\",\"bytes\":" + String((unsigned)_lanWritten) +
+                  ",\"ms\":" + String(elapsed) + "}");
+    delay(300); // EN: Let the reply flush before rebooting. / 中文: 重启前让回复发送完成。
+    ESP.restart();
+}
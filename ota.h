@@ -2,9 +2,11 @@
 #define OTA_H
 
 #include <Arduino.h>
-#include <Adafruit_NeoPixel.h>
+#include <Preferences.h>
+#include "StatusLed.h"
 
 class BleDriver;
+class WebServer;
 
 /**
  * @class OtaUpdater
@@ -24,9 +26,21 @@ public:
     /**
      * @brief Checks for a new firmware version and performs the update if available.
      * @brief 检查新固件版本，并在可用时执行更新。
+     * @note Sends If-None-Match/If-Modified-Since from the last up-to-date manifest; a 304 ends the check.
+     * @note 携带上次“已是最新”清单的 If-None-Match/If-Modified-Since；返回 304 即结束检查。
      */
     void checkAndUpdate();
 
+    /**
+     * @brief Runs checkAndUpdate() in a background task so boot does not wait on the TLS handshake.
+     * @brief 在后台任务中运行 checkAndUpdate()，启动流程无需等待 TLS 握手。
+     * @note Without keep-BLE support the download itself is handed back to tick() on the loop task.
+     * @note 不支持保持蓝牙时，下载本身交回 loop 任务中的 tick() 执行。
+     * @param spreadMs The task first sleeps a random 0..spreadMs ms (fleet spread); 0 checks right away.
+     * @param spreadMs 任务先随机休眠 0..spreadMs 毫秒（设备群错峰）；0 表示立即检查。
+     */
+    void startBackgroundCheck(uint32_t spreadMs = 0);
+
     /**
      * @brief Periodic task handler, called in the main loop. Manages timed update checks and status LED.
      * @brief 周期性任务处理器，在主循环中调用。管理定时更新检查和状态 LED。
@@ -45,21 +59,43 @@ public:
      */
     void setApModeLed(bool active);
 
+    /**
+     * @brief Registers POST /ota, which streams the raw request body straight into Update.
+     * @brief 注册 POST /ota，将原始请求体直接流式写入 Update。
+     * @param srv The HTTP server to attach to.
+     * @param srv 要挂载的 HTTP 服务器。
+     */
+    void attachLanUpload(WebServer* srv);
+
+    /**
+     * @brief Returns true while a firmware download/flash is running (foreground or background task).
+     * @brief 固件下载/刷写进行中（前台或后台任务）时返回 true。
+     */
+    bool isUpdating() const { return _downloading; }
+
+    /**
+     * @brief Lowest free internal heap (bytes) sampled during the last firmware download; 0 if none yet.
+     * @brief 上一次固件下载期间采样到的内部堆最低剩余（字节）；尚未下载时为 0。
+     */
+    size_t getLastOtaInternalLowWater() const { return _internalLowWater; }
+
 private:
     // --- Version & Timing / 版本与计时 ---
     long long _currentVersion; // EN: Current firmware version. / 中文: 当前固件版本。
     unsigned long _lastCheckMillis = 0; // EN: Timestamp of the last update check. / 中文: 上次更新检查的时间戳。
     const long _checkIntervalMillis = 12 * 60 * 60 * 1000; // EN: 12 hours between checks. / 中文: 12 小时检查间隔。
+    unsigned long _checkSpreadMillis = 0; // EN: Random offset added to the current interval. / 中文: 本次间隔附加的随机偏移。
+    uint32_t _checkDelayMs = 0; // EN: Sleep before the background check starts. / 中文: 后台检查开始前的休眠。
+    Preferences _pref; // EN: Cached manifest validators (namespace "ota"). / 中文: 缓存的清单校验头（命名空间 "ota"）。
 
     // --- Hardware & Config / 硬件与配置 ---
     const int _ledPin = 48; // EN: GPIO pin for the WS2818 LED. / 中文: WS2818 LED 连接的 GPIO 引脚。
     const int _maxRetries = 3; // EN: Max retries for firmware download. / 中文: 固件下载的最大重试次数。
-    Adafruit_NeoPixel _strip; // EN: NeoPixel library instance. / 中文: NeoPixel 库实例。
+    StatusLed _led; // EN: Non-blocking RMT-driven LED pattern engine. / 中文: 非阻塞、RMT 驱动的灯效引擎。
     
     // --- State Management / 状态管理 ---
     bool _isOtaInProgress = false; // EN: Flag to indicate if an OTA update is active, to prioritize LED control. / 中文: 标记 OTA 更新是否正在进行，以优先控制 LED。
-    unsigned long _lastStatusBlink = 0; // EN: Timestamp for non-blocking status LED blinking. / 中文: 用于状态灯非阻塞闪烁的时间戳。
-    bool _statusLedState = false; // EN: Current state of the status LED (on/off). / 中文: 当前状态灯的状态（亮/灭）。
+    int8_t _statusLedMode = -1; // EN: Status pattern currently shown by tick(): -1 unknown, 0 off, 1 blinking. / 中文: tick() 当前显示的状态灯效：-1 未知，0 熄灭，1 闪烁。
 
     /**
      * @brief Sets the color of the WS2818 LED.
@@ -85,6 +121,51 @@ private:
      */
     void performUpdate(const String& url, const String& md5);
 
+    /**
+     * @brief Download + flash loop shared by the blocking path and the background task.
+     * @brief 阻塞路径与后台任务共用的下载 + 刷写流程。
+     * @param keepBle True to keep NimBLE running and place buffers in PSRAM; false to pause BLE first.
+     * @param keepBle 为 true 时保持 NimBLE 运行并将缓冲放入 PSRAM；为 false 时先暂停 BLE。
+     */
+    void runDownload(const String& url, const String& md5, bool keepBle);
+
+    /**
+     * @brief FreeRTOS entry for the background download used in keep-BLE mode.
+     * @brief 保持 BLE 模式下后台下载任务的 FreeRTOS 入口。
+     */
+    static void downloadTaskEntry(void* arg);
+
+    /**
+     * @brief Raw body callback for POST /ota: called per received chunk.
+     * @brief POST /ota 的原始请求体回调：每收到一块数据调用一次。
+     */
+    void handleLanUploadChunk();
+
+    /**
+     * @brief Final handler for POST /ota: replies and reboots on success.
+     * @brief POST /ota 的收尾处理：回复结果，成功则重启。
+     */
+    void handleLanUploadDone();
+
+    // --- LAN upload / 局域网推送 ---
+    WebServer* _server = nullptr; // EN: Server that owns the /ota route. / 中文: 挂载 /ota 路由的服务器。
+    bool _lanOk = false;          // EN: Result of the last LAN upload. / 中文: 上次局域网推送的结果。
+    String _lanError;             // EN: Error text of the last LAN upload. / 中文: 上次局域网推送的错误信息。
+    String _lanSha256;            // EN: Expected SHA-256 (hex) if supplied. / 中文: 期望的 SHA-256（十六进制），如提供。
+    size_t _lanWritten = 0;       // EN: Bytes written to flash so far. / 中文: 已写入闪存的字节数。
+    unsigned long _lanStartMs = 0; // EN: Upload start time. / 中文: 推送开始时间。
+
+    // --- Background download / 后台下载 ---
+    TaskHandle_t _downloadTask = nullptr; // EN: Running download task, if any. / 中文: 正在运行的下载任务。
+    volatile bool _downloading = false;   // EN: True while runDownload() is active. / 中文: runDownload() 执行期间为 true。
+    TaskHandle_t _checkTask = nullptr;    // EN: Running background manifest check, if any. / 中文: 正在运行的后台清单检查任务。
+    volatile bool _checking = false;      // EN: True while the background check runs. / 中文: 后台检查期间为 true。
+    volatile bool _updateQueued = false;  // EN: Update found by the background check, to run on the loop task. / 中文: 后台检查发现的更新，待 loop 任务执行。
+    static void checkTaskEntry(void* arg);
+    String _pendingUrl;  // EN: URL handed to the download task. / 中文: 交给下载任务的 URL。
+    String _pendingMd5;  // EN: MD5 handed to the download task. / 中文: 交给下载任务的 MD5。
+    size_t _internalLowWater = 0; // EN: Internal heap low-water mark of the last download. / 中文: 上次下载的内部堆低水位。
+
 public:
     void setBleDriver(BleDriver* ble) { _ble = ble; }
 
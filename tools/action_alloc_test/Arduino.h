@@ -0,0 +1,28 @@
+// Host stand-in for the few Arduino core helpers ActionParser.cpp uses (min/max/constrain/strlcpy).
+// 主机端替身：仅提供 ActionParser.cpp 用到的 Arduino 核心函数（min/max/constrain/strlcpy）。
+#ifndef ACTION_ALLOC_TEST_ARDUINO_H
+#define ACTION_ALLOC_TEST_ARDUINO_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+using std::max;
+using std::min;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// EN: glibc only has strlcpy from 2.38 on. / 中文: glibc 自 2.38 起才提供 strlcpy。
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+inline size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+#endif
@@ -0,0 +1,219 @@
+// action_alloc_test: host check that parsing an /action body makes zero heap allocations.
+// action_alloc_test：主机端检查 /action 请求体解析过程零堆分配。
+//
+// Build / 编译 (glibc; ArduinoJson 7.0-7.2, header-only / 仅需头文件):
+//   g++ -O2 -std=c++17 -DARDUINOJSON_SLOT_ID_SIZE=2 -DARDUINOJSON_POOL_CAPACITY=128 -I. -I<ArduinoJson>/src
+//       action_alloc_test.cpp ../../ActionParser.cpp -o action_alloc_test
+//
+// Usage / 用法:
+//   ./action_alloc_test        # exit code 0 = pass / 退出码 0 表示通过
+//
+// EN: Runs the firmware's hot path (deserializeJson into ArenaAllocator<4096>, then parseAction) over one body
+// EN: per action type, a 256-byte `text`, 16 waypoints in both point forms, an over-long `text`, too many
+// EN: waypoints and a body filling the 2 KB receive buffer. malloc/calloc/realloc/free (and so operator new)
+// EN: are wrapped and counted while each body is parsed; any call fails the test. The local Arduino.h stands
+// EN: in for the few core helpers ActionParser.cpp uses.
+// EN: The two -D flags give both translation units the ESP32's pool layout (2-byte slot ids, 128-slot pools).
+// EN: Without them a 64-bit host picks 4-byte ids and 256-slot pools, and the first 4 KB pool alone no longer
+// EN: fits the arena once a key string is in it, so every case would fail. Slot size itself still follows the
+// EN: host's pointer width, so the printed arena figures are host numbers, not the device's.
+// 中文: 按固件热路径（deserializeJson 到 ArenaAllocator<4096>，再 parseAction）解析：每种动作各一个请求体、
+// 中文: 256 字节 `text`、两种写法的 16 个途经点、超长 `text`、超额途经点，以及填满 2KB 接收缓冲的请求体。
+// 中文: 解析期间包装并统计 malloc/calloc/realloc/free（operator new 也经由它们），出现任何一次即失败。
+// 中文: 同目录的 Arduino.h 仅替代 ActionParser.cpp 用到的少量核心函数。
+// 中文: 两个 -D 参数让两个编译单元都使用 ESP32 的池布局（2 字节槽 ID、每池 128 槽）。不加时 64 位主机为 4 字节 ID、
+// 中文: 每池 256 槽，第一个 4KB 的池在放入键字符串后就装不进 arena，所有用例都会失败。槽大小仍随主机指针宽度，
+// 中文: 因此输出的 arena 数值是主机上的，不代表设备端。
+
+#include <ArduinoJson.h>
+
+#if ARDUINOJSON_SLOT_ID_SIZE != 2 || ARDUINOJSON_POOL_CAPACITY != 128
+#error "Build with -DARDUINOJSON_SLOT_ID_SIZE=2 -DARDUINOJSON_POOL_CAPACITY=128 (the ESP32 layout), see the build line above"
+#endif
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../../ActionParser.h"
+#include "../../ArenaAllocator.h"
+
+// --- Heap hook / 堆分配钩子 ---
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void __libc_free(void* ptr);
+}
+
+static bool gCounting = false;
+static unsigned gHeapCalls = 0;
+
+extern "C" void* malloc(size_t size) {
+    if (gCounting) gHeapCalls++;
+    return __libc_malloc(size);
+}
+extern "C" void* calloc(size_t n, size_t size) {
+    if (gCounting) gHeapCalls++;
+    return __libc_calloc(n, size);
+}
+extern "C" void* realloc(void* ptr, size_t size) {
+    if (gCounting) gHeapCalls++;
+    return __libc_realloc(ptr, size);
+}
+extern "C" void free(void* ptr) {
+    if (gCounting && ptr) gHeapCalls++;
+    __libc_free(ptr);
+}
+
+namespace {
+
+// 与固件 ACTION_BODY_MAX 一致；更大的请求体在解析前就以 413 拒绝 / Matches the sketch's ACTION_BODY_MAX; larger bodies get 413 before parsing
+const size_t kBodyMax = 2048;
+
+char gBody[kBodyMax];
+ArenaAllocator<4096> gArena;
+
+enum class Expect { Parsed, ParsedOrNoMemory };
+
+struct Case {
+    std::string name;
+    std::string body;
+    Expect expect = Expect::Parsed;
+    ActionType type = ActionType::Unknown;
+    bool textTooLong = false;
+    int waypoints = -1;  // -1 = 不检查 / don't check
+    bool tooManyWaypoints = false;
+};
+
+std::string repeat(const std::string& s, size_t n) {
+    std::string out;
+    for (size_t i = 0; i < n; i++) out += s;
+    return out;
+}
+
+std::string arrayPoints(int n) {
+    std::string out = "[";
+    for (int i = 0; i < n; i++) out += (i ? ",[" : "[") + std::to_string(100 + i * 40) + "," + std::to_string(2000 - i * 90) + "]";
+    return out + "]";
+}
+
+std::string objectPoints(int n) {
+    std::string out = "[";
+    for (int i = 0; i < n; i++)
+        out += (i ? ",{\"x\":" : "{\"x\":") + std::to_string(100 + i * 40) + ",\"y\":" + std::to_string(2000 - i * 90) + "}";
+    return out + "]";
+}
+
+// 所有动作共用的可选参数 / Options every action accepts
+const std::string kOpts =
+    "\"screen_w\":1080,\"screen_h\":2400,\"rotation\":90,\"delay_hover\":25,\"delay_press\":30,"
+    "\"delay_interval\":8,\"delay_release\":20,\"multi_interval\":40,\"double_check\":20,\"curve_strength\":30";
+
+std::vector<Case> buildCases() {
+    std::vector<Case> c;
+    auto add = [&](const char* name, const std::string& body, ActionType type) {
+        Case k;
+        k.name = name;
+        k.body = body;
+        k.type = type;
+        c.push_back(k);
+        return &c.back();
+    };
+
+    add("click", "{\"type\":\"click\",\"x\":540,\"y\":1200,\"count\":2," + kOpts + "}", ActionType::Click);
+    add("swipe", "{\"type\":\"swipe\",\"x1\":540,\"y1\":1800,\"x2\":540,\"y2\":600,\"duration\":300," + kOpts + "}",
+        ActionType::Swipe);
+    add("type_text_max",
+        "{\"type\":\"type_text\",\"text\":\"" + repeat("a", ACTION_TEXT_MAX) +
+            "\",\"batch\":4,\"key_interval\":20,\"key_hold\":8,\"key_jitter\":20}",
+        ActionType::TypeText);
+    add("key_name", "{\"type\":\"key\",\"key\":\"volume_up\",\"hold_ms\":40}", ActionType::Key);
+    add("key_code", "{\"type\":\"key\",\"keycode\":40,\"modifiers\":2}", ActionType::Key);
+    add("trace", "{\"type\":\"trace\",\"name\":\"swipe_up_3\",\"x1\":540,\"y1\":1800,\"x2\":540,\"y2\":600,\"duration\":0}",
+        ActionType::Trace);
+    add("long_press", "{\"type\":\"long_press\",\"x\":540,\"y\":1200,\"hold_ms\":800," + kOpts + "}",
+        ActionType::LongPress);
+    add("path_16_arrays", "{\"type\":\"path\",\"points\":" + arrayPoints(GESTURE_MAX_WAYPOINTS) +
+                              ",\"spline\":true,\"duration\":600," + kOpts + "}",
+        ActionType::Path)->waypoints = GESTURE_MAX_WAYPOINTS;
+    add("drag_16_objects", "{\"type\":\"drag\",\"points\":" + objectPoints(GESTURE_MAX_WAYPOINTS) +
+                               ",\"hold_ms\":500,\"drop_hold_ms\":300,\"duration\":800}",
+        ActionType::Drag)->waypoints = GESTURE_MAX_WAYPOINTS;
+    add("fling", "{\"type\":\"fling\",\"x1\":540,\"y1\":1800,\"x2\":540,\"y2\":400,\"duration\":120}", ActionType::Fling);
+    add("click_at_buffered", "{\"type\":\"click\",\"x\":10,\"y\":10,\"at\":1760000000123,\"buffer\":true,\"ttl_ms\":5000}",
+        ActionType::Click);
+
+    add("type_text_too_long", "{\"type\":\"type_text\",\"text\":\"" + repeat("b", ACTION_TEXT_MAX + 44) + "\"}",
+        ActionType::TypeText)->textTooLong = true;
+    Case* many = add("path_17", "{\"type\":\"path\",\"points\":" + arrayPoints(GESTURE_MAX_WAYPOINTS + 1) + "}",
+                     ActionType::Path);
+    many->waypoints = GESTURE_MAX_WAYPOINTS;
+    many->tooManyWaypoints = true;
+
+    // EN: As large as the receive buffer allows; the arena may run out, which must surface as NoMemory.
+    // 中文: 接收缓冲允许的最大请求体；arena 可能耗尽，此时必须返回 NoMemory。
+    std::string big = "{\"type\":\"path\",\"points\":[";
+    for (int i = 0; big.size() + 16 < kBodyMax; i++) big += (i ? ",[" : "[") + std::to_string(i % 1000) + ",1]";
+    big += "]}";
+    Case* full = add("full_2k_body", big, ActionType::Path);
+    full->expect = Expect::ParsedOrNoMemory;
+    full->tooManyWaypoints = true;
+    return c;
+}
+
+}  // namespace
+
+int main() {
+    std::vector<Case> cases = buildCases();
+    int failures = 0;
+    printf("%-20s %6s %6s %6s  %s\n", "case", "bytes", "heap", "arena", "result");
+
+    for (const Case& k : cases) {
+        if (k.body.size() > kBodyMax) {
+            printf("%-20s body is %zu bytes, over %zu\n", k.name.c_str(), k.body.size(), kBodyMax);
+            failures++;
+            continue;
+        }
+        memcpy(gBody, k.body.data(), k.body.size());
+        size_t len = k.body.size();
+
+        // EN: Same sequence as handleAction(); nothing between the two flags may touch the heap.
+        // 中文: 与 handleAction() 相同的步骤；两次标记之间不得触及堆。
+        ParsedAction act;
+        DeserializationError error;
+        bool parsed = false;
+        gHeapCalls = 0;
+        gCounting = true;
+        {
+            gArena.reset();
+            JsonDocument doc(&gArena);
+            error = deserializeJson(doc, (const char*)gBody, len);
+            parsed = !error && parseAction(doc.as<JsonObjectConst>(), act);
+        }
+        gCounting = false;
+        unsigned heap = gHeapCalls;
+
+        std::string why;
+        if (heap != 0) why += " heap_calls=" + std::to_string(heap);
+        if (parsed) {
+            if (act.type != k.type) why += " wrong_type";
+            if (act.textTooLong != k.textTooLong) why += " text_too_long_mismatch";
+            if (k.waypoints >= 0 && act.waypoints != k.waypoints) why += " waypoints=" + std::to_string(act.waypoints);
+            if (act.tooManyWaypoints != k.tooManyWaypoints) why += " too_many_waypoints_mismatch";
+            if (k.expect == Expect::Parsed && gArena.failed()) why += " arena_failed";
+        } else if (!(k.expect == Expect::ParsedOrNoMemory && error == DeserializationError::NoMemory)) {
+            why += std::string(" parse_error=") + error.c_str();
+        }
+
+        printf("%-20s %6zu %6u %6zu  %s%s\n", k.name.c_str(), len, heap, gArena.used(),
+               why.empty() ? "ok" : "FAIL", why.empty() && !parsed ? " (NoMemory)" : why.c_str());
+        if (!why.empty()) failures++;
+    }
+
+    printf("arena peak %zu / %zu bytes, %d failure(s)\n", gArena.peak(), gArena.capacity(), failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,664 @@
+// loadgen: open-loop load generator / soak tester for the device HTTP and UDP discovery APIs.
+// loadgen：设备 HTTP 与 UDP 发现接口的开环负载生成 / 浸泡测试工具。
+//
+// Build / 编译:
+//   g++ -O2 -std=c++17 loadgen.cpp -o loadgen
+//
+// Usage / 用法:
+//   loadgen [-r rate] [-d seconds] [--mix action=1,status=4,discover=1] [--body json] [-p port] [-u udp_port]
+//           [-T timeout_ms] [-i interval_s] [-c max_inflight] [--poisson] [--json] [--hosts hosts.txt] [host ...]
+//   loadgen --serve [port] [-u udp_port] [--serve-delay ms]
+//
+// EN: Requests are started on a fixed schedule (-r per second across all hosts, Poisson gaps with --poisson)
+// EN: whether or not earlier ones have finished, so a slow device shows up as latency instead of a lower
+// EN: send rate. Latency is measured from the scheduled start. Every request uses its own non-blocking
+// EN: socket (HTTP with Connection: close, like the firmware's WebServer); one poll() loop drives them all.
+// EN: Each interval prints one CSV line per request kind to stdout (or one JSON object per line with --json);
+// EN: a JSON summary per kind is printed to stderr at the end.
+// EN: --serve runs a local stand-in with the same routes (POST /action, GET /auto_swipe/status, UDP discovery)
+// EN: that answers one HTTP request at a time with --serve-delay ms of service time, as the device does.
+// 中文: 请求按固定节拍发起（-r 为所有设备合计每秒请求数，--poisson 为泊松间隔），不等待之前的请求完成，
+// 中文: 因此设备变慢表现为延迟上升而不是发送速率下降；延迟从计划发起时刻起算。每个请求使用独立的非阻塞
+// 中文: 套接字（HTTP 使用 Connection: close，与固件的 WebServer 一致），由同一个 poll() 循环驱动。
+// 中文: 每个统计间隔按请求类型向 stdout 输出一行 CSV（--json 时每行一个 JSON 对象），结束时向 stderr 输出各类型的 JSON 汇总。
+// 中文: --serve 启动本地替身服务（POST /action、GET /auto_swipe/status、UDP 发现），与设备一样一次只处理一个
+// 中文: HTTP 请求，每个请求耗时 --serve-delay 毫秒。
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* kDiscoveryMagic = "ESP32_BLE_MOUSE_DISCOVER";
+
+// 请求类型 / Request kinds
+enum Kind { kAction = 0, kStatus, kDiscover, kKinds };
+const char* const kKindNames[kKinds] = {"action", "status", "discover"};
+
+struct Options {
+    double rate = 10;
+    double durationSec = 60;
+    int port = 80;
+    int udpPort = 48321;
+    int timeoutMs = 2000;
+    double intervalSec = 1;
+    size_t maxInflight = 256;
+    bool poisson = false;
+    bool json = false;
+    double weights[kKinds] = {1, 4, 1};
+    std::string actionBody = "{\"type\":\"click\",\"x\":10,\"y\":10}";
+    std::vector<std::string> hosts;
+    // --serve
+    bool serve = false;
+    int servePort = 8080;
+    int serveDelayMs = 20;
+};
+
+double msSince(Clock::time_point a, Clock::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+bool setNonBlocking(int fd) {
+    int fl = fcntl(fd, F_GETFL, 0);
+    return fl >= 0 && fcntl(fd, F_SETFL, fl | O_NONBLOCK) == 0;
+}
+
+bool resolve(const std::string& host, int port, int socktype, sockaddr_in& out) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = socktype;
+    addrinfo* res = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res) != 0 || !res) return false;
+    memcpy(&out, res->ai_addr, sizeof(out));
+    freeaddrinfo(res);
+    return true;
+}
+
+// --- Statistics / 统计 ---
+
+struct Bucket {
+    uint64_t sent = 0, ok = 0, errors = 0, timeouts = 0, dropped = 0;
+    std::vector<double> latMs;  // 成功请求的延迟 / latencies of successful requests
+
+    void merge(const Bucket& o) {
+        sent += o.sent;
+        ok += o.ok;
+        errors += o.errors;
+        timeouts += o.timeouts;
+        dropped += o.dropped;
+        latMs.insert(latMs.end(), o.latMs.begin(), o.latMs.end());
+    }
+};
+
+// 最近秩分位数（latMs 需已排序）/ Nearest-rank percentile (latMs must be sorted)
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0;
+    size_t rank = (size_t)std::ceil(p * sorted.size());
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+void printInterval(const Options& opt, double tSec, int kind, Bucket& b) {
+    std::sort(b.latMs.begin(), b.latMs.end());
+    double rps = b.ok / opt.intervalSec;
+    double maxMs = b.latMs.empty() ? 0 : b.latMs.back();
+    if (opt.json) {
+        printf("{\"t_s\":%.1f,\"kind\":\"%s\",\"sent\":%llu,\"ok\":%llu,\"errors\":%llu,\"timeouts\":%llu,"
+               "\"dropped\":%llu,\"ok_per_s\":%.1f,\"p50_ms\":%.2f,\"p90_ms\":%.2f,\"p99_ms\":%.2f,\"max_ms\":%.2f}\n",
+               tSec, kKindNames[kind], (unsigned long long)b.sent, (unsigned long long)b.ok,
+               (unsigned long long)b.errors, (unsigned long long)b.timeouts, (unsigned long long)b.dropped, rps,
+               percentile(b.latMs, 0.5), percentile(b.latMs, 0.9), percentile(b.latMs, 0.99), maxMs);
+    } else {
+        printf("%.1f,%s,%llu,%llu,%llu,%llu,%llu,%.1f,%.2f,%.2f,%.2f,%.2f\n", tSec, kKindNames[kind],
+               (unsigned long long)b.sent, (unsigned long long)b.ok, (unsigned long long)b.errors,
+               (unsigned long long)b.timeouts, (unsigned long long)b.dropped, rps, percentile(b.latMs, 0.5),
+               percentile(b.latMs, 0.9), percentile(b.latMs, 0.99), maxMs);
+    }
+    fflush(stdout);
+}
+
+void printSummary(int kind, Bucket& b, double wallSec, const std::map<int, uint64_t>& codes) {
+    std::sort(b.latMs.begin(), b.latMs.end());
+    double done = (double)(b.ok + b.errors + b.timeouts);
+    fprintf(stderr,
+            "{\"kind\":\"%s\",\"sent\":%llu,\"ok\":%llu,\"errors\":%llu,\"timeouts\":%llu,\"dropped\":%llu,"
+            "\"error_rate\":%.4f,\"timeout_rate\":%.4f,\"ok_per_s\":%.2f,\"p50_ms\":%.2f,\"p90_ms\":%.2f,"
+            "\"p99_ms\":%.2f,\"p999_ms\":%.2f,\"max_ms\":%.2f,\"http\":{",
+            kKindNames[kind], (unsigned long long)b.sent, (unsigned long long)b.ok, (unsigned long long)b.errors,
+            (unsigned long long)b.timeouts, (unsigned long long)b.dropped, done ? b.errors / done : 0.0,
+            done ? b.timeouts / done : 0.0, wallSec > 0 ? b.ok / wallSec : 0.0, percentile(b.latMs, 0.5),
+            percentile(b.latMs, 0.9), percentile(b.latMs, 0.99), percentile(b.latMs, 0.999),
+            b.latMs.empty() ? 0.0 : b.latMs.back());
+    bool first = true;
+    for (const auto& kv : codes) {
+        fprintf(stderr, "%s\"%d\":%llu", first ? "" : ",", kv.first, (unsigned long long)kv.second);
+        first = false;
+    }
+    fprintf(stderr, "}}\n");
+}
+
+// --- Client / 客户端 ---
+
+enum class OpState { Connecting, Sending, Reading, UdpWait };
+
+struct Op {
+    int fd = -1;
+    int kind = kAction;
+    OpState state = OpState::Connecting;
+    Clock::time_point scheduled;  // 计划发起时刻，延迟由此起算 / scheduled start, latency is measured from here
+    Clock::time_point deadline;
+    std::string out;
+    size_t outOff = 0;
+    std::string in;
+};
+
+struct Target {
+    std::string host;
+    sockaddr_in http{};
+    sockaddr_in udp{};
+};
+
+class LoadGen {
+public:
+    explicit LoadGen(const Options& opt) : opt_(opt), rng_(std::random_device{}()) {}
+
+    bool init() {
+        for (const std::string& h : opt_.hosts) {
+            Target t;
+            t.host = h;
+            if (!resolve(h, opt_.port, SOCK_STREAM, t.http) || !resolve(h, opt_.udpPort, SOCK_DGRAM, t.udp)) {
+                std::cerr << "cannot resolve " << h << "\n";
+                return false;
+            }
+            targets_.push_back(t);
+        }
+        double total = 0;
+        for (double w : opt_.weights) total += w;
+        if (total <= 0 || targets_.empty() || opt_.rate <= 0) return false;
+        for (int k = 0; k < kKinds; k++) cumWeights_[k] = (k ? cumWeights_[k - 1] : 0) + opt_.weights[k] / total;
+        return true;
+    }
+
+    int run() {
+        const auto start = Clock::now();
+        const auto stopAt = start + std::chrono::microseconds((int64_t)(opt_.durationSec * 1e6));
+        auto nextArrival = start;
+        auto nextReport = start + std::chrono::microseconds((int64_t)(opt_.intervalSec * 1e6));
+        std::uniform_real_distribution<double> uni(0.0, 1.0);
+        std::exponential_distribution<double> gap(opt_.rate);
+
+        if (!opt_.json) printf("t_s,kind,sent,ok,errors,timeouts,dropped,ok_per_s,p50_ms,p90_ms,p99_ms,max_ms\n");
+
+        size_t targetIdx = 0;
+        for (;;) {
+            auto now = Clock::now();
+            // EN: Open loop: start everything that is due, never wait for replies first.
+            // 中文: 开环：发起所有已到期的请求，从不先等回复。
+            while (nextArrival <= now && nextArrival < stopAt) {
+                double u = uni(rng_);
+                int kind = 0;
+                while (kind < kKinds - 1 && u > cumWeights_[kind]) kind++;
+                startOp(kind, targets_[targetIdx], nextArrival);
+                targetIdx = (targetIdx + 1) % targets_.size();
+                double stepSec = opt_.poisson ? gap(rng_) : 1.0 / opt_.rate;
+                nextArrival += std::chrono::microseconds((int64_t)(stepSec * 1e6));
+            }
+
+            if (now >= nextReport) {
+                double t = std::chrono::duration<double>(nextReport - start).count();
+                for (int k = 0; k < kKinds; k++) {
+                    printInterval(opt_, t, k, interval_[k]);
+                    total_[k].merge(interval_[k]);
+                    interval_[k] = Bucket();
+                }
+                nextReport += std::chrono::microseconds((int64_t)(opt_.intervalSec * 1e6));
+            }
+
+            if (now >= stopAt && ops_.empty()) break;
+
+            // EN: Sleep in poll() until the next arrival, report or timeout, whichever is first.
+            // 中文: 在 poll() 中休眠至下一次发起、输出或超时中最早的时刻。
+            auto wake = std::min(nextReport, nextArrival < stopAt ? nextArrival : stopAt + std::chrono::hours(1));
+            for (const Op& op : ops_) wake = std::min(wake, op.deadline);
+            int waitMs = (int)std::max<int64_t>(
+                0, std::chrono::duration_cast<std::chrono::milliseconds>(wake - now).count());
+            pollOnce(waitMs);
+        }
+
+        double wall = std::chrono::duration<double>(Clock::now() - start).count();
+        uint64_t ok = 0;
+        for (int k = 0; k < kKinds; k++) {
+            total_[k].merge(interval_[k]);
+            if (total_[k].sent == 0) continue;
+            printSummary(k, total_[k], wall, codes_[k]);
+            ok += total_[k].ok;
+        }
+        // EN: Errors under load are results, not tool failures; only "nothing answered" is.
+        // 中文: 负载下的错误属于测试结果而非工具失败；只有“完全无应答”才返回失败。
+        return ok > 0 ? 0 : 1;
+    }
+
+private:
+    const Options& opt_;
+    std::mt19937_64 rng_;
+    std::vector<Target> targets_;
+    double cumWeights_[kKinds] = {0};
+    std::vector<Op> ops_;
+    Bucket interval_[kKinds];
+    Bucket total_[kKinds];
+    std::map<int, uint64_t> codes_[kKinds];
+
+    void startOp(int kind, const Target& t, Clock::time_point scheduled) {
+        Bucket& b = interval_[kind];
+        b.sent++;
+        if (ops_.size() >= opt_.maxInflight) {
+            // EN: Too many in flight: count it instead of delaying the schedule.
+            // 中文: 在途请求过多：计入 dropped，而不是推迟节拍。
+            b.dropped++;
+            return;
+        }
+        Op op;
+        op.kind = kind;
+        op.scheduled = scheduled;
+        op.deadline = scheduled + std::chrono::milliseconds(opt_.timeoutMs);
+
+        if (kind == kDiscover) {
+            op.fd = socket(AF_INET, SOCK_DGRAM, 0);
+            if (op.fd < 0 || !setNonBlocking(op.fd) ||
+                sendto(op.fd, kDiscoveryMagic, strlen(kDiscoveryMagic), 0, (const sockaddr*)&t.udp, sizeof(t.udp)) < 0) {
+                fail(op, 0);
+                return;
+            }
+            op.state = OpState::UdpWait;
+            ops_.push_back(std::move(op));
+            return;
+        }
+
+        std::ostringstream req;
+        if (kind == kAction) {
+            req << "POST /action HTTP/1.1\r\nHost: " << t.host << "\r\nContent-Type: application/json\r\nContent-Length: "
+                << opt_.actionBody.size() << "\r\nConnection: close\r\n\r\n"
+                << opt_.actionBody;
+        } else {
+            req << "GET /auto_swipe/status HTTP/1.1\r\nHost: " << t.host << "\r\nConnection: close\r\n\r\n";
+        }
+        op.out = req.str();
+        op.fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (op.fd < 0 || !setNonBlocking(op.fd)) {
+            fail(op, 0);
+            return;
+        }
+        int one = 1;
+        setsockopt(op.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (connect(op.fd, (const sockaddr*)&t.http, sizeof(t.http)) != 0 && errno != EINPROGRESS) {
+            fail(op, 0);
+            return;
+        }
+        op.state = OpState::Connecting;
+        ops_.push_back(std::move(op));
+    }
+
+    void fail(Op& op, int code) {
+        interval_[op.kind].errors++;
+        codes_[op.kind][code]++;
+        if (op.fd >= 0) close(op.fd);
+        op.fd = -1;
+    }
+
+    void succeed(Op& op, int code) {
+        interval_[op.kind].ok++;
+        interval_[op.kind].latMs.push_back(msSince(op.scheduled, Clock::now()));
+        codes_[op.kind][code]++;
+        close(op.fd);
+        op.fd = -1;
+    }
+
+    // 响应结束（对端关闭）后判定结果 / Decide the result once the peer has closed
+    void finishHttp(Op& op) {
+        int code = 0;
+        if (op.in.compare(0, 9, "HTTP/1.1 ") == 0 || op.in.compare(0, 9, "HTTP/1.0 ") == 0) code = atoi(op.in.c_str() + 9);
+        if (code >= 200 && code < 300) succeed(op, code);
+        else fail(op, code);
+    }
+
+    void pollOnce(int waitMs) {
+        std::vector<pollfd> pfds;
+        pfds.reserve(ops_.size());
+        for (const Op& op : ops_) {
+            short ev = op.state == OpState::Connecting || op.state == OpState::Sending ? POLLOUT : POLLIN;
+            pfds.push_back(pollfd{op.fd, ev, 0});
+        }
+        if (poll(pfds.data(), pfds.size(), waitMs) < 0 && errno != EINTR) return;
+
+        auto now = Clock::now();
+        for (size_t i = 0; i < ops_.size(); i++) {
+            Op& op = ops_[i];
+            if (pfds[i].revents) handleEvent(op);
+            if (op.fd >= 0 && now >= op.deadline) {
+                interval_[op.kind].timeouts++;
+                close(op.fd);
+                op.fd = -1;
+            }
+        }
+        ops_.erase(std::remove_if(ops_.begin(), ops_.end(), [](const Op& op) { return op.fd < 0; }), ops_.end());
+    }
+
+    void handleEvent(Op& op) {
+        char buf[1024];
+        if (op.state == OpState::UdpWait) {
+            ssize_t n = recv(op.fd, buf, sizeof(buf), 0);
+            if (n > 0) succeed(op, 0);
+            else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) fail(op, 0);  // 如 ICMP 端口不可达 / e.g. ICMP unreachable
+            return;
+        }
+        if (op.state == OpState::Connecting) {
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(op.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            if (err != 0) {
+                fail(op, 0);
+                return;
+            }
+            op.state = OpState::Sending;
+        }
+        if (op.state == OpState::Sending) {
+            while (op.outOff < op.out.size()) {
+                ssize_t n = send(op.fd, op.out.data() + op.outOff, op.out.size() - op.outOff, MSG_NOSIGNAL);
+                if (n > 0) {
+                    op.outOff += (size_t)n;
+                } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                    return;
+                } else {
+                    fail(op, 0);
+                    return;
+                }
+            }
+            op.state = OpState::Reading;
+            return;
+        }
+        // Reading: 读到 EOF 为止（Connection: close）/ read until EOF (Connection: close)
+        for (;;) {
+            ssize_t n = recv(op.fd, buf, sizeof(buf), 0);
+            if (n > 0) {
+                if (op.in.size() < 4096) op.in.append(buf, (size_t)n);
+            } else if (n == 0) {
+                finishHttp(op);
+                return;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;
+            } else {
+                // EN: A reset after a complete status line still counts as answered.
+                // 中文: 已收到完整状态行后的连接重置仍视为已应答。
+                if (op.in.find("\r\n") != std::string::npos) finishHttp(op);
+                else fail(op, 0);
+                return;
+            }
+        }
+    }
+};
+
+// --- Stand-in server / 本地替身服务 ---
+
+struct Conn {
+    int fd = -1;
+    std::string in;
+    std::string out;
+    size_t outOff = 0;
+    bool queued = false;             // 请求已完整，等待处理 / request complete, waiting for service
+    Clock::time_point replyAt;       // 模拟处理完成时刻 / simulated service completion
+};
+
+// 解析出完整请求后生成回复；请求不完整返回 false / Build the reply once a full request is in; false if incomplete
+bool buildReply(Conn& c) {
+    size_t hdrEnd = c.in.find("\r\n\r\n");
+    if (hdrEnd == std::string::npos) return false;
+    size_t bodyLen = 0;
+    std::string lower = c.in.substr(0, hdrEnd);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    size_t cl = lower.find("content-length:");
+    if (cl != std::string::npos) bodyLen = (size_t)atol(lower.c_str() + cl + 15);
+    if (c.in.size() < hdrEnd + 4 + bodyLen) return false;
+
+    std::string line = c.in.substr(0, c.in.find("\r\n"));
+    int code = 200;
+    std::string body;
+    if (line.compare(0, 13, "POST /action ") == 0) {
+        body = "{\"status\":\"ok\",\"queue_pos\":0,\"wait_us\":0}";
+    } else if (line.compare(0, 23, "GET /auto_swipe/status ") == 0) {
+        body = "{\"running\":false,\"ble_connected\":true,\"owner\":\"idle\",\"quiet_left_ms\":0}";
+    } else {
+        code = 404;
+        body = "{\"error\":\"Not found\"}";
+    }
+    std::ostringstream out;
+    out << "HTTP/1.1 " << code << (code == 200 ? " OK" : " Not Found")
+        << "\r\nContent-Type: application/json\r\nContent-Length: " << body.size() << "\r\nConnection: close\r\n\r\n"
+        << body;
+    c.out = out.str();
+    return true;
+}
+
+int listenOn(int port, int type) {
+    int fd = socket(AF_INET, type, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0 || (type == SOCK_STREAM && listen(fd, 128) != 0) ||
+        !setNonBlocking(fd)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int serve(const Options& opt) {
+    int tcp = listenOn(opt.servePort, SOCK_STREAM);
+    int udp = listenOn(opt.udpPort, SOCK_DGRAM);
+    if (tcp < 0 || udp < 0) {
+        perror("bind");
+        return 1;
+    }
+    fprintf(stderr, "stand-in: http %d, udp %d, %d ms per request (one at a time)\n", opt.servePort, opt.udpPort,
+            opt.serveDelayMs);
+
+    std::vector<Conn> conns;
+    // EN: Like the device's WebServer, requests are served one after another: each starts when the previous ends.
+    // 中文: 与设备的 WebServer 一样按顺序处理：每个请求在上一个结束后才开始。
+    Clock::time_point busyUntil = Clock::now();
+    for (;;) {
+        std::vector<pollfd> pfds = {{tcp, POLLIN, 0}, {udp, POLLIN, 0}};
+        auto now = Clock::now();
+        int waitMs = 1000;
+        for (const Conn& c : conns) {
+            short ev = !c.out.empty() && now >= c.replyAt ? POLLOUT : (c.queued ? 0 : POLLIN);
+            pfds.push_back(pollfd{c.fd, ev, 0});
+            if (c.queued && c.replyAt > now) {
+                waitMs = std::min<int>(waitMs, (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                   c.replyAt - now).count() + 1);
+            }
+        }
+        if (poll(pfds.data(), pfds.size(), waitMs) < 0 && errno != EINTR) return 1;
+
+        if (pfds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept(tcp, nullptr, nullptr)) >= 0) {
+                setNonBlocking(fd);
+                Conn c;
+                c.fd = fd;
+                conns.push_back(std::move(c));
+            }
+        }
+        if (pfds[1].revents & POLLIN) {
+            char buf[128];
+            sockaddr_in from{};
+            socklen_t fromLen = sizeof(from);
+            ssize_t n;
+            while ((n = recvfrom(udp, buf, sizeof(buf) - 1, 0, (sockaddr*)&from, &fromLen)) > 0) {
+                buf[n] = 0;
+                if (strstr(buf, kDiscoveryMagic)) {
+                    static const char reply[] =
+                        "{\"device\":\"esp32-ble-mouse\",\"ip\":\"127.0.0.1\",\"mac\":\"00:00:00:00:00:00\","
+                        "\"version\":\"0\",\"ble\":true,\"queue\":0,\"busy\":false,\"uptime\":0}";
+                    sendto(udp, reply, sizeof(reply) - 1, 0, (sockaddr*)&from, fromLen);
+                }
+                fromLen = sizeof(from);
+            }
+        }
+
+        now = Clock::now();
+        for (size_t i = 0; i < conns.size(); i++) {
+            Conn& c = conns[i];
+            short re = pfds[i + 2].revents;
+            if (!c.queued && (re & (POLLIN | POLLHUP | POLLERR))) {
+                char buf[2048];
+                ssize_t n;
+                while ((n = recv(c.fd, buf, sizeof(buf), 0)) > 0) c.in.append(buf, (size_t)n);
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) || c.in.size() > 65536) {
+                    close(c.fd);
+                    c.fd = -1;
+                    continue;
+                }
+                if (buildReply(c)) {
+                    c.queued = true;
+                    busyUntil = std::max(busyUntil, now) + std::chrono::milliseconds(opt.serveDelayMs);
+                    c.replyAt = busyUntil;
+                }
+            }
+            if (c.queued && now >= c.replyAt) {
+                bool blocked = false;
+                while (c.outOff < c.out.size()) {
+                    ssize_t n = send(c.fd, c.out.data() + c.outOff, c.out.size() - c.outOff, MSG_NOSIGNAL);
+                    if (n <= 0) {
+                        blocked = n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+                        break;
+                    }
+                    c.outOff += (size_t)n;
+                }
+                if (!blocked) {
+                    close(c.fd);
+                    c.fd = -1;
+                }
+            }
+        }
+        conns.erase(std::remove_if(conns.begin(), conns.end(), [](const Conn& c) { return c.fd < 0; }), conns.end());
+    }
+}
+
+// --- Arguments / 参数 ---
+
+void usage() {
+    std::cerr << "usage: loadgen [-r rate] [-d seconds] [--mix action=1,status=4,discover=1] [--body json]\n"
+                 "               [-p port] [-u udp_port] [-T timeout_ms] [-i interval_s] [-c max_inflight]\n"
+                 "               [--poisson] [--json] [--hosts file] [host ...]\n"
+                 "       loadgen --serve [port] [-u udp_port] [--serve-delay ms]\n";
+}
+
+bool parseMix(const std::string& s, double* weights) {
+    for (int k = 0; k < kKinds; k++) weights[k] = 0;
+    std::istringstream in(s);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        size_t eq = item.find('=');
+        std::string name = item.substr(0, eq);
+        double w = eq == std::string::npos ? 1 : atof(item.c_str() + eq + 1);
+        int k = 0;
+        while (k < kKinds && name != kKindNames[k]) k++;
+        if (k == kKinds || w < 0) {
+            std::cerr << "unknown mix entry: " << item << "\n";
+            return false;
+        }
+        weights[k] = w;
+    }
+    return true;
+}
+
+bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        auto next = [&](const char* name) -> const char* {
+            if (i + 1 >= argc) {
+                std::cerr << "missing value for " << name << "\n";
+                return nullptr;
+            }
+            return argv[++i];
+        };
+        const char* v = nullptr;
+        if (a == "-r") { if (!(v = next("-r"))) return false; opt.rate = atof(v); }
+        else if (a == "-d") { if (!(v = next("-d"))) return false; opt.durationSec = atof(v); }
+        else if (a == "-p") { if (!(v = next("-p"))) return false; opt.port = atoi(v); }
+        else if (a == "-u") { if (!(v = next("-u"))) return false; opt.udpPort = atoi(v); }
+        else if (a == "-T") { if (!(v = next("-T"))) return false; opt.timeoutMs = std::max(1, atoi(v)); }
+        else if (a == "-i") { if (!(v = next("-i"))) return false; opt.intervalSec = std::max(0.1, atof(v)); }
+        else if (a == "-c") { if (!(v = next("-c"))) return false; opt.maxInflight = (size_t)std::max(1, atoi(v)); }
+        else if (a == "--mix") { if (!(v = next("--mix")) || !parseMix(v, opt.weights)) return false; }
+        else if (a == "--body") { if (!(v = next("--body"))) return false; opt.actionBody = v; }
+        else if (a == "--poisson") { opt.poisson = true; }
+        else if (a == "--json") { opt.json = true; }
+        else if (a == "--serve") {
+            opt.serve = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') opt.servePort = atoi(argv[++i]);
+        }
+        else if (a == "--serve-delay") { if (!(v = next("--serve-delay"))) return false; opt.serveDelayMs = std::max(0, atoi(v)); }
+        else if (a == "--hosts") {
+            if (!(v = next("--hosts"))) return false;
+            std::ifstream in(v);
+            std::string line;
+            while (std::getline(in, line)) {
+                size_t hash = line.find('#');
+                if (hash != std::string::npos) line.resize(hash);
+                std::istringstream ls(line);
+                std::string h;
+                if (ls >> h) opt.hosts.push_back(h);
+            }
+        } else if (a == "-h" || a == "--help") { return false; }
+        else opt.hosts.push_back(a);
+    }
+    return opt.serve || !opt.hosts.empty();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) {
+        usage();
+        return 2;
+    }
+    if (opt.serve) return serve(opt);
+
+    LoadGen gen(opt);
+    if (!gen.init()) {
+        usage();
+        return 2;
+    }
+    std::cerr << opt.hosts.size() << " host(s), " << opt.rate << " req/s " << (opt.poisson ? "poisson" : "fixed")
+              << ", " << opt.durationSec << " s, timeout " << opt.timeoutMs << " ms\n";
+    return gen.run();
+}
@@ -0,0 +1,106 @@
+// log_decode: turn a binary GET /log dump into text lines, using the firmware's LogEvents.def.
+// log_decode：使用固件的 LogEvents.def，把 GET /log 的二进制转储还原为文本。
+//
+// Build / 编译:
+//   g++ -O2 -std=c++17 log_decode.cpp -o log_decode
+//
+// Usage / 用法:
+//   curl -s http://<device-ip>/log -o dev.log && log_decode dev.log
+//   curl -s http://<device-ip>/log | log_decode
+//
+// EN: The dump is a series of chunks, each a 16-byte header ("ELOG", version, record size, boot, first seq, count)
+// EN: followed by `count` 16-byte little-endian records {ts_ms, id, boot, a, b} with consecutive seqs. A new chunk
+// EN: starts when records were overwritten mid-dump, and the skipped seqs are reported as a gap. Version 1 dumps
+// EN: (one header) still decode. Event names and formats are compiled in from ../../LogEvents.def, so rebuild the
+// EN: decoder whenever events are added.
+// 中文: 转储由若干段组成，每段为 16 字节文件头（"ELOG"、版本、记录大小、启动序号、首条序号、条数）加 `count` 条
+// 中文: 序号连续的 16 字节小端记录 {ts_ms, id, boot, a, b}。转储期间有记录被覆盖时另起一段，跳过的序号以缺口提示。
+// 中文: 仍可解码版本 1（单个文件头）。事件名与格式从 ../../LogEvents.def 编译进来，新增事件后需重新编译。
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+static const char* const kNames[] = {
+#define LOG_EVENT(name, fmt) #name,
+#include "../../LogEvents.def"
+#undef LOG_EVENT
+};
+static const char* const kFormats[] = {
+#define LOG_EVENT(name, fmt) fmt,
+#include "../../LogEvents.def"
+#undef LOG_EVENT
+};
+static const unsigned kEventCount = sizeof(kNames) / sizeof(kNames[0]);
+
+#pragma pack(push, 1)
+struct Header {
+    char magic[4];
+    uint8_t version;
+    uint8_t recordSize;
+    uint16_t boot;
+    uint32_t firstSeq;
+    uint32_t count;
+};
+struct Record {
+    uint32_t tsMs;
+    uint16_t id;
+    uint16_t boot;
+    int32_t a;
+    int32_t b;
+};
+#pragma pack(pop)
+
+int main(int argc, char** argv) {
+    FILE* in = stdin;
+    if (argc > 1) {
+        in = fopen(argv[1], "rb");
+        if (!in) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    Header h;
+    bool first = true;
+    uint32_t seq = 0;
+    while (fread(&h, sizeof(h), 1, in) == 1) {
+        if (memcmp(h.magic, "ELOG", 4) != 0) {
+            fprintf(stderr, first ? "not an ELOG dump\n" : "corrupt chunk header after seq %u\n", seq);
+            return 1;
+        }
+        if ((h.version != 1 && h.version != 2) || h.recordSize != sizeof(Record)) {
+            fprintf(stderr, "unsupported dump: version %u, record size %u\n", h.version, h.recordSize);
+            return 1;
+        }
+        if (first) {
+            printf("# boot %u, records from seq %u\n", h.boot, h.firstSeq);
+        } else if (h.firstSeq != seq) {
+            printf("# gap: seq %u-%u overwritten during the dump\n", seq, h.firstSeq - 1);
+        }
+        first = false;
+        seq = h.firstSeq;
+
+        Record r;
+        for (uint32_t i = 0; i < h.count; i++) {
+            if (fread(&r, sizeof(r), 1, in) != 1) {
+                fprintf(stderr, "truncated dump at seq %u\n", seq);
+                return 1;
+            }
+            printf("[Ev %u] b%u %u.%03u %-16s ", seq++, r.boot, r.tsMs / 1000, r.tsMs % 1000,
+                   r.id < kEventCount ? kNames[r.id] : "?");
+            if (r.id < kEventCount) {
+                printf(kFormats[r.id], (long)r.a, (long)r.b);
+            } else {
+                printf("event %u a=%ld b=%ld", r.id, (long)r.a, (long)r.b);
+            }
+            putchar('\n');
+        }
+    }
+    if (first) {
+        fprintf(stderr, "not an ELOG dump\n");
+        return 1;
+    }
+    if (in != stdin) fclose(in);
+    return 0;
+}
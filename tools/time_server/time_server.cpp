@@ -0,0 +1,65 @@
+// time_server: LAN stand-in time server for the firmware's TimeSync (UDP, NTP-style timestamps).
+// time_server：固件 TimeSync 使用的局域网时间服务器（UDP，NTP 式时间戳）。
+//
+// Build / 编译:
+//   g++ -O2 -std=c++17 time_server.cpp -o time_server
+//
+// Usage / 用法:
+//   time_server [port]        (default 48330)
+//
+// EN: Replies "TSYNC1 <seq> <t1> <t2> <t3>" to each "TSYNC1 <seq> <t1>" probe, where t2/t3 are the
+// EN: receive/send times in Unix epoch microseconds (CLOCK_REALTIME). Controllers should derive the
+// EN: `at` field of /action from the same clock.
+// 中文: 对每个 "TSYNC1 <seq> <t1>" 探测回复 "TSYNC1 <seq> <t1> <t2> <t3>"，t2/t3 为接收/发送时刻
+// 中文: （Unix 纪元微秒，CLOCK_REALTIME）。控制端的 /action `at` 字段应取自同一时钟。
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+static long long nowUs() {
+    timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long long)ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+int main(int argc, char** argv) {
+    int port = argc > 1 ? atoi(argv[1]) : 48330;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return 1;
+    }
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)port);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        perror("bind");
+        return 1;
+    }
+    fprintf(stderr, "time_server listening on udp/%d\n", port);
+
+    char buf[128];
+    for (;;) {
+        sockaddr_in peer{};
+        socklen_t plen = sizeof(peer);
+        ssize_t n = recvfrom(fd, buf, sizeof(buf) - 1, 0, (sockaddr*)&peer, &plen);
+        long long t2 = nowUs();
+        if (n <= 0) continue;
+        buf[n] = '\0';
+        unsigned long seq;
+        long long t1;
+        if (sscanf(buf, "TSYNC1 %lu %lld", &seq, &t1) != 2) continue;
+        char out[128];
+        long long t3 = nowUs();
+        int len = snprintf(out, sizeof(out), "TSYNC1 %lu %lld %lld %lld", seq, t1, t2, t3);
+        sendto(fd, out, (size_t)len, 0, (sockaddr*)&peer, plen);
+    }
+}
@@ -0,0 +1,132 @@
+// trace_pack: pack recorded swipe traces (CSV) into the delta/varint body accepted by POST /traces.
+// trace_pack：把录制的滑动轨迹（CSV）打包为 POST /traces 接受的差分/varint 请求体。
+//
+// Build / 编译:
+//   g++ -O2 -std=c++17 trace_pack.cpp -o trace_pack
+//
+// Usage / 用法:
+//   trace_pack traces.csv > traces.trc
+//   curl -s -H "Content-Type: application/octet-stream" --data-binary @traces.trc http://<device-ip>/traces
+//
+// EN: Input lines are `name,x,y,t_ms` (pixels, milliseconds); consecutive lines with the same name form one
+// EN: trace, blank lines and lines starting with '#' are skipped. Names are cut to 11 bytes, traces longer
+// EN: than 512 samples are evenly decimated (the last sample is kept). Output: "TRC1", then per trace
+// EN: u8 name length, name, varint count, and per sample zigzag-varint dx, zigzag-varint dy, varint dt_ms.
+// 中文: 输入行为 `name,x,y,t_ms`（像素、毫秒）；名称相同的连续行构成一条轨迹，空行与 '#' 开头的行跳过。
+// 中文: 名称截断为 11 字节，超过 512 个采样的轨迹均匀抽稀（保留最后一个采样）。输出："TRC1"，随后每条轨迹为
+// 中文: u8 名称长度、名称、varint 点数，每个采样为 zigzag varint dx、zigzag varint dy、varint dt_ms。
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const size_t kMaxPoints = 512;
+const size_t kMaxName = 11;
+
+struct Sample {
+    long x, y, t;
+};
+
+struct Trace {
+    std::string name;
+    std::vector<Sample> samples;
+};
+
+void putVarint(std::string& out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back((char)((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back((char)v);
+}
+
+uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+// 返回 false 表示该轨迹无法编码（坐标或时长越界）/ false when the trace cannot be encoded (range)
+bool encode(const Trace& tr, std::string& out) {
+    std::vector<Sample> s = tr.samples;
+    if (s.size() > kMaxPoints) {
+        std::vector<Sample> d;
+        for (size_t i = 0; i < kMaxPoints; i++) d.push_back(s[i * (s.size() - 1) / (kMaxPoints - 1)]);
+        s.swap(d);
+    }
+    const Sample& first = s.front();
+    if (s.back().t - first.t > 65535) return false;
+    for (const Sample& p : s) {
+        if (labs(p.x - first.x) > 32767 || labs(p.y - first.y) > 32767) return false;
+        if (labs(p.x) > 65534 || labs(p.y) > 65534) return false;
+    }
+
+    std::string name = tr.name.substr(0, kMaxName);
+    out.push_back((char)name.size());
+    out += name;
+    putVarint(out, (uint32_t)s.size());
+    long px = 0, py = 0, pt = first.t;
+    for (const Sample& p : s) {
+        long dt = p.t - pt;
+        if (dt < 0) dt = 0;
+        putVarint(out, zigzag((int32_t)(p.x - px)));
+        putVarint(out, zigzag((int32_t)(p.y - py)));
+        putVarint(out, (uint32_t)dt);
+        px = p.x;
+        py = p.y;
+        pt = p.t;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::ifstream file;
+    std::istream* in = &std::cin;
+    if (argc > 1) {
+        file.open(argv[1]);
+        if (!file) {
+            perror(argv[1]);
+            return 1;
+        }
+        in = &file;
+    }
+
+    std::vector<Trace> traces;
+    std::string line;
+    while (std::getline(*in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::stringstream ss(line);
+        std::string name, xs, ys, ts;
+        if (!std::getline(ss, name, ',') || !std::getline(ss, xs, ',') || !std::getline(ss, ys, ',') ||
+            !std::getline(ss, ts, ',')) {
+            continue;
+        }
+        char* end = nullptr;
+        long x = strtol(xs.c_str(), &end, 10);
+        if (end == xs.c_str()) continue;  // 表头 / header row
+        Sample s{x, strtol(ys.c_str(), nullptr, 10), strtol(ts.c_str(), nullptr, 10)};
+        if (traces.empty() || traces.back().name != name) traces.push_back(Trace{name, {}});
+        traces.back().samples.push_back(s);
+    }
+
+    std::string out = "TRC1";
+    int packed = 0, skipped = 0;
+    for (const Trace& tr : traces) {
+        if (tr.samples.size() < 2) {
+            skipped++;
+            continue;
+        }
+        if (encode(tr, out)) packed++;
+        else skipped++;
+    }
+    fwrite(out.data(), 1, out.size(), stdout);
+    fprintf(stderr, "packed %d trace(s), skipped %d, %zu bytes\n", packed, skipped, out.size());
+    return packed > 0 ? 0 : 1;
+}